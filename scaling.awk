@@ -0,0 +1,140 @@
+# Evaluates the runs of scaling.sh.
+#
+# With mode=run, the input is the temperature levels of one run (the output of
+# traceconv for a trace written with -s 0) followed by its best.log. One CSV line
+# is printed with the best objective at the given points in time, the time to
+# reach the reference value, and the objective of the final configuration. The
+# times are the sums of the Seconds of the levels, which the annealing thread
+# takes; a warning is printed, if they do not fit the wall-clock time of the run.
+#
+#   awk -F, -f scaling.awk -v mode=run -v objective=energy -v n=12 -v seed=1 \
+#       -v threads=1 -v wall=3.2 -v reference=-43.2122905 -v tolerance=1e-3 \
+#       -v times="0.1 1 10" levels.csv best.log
+#
+# With mode=summary, the input is the collected lines of the runs. The runs are
+# grouped by objective, number of points, and threads, and the share of runs
+# that reached the reference, the median time to the reference, and the mean
+# relative gap of the final configuration are printed.
+#
+# Author: Dominik Dahlem
+
+BEGIN {
+    # the distance sum is maximised, the energy minimised
+    sense = (objective == "energy") ? -1 : 1
+    count = split(times, checkpoint, " ")
+    levels = 0
+    seconds = 0.0
+    target = ""
+    points = 0
+}
+
+# the distribution of the objective of a run
+mode == "run" && FILENAME == ARGV[1] && FNR > 1 {
+    seconds += $10
+    value = (sense > 0) ? $7 : $6
+
+    if (levels == 0 || sense * (value - best) > 0) {
+        best = value
+    }
+    levels++
+
+    for (k = 1; k <= count; k++) {
+        if (seconds <= checkpoint[k]) {
+            at[k] = best
+        }
+    }
+
+    if (target == "" && reference != "" \
+        && sense * (best - reference) >= -tolerance * abs(reference)) {
+        target = seconds
+    }
+}
+
+# the best configuration of a run
+mode == "run" && FILENAME == ARGV[2] && FNR > 1 {
+    x[points] = $1
+    y[points] = $2
+    z[points] = $3
+    points++
+}
+
+mode == "summary" && FNR > 1 {
+    group = $1 "," $2 "," $4
+    if (!(group in runs)) {
+        groups[++ngroups] = group
+    }
+    runs[group]++
+    walls[group] += $5
+    if ($9 != "") {
+        gaps[group]++
+        gap[group] += $9
+    }
+
+    if ($10 != "") {
+        hits[group]++
+        ttt[group, hits[group]] = $10
+    }
+}
+
+END {
+    if (mode == "run") {
+        # the levels run within the process, which also sets up and logs the run
+        if (seconds > 1.05 * wall + 0.01 || (wall > 1.0 && seconds < 0.5 * wall)) {
+            printf "Run objective=%s n=%s seed=%s threads=%s: the levels took %g s of %g s " \
+                "wall-clock time\n", objective, n, seed, threads, seconds, wall > "/dev/stderr"
+        }
+
+        final = 0.0
+
+        for (i = 0; i < points - 1; i++) {
+            for (j = i + 1; j < points; j++) {
+                d2 = (x[i] - x[j])^2 + (y[i] - y[j])^2 + (z[i] - z[j])^2
+
+                if (objective == "energy") {
+                    final -= log(d2)
+                } else {
+                    final += sqrt(d2)
+                }
+            }
+        }
+
+        line = objective "," n "," seed "," threads "," wall "," seconds "," final "," reference
+        line = line "," ((reference != "") ? abs(final - reference) / abs(reference) : "")
+        line = line "," target
+
+        for (k = 1; k <= count; k++) {
+            line = line "," ((k in at) ? at[k] : "")
+        }
+
+        print line
+    } else if (mode == "summary") {
+        print "Objective,Points,Threads,Runs,Reached,MedianSecondsToTarget,MeanGap,MeanWallSeconds"
+
+        for (g = 1; g <= ngroups; g++) {
+            group = groups[g]
+            h = hits[group] + 0
+            median = ""
+
+            if (h > 0) {
+                # insertion sort of the times to the reference
+                for (i = 2; i <= h; i++) {
+                    v = ttt[group, i]
+                    for (j = i - 1; j >= 1 && ttt[group, j] > v; j--) {
+                        ttt[group, j + 1] = ttt[group, j]
+                    }
+                    ttt[group, j + 1] = v
+                }
+                median = (h % 2) ? ttt[group, (h + 1) / 2] \
+                    : 0.5 * (ttt[group, h / 2] + ttt[group, h / 2 + 1])
+            }
+
+            printf "%s,%d,%d,%s,%s,%g\n", group, runs[group], h, median,
+                (gaps[group] > 0) ? sprintf("%g", gap[group] / gaps[group]) : "",
+                walls[group] / runs[group]
+        }
+    }
+}
+
+function abs(v) {
+    return (v < 0) ? -v : v
+}
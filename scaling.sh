@@ -0,0 +1,130 @@
+#!/bin/sh
+#
+# End-to-end benchmark of the quality of the annealing against the wall-clock
+# time. annealPoints is run over a grid of objectives, numbers of points, seeds,
+# and thread counts, each run in a directory of its own. The best objective at
+# fixed points in time and the time to reach the known optimum (for small N)
+# are collected into results.csv, and summarised per objective, number of
+# points, and threads in summary.csv.
+#
+# Usage: ./scaling.sh [-o objectives] [-n points] [-r seeds] [-p threads]
+#                     [-i iterations] [-e tolerance] [-c seconds] [-w dir]
+#                     [-- further annealPoints options]
+#
+# Author: Dominik Dahlem
+
+OBJECTIVES="distance energy"
+POINTS="2 3 4 5 6 12"
+SEEDS="1 2 3"
+THREADS="1"
+ITERATIONS=100
+TOLERANCE=1e-3
+CHECKPOINTS="0.01 0.1 1 10"
+WORKDIR=./scaling
+BIN=$(cd "$(dirname "$0")" && pwd)
+
+usage() {
+    echo "Usage: $0 [-o objectives] [-n points] [-r seeds] [-p threads]"
+    echo "          [-i iterations] [-e tolerance] [-c seconds] [-w dir]"
+    echo "          [-- further annealPoints options]"
+    echo " -o : Objectives, distance and/or energy (\"$OBJECTIVES\")."
+    echo " -n : Numbers of points (\"$POINTS\")."
+    echo " -r : Seeds (\"$SEEDS\")."
+    echo " -p : Thread counts (\"$THREADS\")."
+    echo " -i : Number of iterations per temperature ($ITERATIONS)."
+    echo " -e : Relative tolerance of reaching the optimum ($TOLERANCE)."
+    echo " -c : Points in time of the best objective (\"$CHECKPOINTS\")."
+    echo " -w : Directory of the runs and the results ($WORKDIR)."
+    exit 1
+}
+
+# The optimum of the objective for the given number of points, if it is known.
+# The energy is the logarithmic energy sum_{i<j} log 1/|x_i - x_j|^2, and the
+# distance the sum of the Euclidean distances; both are attained by the
+# antipodes, the triangle, the tetrahedron, the triangular bipyramid, the
+# octahedron, and the icosahedron.
+reference() {
+    case "$1:$2" in
+        energy:2) echo -1.3862944 ;;
+        energy:3) echo -3.2958369 ;;
+        energy:4) echo -5.8849755 ;;
+        energy:5) echo -8.8410143 ;;
+        energy:6) echo -12.4766493 ;;
+        energy:12) echo -43.2122905 ;;
+        distance:2) echo 2.0000000 ;;
+        distance:3) echo 5.1961524 ;;
+        distance:4) echo 9.7979590 ;;
+        distance:5) echo 15.6814338 ;;
+        distance:6) echo 22.9705627 ;;
+        distance:12) echo 94.5829152 ;;
+        *) echo "" ;;
+    esac
+}
+
+while getopts "o:n:r:p:i:e:c:w:h?" opt; do
+    case $opt in
+        o) OBJECTIVES=$OPTARG ;;
+        n) POINTS=$OPTARG ;;
+        r) SEEDS=$OPTARG ;;
+        p) THREADS=$OPTARG ;;
+        i) ITERATIONS=$OPTARG ;;
+        e) TOLERANCE=$OPTARG ;;
+        c) CHECKPOINTS=$OPTARG ;;
+        w) WORKDIR=$OPTARG ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ ! -x "$BIN/annealPoints" ] || [ ! -x "$BIN/traceconv" ]; then
+    echo "Build annealPoints and traceconv with make first" >&2
+    exit 1
+fi
+
+mkdir -p "$WORKDIR" || exit 1
+RESULTS=$WORKDIR/results.csv
+
+header="Objective,Points,Seed,Threads,WallSeconds,LevelSeconds,Final,Reference,Gap,SecondsToTarget"
+for t in $CHECKPOINTS; do
+    header="$header,BestAt${t}s"
+done
+echo "$header" > "$RESULTS"
+
+for objective in $OBJECTIVES; do
+    for n in $POINTS; do
+        for threads in $THREADS; do
+            for seed in $SEEDS; do
+                run=$WORKDIR/$objective-$n-$threads-$seed
+                rm -rf "$run"
+                mkdir -p "$run/log"
+
+                start=$(date +%s.%N)
+                (cd "$run" && "$BIN/annealPoints" -o "$objective" -n "$n" -p "$threads" \
+                    -r "$seed" -i "$ITERATIONS" -s 0 -u "$@" > run.out 2>&1)
+                status=$?
+                stop=$(date +%s.%N)
+
+                logdir=$(ls -d "$run"/log/*/ 2>/dev/null | head -n 1)
+
+                if [ $status -ne 0 ] || [ -z "$logdir" ]; then
+                    echo "Run $run failed, see $run/run.out" >&2
+                    continue
+                fi
+
+                "$BIN/traceconv" "$logdir/sim.trace" "$run/levels.csv" || continue
+
+                awk -F, -f "$BIN/scaling.awk" -v mode=run -v objective="$objective" \
+                    -v n="$n" -v seed="$seed" -v threads="$threads" \
+                    -v wall="$(echo "$start $stop" | awk '{ print $2 - $1 }')" \
+                    -v reference="$(reference "$objective" "$n")" \
+                    -v tolerance="$TOLERANCE" -v times="$CHECKPOINTS" \
+                    "$run/levels.csv" "$logdir/best.log" >> "$RESULTS"
+
+                echo "$objective n=$n threads=$threads seed=$seed done" >&2
+            done
+        done
+    done
+done
+
+awk -F, -f "$BIN/scaling.awk" -v mode=summary "$RESULTS" > "$WORKDIR/summary.csv"
+cat "$WORKDIR/summary.csv"
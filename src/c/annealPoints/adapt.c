@@ -0,0 +1,123 @@
+/**
+ * This module controls the step size of the random walk. The fixed schedules shrink the step
+ * with the temperature but ignore how many proposals are actually accepted, so at low
+ * temperatures almost every proposal is rejected. Instead, the step size is multiplied by
+ * exp(ADAPT_GAIN * (ratio - target)) at the end of every temperature level, where ratio is the
+ * acceptance ratio of the level. Too many rejections shrink the step, too many acceptances grow
+ * it.
+ *
+ * A step size of 0 marks a step size that has not been tuned yet, in which case the one of the
+ * fixed schedule is used.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdlib.h>
+
+#include "adapt.h"
+
+
+/**
+ * The state of the controller.
+ */
+struct adapt_t {
+    double target; /** the target acceptance ratio */
+    double *scales; /** the step sizes */
+    int count; /** number of step sizes (1 for a shared one) */
+};
+
+
+/**
+ * Create the controller.
+ *
+ * @param const double the target acceptance ratio in (0, 1)
+ * @param const int number of step sizes (1 for a step size shared by all points)
+ * @return struct adapt_t* the controller or NULL, if the memory could not be allocated
+ */
+struct adapt_t *adapt_create(const double target, const int count)
+{
+    struct adapt_t *adapt = (struct adapt_t *) malloc(sizeof(struct adapt_t));
+
+    if (adapt == NULL) {
+        return NULL;
+    }
+
+    adapt->scales = (double *) calloc((size_t) count, sizeof(double));
+
+    if (adapt->scales == NULL) {
+        free(adapt);
+        return NULL;
+    }
+
+    adapt->target = target;
+    adapt->count = count;
+
+    return adapt;
+}
+
+/**
+ * Destroy the controller.
+ *
+ * @param struct adapt_t* the controller (may be NULL)
+ */
+void adapt_destroy(struct adapt_t *adapt)
+{
+    if (adapt != NULL) {
+        free(adapt->scales);
+        free(adapt);
+    }
+}
+
+/**
+ * @param const struct adapt_t *const the controller
+ * @return int number of step sizes
+ */
+int adapt_count(const struct adapt_t *const adapt)
+{
+    return adapt->count;
+}
+
+/**
+ * @param struct adapt_t *const the controller
+ * @return double* the step sizes, to be saved in and restored from checkpoints
+ */
+double *adapt_scales(struct adapt_t *const adapt)
+{
+    return adapt->scales;
+}
+
+/**
+ * The step size of a point.
+ *
+ * @param const struct adapt_t *const the controller
+ * @param const int the index of the point
+ * @param const double the step size of the fixed schedule
+ * @return the tuned step size or the one of the fixed schedule, if it is not tuned yet
+ */
+double adapt_scale(const struct adapt_t *const adapt, const int index, const double initial)
+{
+    double scale = adapt->scales[(adapt->count == 1) ? 0 : index];
+
+    return (scale > 0.0) ? scale : initial;
+}
+
+/**
+ * Tune the step size of a point at the end of a temperature level.
+ *
+ * @param struct adapt_t *const the controller
+ * @param const int the index of the point
+ * @param const double the step size used during the level
+ * @param const int number of accepted proposals of the level
+ * @param const int number of proposals of the level
+ */
+void adapt_update(struct adapt_t *const adapt, const int index, const double scale,
+                  const int accepted, const int proposals)
+{
+    double ratio = (proposals > 0) ? (double) accepted / (double) proposals : adapt->target;
+    double tuned = scale * exp(ADAPT_GAIN * (ratio - adapt->target));
+
+    tuned = (tuned < ADAPT_MIN) ? ADAPT_MIN : tuned;
+    tuned = (tuned > ADAPT_MAX) ? ADAPT_MAX : tuned;
+
+    adapt->scales[(adapt->count == 1) ? 0 : index] = tuned;
+}
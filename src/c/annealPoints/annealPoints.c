@@ -10,34 +10,33 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <getopt.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/resource.h>
 
+#include "batch.h"
+#include "checkpoint.h"
 #include "global.h"
-#include "sphere.h"
 #include "logging.h"
-#include "sa.h"
+#include "output.h"
+#include "perf.h"
+#include "sasphere.h"
+#include "vector.h"
+#include "warm.h"
+#include "workspace.h"
 
 
 /**
  * @name Application settings
  */
 //@{
-/**
- * Number of points to be distributed
- */
-#define POINTS 50
-
 /**
  * Coefficient for the variance of the random walk. Set to 1 to cover the whole
  * circumference of a sphere. <1 to cover only a fraction of the circumference.
  */
 #define DELTA_MOVE 1.0
 
-/**
- * Default random seed.
- */
-#define RANDOM_SEED 751339078
-
 /**
  * Boolean: True.
  */
@@ -47,12 +46,68 @@
  * Boolean: False.
  */
 #define FALSE 0
+
+/**
+ * Maximum number of command-line arguments of a job in a manifest.
+ */
+#define MANIFEST_ARGUMENTS 64
 //@}
 
 /**
  * getopt configuration of the command-line parameters. All command-line arguments are optional.
  */
-static const char *cl_arguments = "uh?r:t:i:d:n:";
+static const char *cl_arguments = "uElh?r:t:i:d:n:p:m:o:c:b:a:s:A:";
+
+/**
+ * getopt_long configuration of the long command-line parameters.
+ */
+static const struct option cl_long_arguments[] = {
+    {"batch", required_argument, NULL, 'M'},
+    {"checkpoint", required_argument, NULL, 'C'},
+    {"from", required_argument, NULL, 'F'},
+    {"initial-acceptance", required_argument, NULL, 'X'},
+    {"jobs", required_argument, NULL, 'W'},
+    {"per-point", no_argument, NULL, 'P'},
+    {"patience", required_argument, NULL, 'K'},
+    {"plateau", required_argument, NULL, 'L'},
+    {"polish", required_argument, NULL, 'G'},
+    {"schedule", required_argument, NULL, 'S'},
+    {"speculative", required_argument, NULL, 'B'},
+    {"tries", required_argument, NULL, 'T'},
+    {"resume", required_argument, NULL, 'R'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+};
+
+/**
+ * The log directory of the run to be resumed, or NULL.
+ */
+static const char *resume_dir = NULL;
+
+/**
+ * The configuration the run starts from, or NULL.
+ */
+static const char *from_file = NULL;
+
+/**
+ * Flag indicating that the initial temperature is given.
+ */
+static int temperature_given = FALSE;
+
+/**
+ * The manifest of the batch to be run, or NULL.
+ */
+static const char *batch_manifest = NULL;
+
+/**
+ * Number of jobs of a batch run at the same time (0 for the number of processors).
+ */
+static int batch_workers = 0;
+
+/**
+ * The parameters of the application.
+ */
+static struct globalArgs_t globalArgs;
 
 
 /**
@@ -61,11 +116,41 @@ static const char *cl_arguments = "uh?r:t:i:d:n:";
 void displayHelp()
 {
     printf("annealPoints - Uniformly distribute points on a sphere.\n");
+    printf(" -A : Target acceptance ratio of the adaptive step size (0 for the fixed schedule).\n");
+    printf(" -a : Accuracy target of the tree evaluation (tunes the opening angle).\n");
+    printf(" -b : Opening angle of the tree evaluation (0 for the exact evaluation).\n");
+    printf(" --batch : Run the jobs of the given manifest, one line of options per job.\n");
+    printf(" --checkpoint : Seconds between two checkpoints (0 for no checkpoints).\n");
+    printf(" -c : Cutoff radius of the approximate energy in multiples of the mean spacing.\n");
     printf(" -d : Damping factor for the annealing process.\n");
+    printf(" -E : Report the error of the approximate energy.\n");
+    printf(" --from : Start from the configuration of the given best.log or checkpoint, dropping\n"
+           "      or adding points to reach -n (-t defaults to %.1f).\n", WARM_TEMPERATURE);
     printf(" -i : Number of iterations.\n");
+    printf(" --initial-acceptance : Estimate the initial temperature for this acceptance ratio of\n"
+           "      worsening moves (0 to use -t).\n");
+    printf(" --jobs : Number of jobs of a batch run at the same time (default: the number of\n"
+           "      processors).\n");
+    printf(" -l : Block instead of dropping trace records, if the log writer falls behind.\n");
+    printf(" -m : Number of replicas for parallel tempering (distance and energy only).\n");
     printf(" -n : Number of Points.\n");
+    printf(" -o : Objective (distance, closeness, or energy).\n");
+    printf(" -p : Number of threads.\n");
+    printf(" --patience : Stop after that many levels without improvement (0 to run until the\n"
+           "      minimum temperature).\n");
+    printf(" --per-point : Adapt the step size of every point separately.\n");
+    printf(" --plateau : Relative improvement below which a level counts as without improvement.\n");
+    printf(" --polish : Polish the best configuration by at most that many iterations of a\n"
+           "      gradient descent (0 for none).\n");
     printf(" -r : Seed for the random number generator.\n");
+    printf(" --resume : Resume the run from the checkpoint in the given log directory.\n");
+    printf(" --schedule : Cooling schedule (geometric, logarithmic, adaptive, or reheat).\n");
+    printf(" --speculative : Number of distinct points proposed and scored in parallel per round\n"
+           "      (1 for sequential proposals).\n");
+    printf(" -s : Trace every s-th proposal (0 to trace aggregates per temperature).\n");
     printf(" -t : Initial value for the temperature.\n");
+    printf(" --tries : Number of candidates of a multiple-try Metropolis proposal (1 for a single\n"
+           "      random walk).\n");
     printf(" -u : Flag to indicate uniform initial configuration.\n");
     printf(" -? : This help message.\n");
     printf(" -h : This help message.\n");
@@ -73,48 +158,127 @@ void displayHelp()
     exit(EXIT_SUCCESS);
 }
 
-/**
- * Initialise the global parameters.
- */
-void init()
-{
-    globalArgs.seed = (long) RANDOM_SEED;
-    globalArgs.uniform = FALSE;
-    globalArgs.temp = T_INITIAL;
-    globalArgs.iter = T_ITERATION;
-    globalArgs.damping = T_DAMPING;
-    globalArgs.n = POINTS;
-}
-
 /**
  * Process the command-line arguments passed into the application.
  *
  * @param int number of arguments
  * @param char** pointer to the character array representing the command-line parameters
+ * @param struct globalArgs_t *const the parameters the arguments are written into
  */
-void process_cl(int argc, char **argv)
+void process_cl(int argc, char **argv, struct globalArgs_t *const args)
 {
     int opt = 0;
-    opt = getopt(argc, argv, cl_arguments);
+
+    /* (GNU) start the scan from the first argument, also for the jobs of a manifest */
+    optind = 0;
+    opt = getopt_long(argc, argv, cl_arguments, cl_long_arguments, NULL);
     while (opt != -1) {
         switch (opt) {
+            case 'C':
+                args->checkpoint = atof(optarg);
+                break;
+            case 'X':
+                args->initialAcceptance = atof(optarg);
+                break;
+            case 'K':
+                args->patience = atoi(optarg);
+                break;
+            case 'L':
+                args->plateau = atof(optarg);
+                break;
+            case 'G':
+                args->polish = atoi(optarg);
+                break;
+            case 'T':
+                args->tries = atoi(optarg);
+                break;
+            case 'B':
+                args->speculative = atoi(optarg);
+                break;
+            case 'P':
+                args->perPoint = TRUE;
+                break;
+            case 'S':
+                if (strcmp(optarg, "geometric") == 0) {
+                    args->schedule = SCHEDULE_GEOMETRIC;
+                } else if (strcmp(optarg, "logarithmic") == 0) {
+                    args->schedule = SCHEDULE_LOGARITHMIC;
+                } else if (strcmp(optarg, "adaptive") == 0) {
+                    args->schedule = SCHEDULE_ADAPTIVE;
+                } else if (strcmp(optarg, "reheat") == 0) {
+                    args->schedule = SCHEDULE_REHEAT;
+                } else {
+                    displayHelp();
+                }
+                break;
+            case 'R':
+                resume_dir = optarg;
+                break;
+            case 'F':
+                from_file = optarg;
+                break;
+            case 'M':
+                batch_manifest = optarg;
+                break;
+            case 'W':
+                batch_workers = atoi(optarg);
+                break;
+            case 'A':
+                args->acceptance = atof(optarg);
+                break;
+            case 'a':
+                args->accuracy = atof(optarg);
+                break;
+            case 'b':
+                args->theta = atof(optarg);
+                break;
+            case 'c':
+                args->cutoff = atof(optarg);
+                break;
+            case 'E':
+                args->reportError = TRUE;
+                break;
             case 'd':
-                globalArgs.damping = atof(optarg);
+                args->damping = atof(optarg);
                 break;
             case 'i':
-                globalArgs.iter = atoi(optarg);
+                args->iter = atoi(optarg);
+                break;
+            case 'l':
+                args->block = TRUE;
+                break;
+            case 'm':
+                args->replicas = atoi(optarg);
                 break;
             case 'n':
-                globalArgs.n = atoi(optarg);
+                args->n = atoi(optarg);
+                break;
+            case 'o':
+                if (strcmp(optarg, "distance") == 0) {
+                    args->objective = OBJECTIVE_DISTANCE;
+                } else if (strcmp(optarg, "closeness") == 0) {
+                    args->objective = OBJECTIVE_CLOSENESS;
+                } else if (strcmp(optarg, "energy") == 0) {
+                    args->objective = OBJECTIVE_ENERGY;
+                } else {
+                    displayHelp();
+                }
+                break;
+            case 'p':
+                args->threads = atoi(optarg);
                 break;
             case 'r':
-                globalArgs.seed = atol(optarg);
+                args->seed = atol(optarg);
+                break;
+            case 's':
+                args->sampling = atoi(optarg);
                 break;
             case 't':
-                globalArgs.temp = atof(optarg);
+                args->temp = atof(optarg);
+                temperature_given = TRUE;
                 break;
             case 'u':
-                globalArgs.uniform = TRUE;
+                args->uniform = TRUE;
                 break;
             case 'h':
             case '?':
@@ -123,10 +287,215 @@ void process_cl(int argc, char **argv)
             default:
                  break;
         }
-        opt = getopt(argc, argv, cl_arguments);
+        opt = getopt_long(argc, argv, cl_arguments, cl_long_arguments, NULL);
+    }
+}
+
+/**
+ * A run starting from a given configuration starts at a low temperature, unless one is given.
+ *
+ * @param struct globalArgs_t *const the parameters of the run
+ */
+static void warmTemperature(struct globalArgs_t *const args)
+{
+    if (from_file != NULL && !temperature_given) {
+        args->temp = WARM_TEMPERATURE;
     }
 }
 
+/**
+ * Free the jobs of a manifest.
+ *
+ * @param struct batch_job_t* the jobs (may be NULL)
+ * @param const int number of jobs
+ */
+static void freeJobs(struct batch_job_t *jobs, const int count)
+{
+    int j = 0;
+
+    for (j = 0; jobs != NULL && j < count; j++) {
+        free(jobs[j].from);
+    }
+
+    free(jobs);
+}
+
+/**
+ * Read the jobs of a manifest. Every line holds the command-line options of one job, which
+ * override the ones given on the command-line. Empty lines and lines starting with # are
+ * skipped.
+ *
+ * @param const char *const the manifest
+ * @param const struct globalArgs_t *const the parameters given on the command-line
+ * @param int *const number of jobs
+ * @return struct batch_job_t* the jobs (to be freed with freeJobs) or NULL, if the manifest could
+ *         not be read or holds no jobs
+ */
+static struct batch_job_t *readManifest(const char *const manifest,
+                                        const struct globalArgs_t *const defaults,
+                                        int *const count)
+{
+    FILE *file = fopen(manifest, "r");
+    struct batch_job_t *jobs = NULL;
+    struct batch_job_t *grown;
+    const char *from = from_file;
+    const int temperature = temperature_given;
+    char *argv[MANIFEST_ARGUMENTS + 1];
+    char *line = NULL;
+    char *token, *save;
+    size_t size = 0;
+    int capacity = 0;
+    int argc = 0;
+    int number = 0;
+    int status = SUCCESS;
+
+    *count = 0;
+
+    if (file == NULL) {
+        fprintf(stderr, "Could not open the manifest %s\n", manifest);
+        return NULL;
+    }
+
+    while (status == SUCCESS && getline(&line, &size, file) != -1) {
+        number++;
+        argv[0] = "annealPoints";
+        argc = 1;
+        token = strtok_r(line, " \t\r\n", &save);
+
+        while (token != NULL && argc < MANIFEST_ARGUMENTS) {
+            argv[argc++] = token;
+            token = strtok_r(NULL, " \t\r\n", &save);
+        }
+
+        argv[argc] = NULL;
+
+        if (argc == 1 || argv[1][0] == '#') {
+            continue;
+        }
+
+        if (token != NULL) {
+            fprintf(stderr, "Line %d of %s has more than %d arguments\n", number, manifest,
+                    MANIFEST_ARGUMENTS - 1);
+            status = FAIL;
+            break;
+        }
+
+        if (*count == capacity) {
+            capacity = 2 * capacity + 16;
+            grown = (struct batch_job_t *) realloc(jobs, capacity * sizeof(struct batch_job_t));
+
+            if (grown == NULL) {
+                fprintf(stderr, "Could not allocate %d jobs\n", capacity);
+                status = FAIL;
+                break;
+            }
+
+            jobs = grown;
+        }
+
+        /* the options of a line apply to its job only */
+        from_file = from;
+        temperature_given = temperature;
+
+        jobs[*count].args = *defaults;
+        process_cl(argc, argv, &jobs[*count].args);
+        warmTemperature(&jobs[*count].args);
+        jobs[*count].from = (from_file != NULL) ? strdup(from_file) : NULL;
+        (*count)++;
+
+        if (resume_dir != NULL || batch_manifest != manifest) {
+            fprintf(stderr, "Line %d of %s: a job cannot resume a run or run a batch\n", number,
+                    manifest);
+            status = FAIL;
+        } else if (from_file != NULL && jobs[*count - 1].from == NULL) {
+            fprintf(stderr, "Could not allocate the name of %s\n", from_file);
+            status = FAIL;
+        }
+    }
+
+    if (status == SUCCESS && *count == 0) {
+        fprintf(stderr, "The manifest %s holds no jobs\n", manifest);
+        status = FAIL;
+    }
+
+    free(line);
+    fclose(file);
+
+    if (status != SUCCESS) {
+        freeJobs(jobs, *count);
+        return NULL;
+    }
+
+    return jobs;
+}
+
+/**
+ * Run the jobs of the manifest.
+ *
+ * @return the return code of the application.
+ */
+static int runBatch()
+{
+    struct batch_job_t *jobs;
+    int count = 0;
+    int status = FAIL;
+
+    if (resume_dir != NULL) {
+        fprintf(stderr, "A batch cannot resume a run\n");
+        return EXIT_FAILURE;
+    }
+
+    jobs = readManifest(batch_manifest, &globalArgs, &count);
+
+    if (jobs == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    status = batch_run(jobs, count, (batch_workers > 0) ? batch_workers
+                       : (int) sysconf(_SC_NPROCESSORS_ONLN));
+    freeJobs(jobs, count);
+
+    return (status == SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Log the parameters and the initial configuration of the run.
+ *
+ * @param void* the log files
+ * @param const struct globalArgs_t* the parameters of the run
+ * @param const struct vector_t* the initial configuration
+ */
+static void logStart(void *arg, const struct globalArgs_t *args, const struct vector_t *initial)
+{
+    struct logging_t *log = (struct logging_t *) arg;
+    int k = 0;
+
+    logging_logParam(log, args->seed, args->iter, args->n, args->temp, args->damping,
+                     args->uniform, args->initialAcceptance);
+
+    for (k = 0; k < args->n; k++) {
+        logging_logInitial(log, (initial + k)->x, (initial + k)->y, (initial + k)->z);
+    }
+}
+
+/**
+ * Log a proposal into the trace.
+ *
+ * @param void* the log files
+ * @param long the iteration
+ * @param double the objective
+ * @param double the change of the objective
+ * @param double the temperature
+ * @param double the variance of the random walk
+ * @param int flag indicating whether the proposal was accepted
+ */
+static void logProgress(void *arg, long iteration, double objective, double delta,
+                        double temperature, double variance, int accepted)
+{
+    logging_logSim((struct logging_t *) arg, iteration, objective, delta, temperature, variance,
+                   accepted);
+}
+
 /**
  * The main function.
  *
@@ -137,44 +506,119 @@ void process_cl(int argc, char **argv)
 int main(int argc, char** argv)
 {
     struct vector_t *points;
+    struct sasphere_t *sasphere;
+    struct logging_t *log;
+    struct output_t output;
+    struct rusage usage;
+    struct checkpoint_t checkpoint;
+    struct checkpoint_t *resume = NULL;
+    struct warm_t warm;
+    int status = FAIL;
+    int n = 0;
     int k = 0;
 
     /* initialise the command line parameters */
-    init();
-    process_cl(argc, argv);
+    sasphere_defaults(&globalArgs);
+    process_cl(argc, argv, &globalArgs);
+    warmTemperature(&globalArgs);
+
+    /* a batch runs the jobs of its manifest instead */
+    if (batch_manifest != NULL) {
+        return runBatch();
+    }
+
+    /* a resumed run takes its parameters from the checkpoint */
+    if (resume_dir != NULL) {
+        if (checkpoint_load(resume_dir, &checkpoint) == FAIL) {
+            exit(EXIT_FAILURE);
+        }
 
-    /* allocate memory for the points on the sphere */
-    points = (struct vector_t *) malloc(globalArgs.n * sizeof(struct vector_t));
-    srand48(globalArgs.seed);
+        resume = &checkpoint;
+    }
+
+    /* a new run may start from a given configuration */
+    if (from_file != NULL) {
+        if (resume != NULL) {
+            fprintf(stderr, "A resumed run cannot start from another configuration\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (warm_load(from_file, &warm) == FAIL) {
+            exit(EXIT_FAILURE);
+        }
 
-    /* select the method to set up the initial configuration */
-    if (globalArgs.uniform == TRUE) {
-        sphere_initialiseUniformPoints(&points[0], globalArgs.n);
-    } else {
-        sphere_initialiseCluster(&points[0], globalArgs.n);
+        fprintf(stderr, "Starting from the %d points of %s\n", warm.n, from_file);
+    }
+
+    if (globalArgs.replicas > 1 && globalArgs.objective == OBJECTIVE_CLOSENESS) {
+        fprintf(stderr, "Parallel tempering (-m) optimises the distance or the energy, not the "
+                "closeness\n");
+        exit(EXIT_FAILURE);
+    }
+
+    n = (resume != NULL) ? resume->args.n : globalArgs.n;
+
+    /* the best configuration is returned in here */
+    points = (struct vector_t *) malloc(n * sizeof(struct vector_t));
+
+    if (points == NULL) {
+        fprintf(stderr, "Could not allocate the configuration of %d points\n", n);
+        exit(EXIT_FAILURE);
     }
 
     /* open the log files */
-    if (logging_open() == FAIL) {
+    log = logging_open(globalArgs.sampling, globalArgs.block);
+
+    if (log == NULL) {
         exit(EXIT_FAILURE);
     }
 
-    logging_logParam(globalArgs.seed, globalArgs.iter, globalArgs.n, globalArgs.temp,
-                     globalArgs.damping, globalArgs.uniform);
+    output.start = logStart;
+    output.progress = logProgress;
+    output.checkpoints = logging_directory(log);
+    output.arg = log;
+    output.perf = PERF_CREATE();
+
+    sasphere = sasphere_create(&globalArgs, &output);
 
-    /* log the initial configuration */
-    for (k = 0; k < globalArgs.n; k++) {
-        logging_logInitial((points + k)->x,
-                           (points + k)->y,
-                           (points + k)->z);
+    if (sasphere == NULL) {
+        fprintf(stderr, "Could not allocate the context of the run\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (from_file != NULL) {
+        sasphere_warm(sasphere, &warm);
     }
 
     /* start the simulation */
-    sa_distance(&points[0], &globalArgs);
+    status = sasphere_run(sasphere, resume, &points[0]);
+
+    PERF_REPORT(output.perf, logging_directory(log));
+    PERF_DESTROY(output.perf);
+
+    if (status == SUCCESS) {
+        for (k = 0; k < n; k++) {
+            logging_logBest(log, (points + k)->x, (points + k)->y, (points + k)->z);
+        }
+    }
+
+    /* the configurations come from the workspace, the rest of the memory is in the resident set */
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "Workspace peak %.1f MiB (%.1f MiB reserved), peak resident set %.1f MiB\n",
+            workspace_peak(sasphere_workspace(sasphere)) / 1048576.0,
+            workspace_reserved(sasphere_workspace(sasphere)) / 1048576.0,
+            usage.ru_maxrss / 1024.0);
 
     /* clean up everything */
-    logging_close();
+    if (resume != NULL) {
+        checkpoint_release(resume);
+    }
+    if (from_file != NULL) {
+        warm_release(&warm);
+    }
+    logging_close(log);
+    sasphere_destroy(sasphere);
     free(points);
 
-    return 0;
+    return (status == SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
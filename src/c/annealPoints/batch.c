@@ -0,0 +1,296 @@
+/**
+ * This module runs a batch of independent annealing jobs in one process. The jobs are handed
+ * out to the workers of a thread pool, each of which runs one job at a time on a context of its
+ * own. A worker claims the next job as soon as it is done with the previous one, so that jobs of
+ * different sizes keep all workers busy.
+ *
+ * The k-th job with a given seed draws from the generator of the seed jumped ahead by k times
+ * 2^192 steps. Jobs with different seeds therefore run exactly like annealPoints with the same
+ * parameters, and jobs with the same seed never share random numbers. A job starting from a
+ * configuration loads it itself, so that the workers read the configurations in parallel.
+ *
+ * All jobs are written into one log directory. batch.log indexes the jobs: one line per job with
+ * its parameters, the objective of its best configuration, its status, its wall-clock time, and
+ * the byte offset of its best configuration in best.log, which holds the best configurations of
+ * all jobs. A job is written as soon as all jobs before it are done, so the files are in the
+ * order of the batch and do not depend on the scheduling.
+ *
+ * @author Dominik Dahlem
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "eval.h"
+#include "global.h"
+#include "logging.h"
+#include "output.h"
+#include "perf.h"
+#include "points.h"
+#include "pool.h"
+#include "rng.h"
+#include "sasphere.h"
+#include "vector.h"
+#include "warm.h"
+
+
+/**
+ * A job of the batch.
+ */
+struct job_t {
+    struct globalArgs_t args; /** the parameters of the job, with the estimated temperature */
+    struct rng_t rng; /** the random number generator of the job */
+    const char *from; /** the configuration the job starts from (NULL for a random one) */
+    struct vector_t *points; /** the best configuration, until it is written */
+    double best; /** the objective of the best configuration */
+    double seconds; /** the wall-clock time of the job */
+    int status; /** SUCCESS, or FAIL if the job could not be carried out */
+    int done; /** flag indicating that the job is done */
+};
+
+/**
+ * The state of a batch.
+ */
+struct batch_t {
+    struct job_t *jobs; /** the jobs */
+    int count; /** number of jobs */
+    int next; /** the next job to be written */
+    FILE *index; /** the index of the jobs */
+    FILE *best; /** the best configurations of the jobs */
+    pthread_mutex_t lock; /** protects the files and the fields above */
+};
+
+/**
+ * The names of the objectives.
+ */
+static const char *const objectives[] = {"distance", "closeness", "energy"};
+
+
+/**
+ * Keep the parameters a job starts with, which include an estimated initial temperature.
+ *
+ * @param void* the job
+ * @param const struct globalArgs_t* the parameters of the job
+ * @param const struct vector_t* the initial configuration
+ */
+static void started(void *arg, const struct globalArgs_t *args, const struct vector_t *initial)
+{
+    ((struct job_t *) arg)->args = *args;
+    (void) initial;
+}
+
+/**
+ * The objective of the best configuration of a job. The closeness is reported as the sum of
+ * the distances.
+ *
+ * @param const struct job_t *const the job
+ * @return the objective, or 0 if the point store could not be allocated
+ */
+static double objective(const struct job_t *const job)
+{
+    struct points_t store;
+    double value = 0.0;
+
+    if (points_alloc(&store, job->args.n) == FAIL) {
+        return value;
+    }
+
+    points_fromVectors(&store, &job->points[0]);
+    value = (job->args.objective == OBJECTIVE_ENERGY) ? eval_energy(NULL, &store)
+        : eval_distance(NULL, &store);
+    points_free(&store);
+
+    return value;
+}
+
+/**
+ * Write a job into the index and its best configuration.
+ *
+ * @param struct batch_t *const the batch
+ * @param const int the job
+ */
+static void writeJob(struct batch_t *const batch, const int j)
+{
+    const struct job_t *const job = &batch->jobs[j];
+    long offset = ftell(batch->best);
+    int k = 0;
+
+    if (job->status == SUCCESS) {
+        for (k = 0; k < job->args.n; k++) {
+            fprintf(batch->best, "%d,%f,%f,%f\n",
+                    j, (job->points + k)->x, (job->points + k)->y, (job->points + k)->z);
+        }
+    }
+
+    fprintf(batch->index, "%d,%ld,%d,%d,%f,%f,%d,%f,%s,%f,%s,%.3f,%ld\n",
+            j, job->args.seed, job->args.iter, job->args.n, job->args.temp, job->args.damping,
+            job->args.uniform, job->args.initialAcceptance, objectives[job->args.objective],
+            job->best, (job->status == SUCCESS) ? "ok" : "failed", job->seconds, offset);
+}
+
+/**
+ * Carry out a job, and write the jobs that are done in the order of the batch.
+ *
+ * @param void* the batch
+ * @param int the job
+ */
+static void runJob(void *arg, int task)
+{
+    struct batch_t *batch = (struct batch_t *) arg;
+    struct job_t *job = &batch->jobs[task];
+    struct output_t output = {started, NULL, NULL, job, PERF_CREATE()};
+    struct sasphere_t *sasphere;
+    struct warm_t warm;
+    struct timespec start, stop;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    job->status = FAIL;
+    job->points = (struct vector_t *) malloc(job->args.n * sizeof(struct vector_t));
+    sasphere = sasphere_create(&job->args, &output);
+
+    if (job->points != NULL && sasphere != NULL
+        && (job->from == NULL || warm_load(job->from, &warm) == SUCCESS)) {
+        sasphere_seed(sasphere, &job->rng);
+        sasphere_warm(sasphere, (job->from != NULL) ? &warm : NULL);
+        job->status = sasphere_run(sasphere, NULL, &job->points[0]);
+
+        if (job->from != NULL) {
+            warm_release(&warm);
+        }
+    }
+
+    sasphere_destroy(sasphere);
+    job->best = (job->status == SUCCESS) ? objective(job) : 0.0;
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    job->seconds = (double) (stop.tv_sec - start.tv_sec)
+        + 1e-9 * (double) (stop.tv_nsec - start.tv_nsec);
+
+    fprintf(stderr, "Job %d: %s of %d points %s, best %f in %.2f s\n", task,
+            objectives[job->args.objective], job->args.n,
+            (job->status == SUCCESS) ? "done" : "failed", job->best, job->seconds);
+    PERF_REPORT(output.perf, NULL);
+    PERF_DESTROY(output.perf);
+
+    pthread_mutex_lock(&batch->lock);
+    job->done = 1;
+
+    while (batch->next < batch->count && batch->jobs[batch->next].done) {
+        writeJob(batch, batch->next);
+        free(batch->jobs[batch->next].points);
+        batch->jobs[batch->next].points = NULL;
+        batch->next++;
+    }
+
+    pthread_mutex_unlock(&batch->lock);
+}
+
+/**
+ * Open a file of the batch in its log directory.
+ *
+ * @param const char *const the directory
+ * @param const char *const the name of the file
+ * @return FILE* the file or NULL, if it could not be opened
+ */
+static FILE *openFile(const char *const dir, const char *const name)
+{
+    size_t size = strlen(dir) + strlen(name) + 2;
+    char *path = (char *) malloc(size * sizeof(char));
+    FILE *file = NULL;
+
+    if (path != NULL) {
+        snprintf(path, size, "%s/%s", dir, name);
+        file = fopen(path, "w");
+        free(path);
+    }
+
+    if (file != NULL) {
+        setvbuf(file, NULL, _IOFBF, LOGGING_BUFFER);
+    }
+
+    return file;
+}
+
+/**
+ * Run a batch of jobs in a new log directory.
+ *
+ * @param const struct batch_job_t *const the jobs
+ * @param const int number of jobs
+ * @param const int number of jobs run at the same time
+ * @return int SUCCESS, or FAIL if the log directory could not be created or any job failed
+ */
+int batch_run(const struct batch_job_t *const jobs, const int count, const int workers)
+{
+    struct batch_t batch;
+    struct pool_t *pool;
+    char *dir;
+    int status = SUCCESS;
+    int i = 0;
+    int j = 0;
+
+    dir = logging_createDirectory();
+
+    if (dir == NULL) {
+        return FAIL;
+    }
+
+    batch.jobs = (struct job_t *) calloc(count, sizeof(struct job_t));
+    batch.count = count;
+    batch.next = 0;
+    batch.index = openFile(dir, BATCH_INDEX);
+    batch.best = openFile(dir, BATCH_BEST);
+
+    if (batch.jobs == NULL || batch.index == NULL || batch.best == NULL) {
+        fprintf(stderr, "Could not set up the batch of %d jobs in %s\n", count, dir);
+        status = FAIL;
+    } else {
+        fprintf(batch.index, "Job,RandomNum,Iteration,Points,TMax,TDamping,"
+                "UniformInitialConfiguration,InitialAcceptance,Objective,Best,Status,Seconds,"
+                "Offset\n");
+        fprintf(batch.best, "Job,x,y,z\n");
+
+        /* a job continues the generator of the last job with the same seed */
+        for (j = 0; j < count; j++) {
+            batch.jobs[j].args = jobs[j].args;
+            batch.jobs[j].from = jobs[j].from;
+
+            for (i = j - 1; i >= 0 && jobs[i].args.seed != jobs[j].args.seed; i--) {
+            }
+
+            if (i < 0) {
+                rng_seed(&batch.jobs[j].rng, jobs[j].args.seed);
+            } else {
+                batch.jobs[j].rng = batch.jobs[i].rng;
+                rng_longJump(&batch.jobs[j].rng);
+            }
+        }
+
+        pthread_mutex_init(&batch.lock, NULL);
+        pool = pool_create(workers);
+        pool_run(pool, count, runJob, &batch);
+        pool_destroy(pool);
+        pthread_mutex_destroy(&batch.lock);
+
+        for (j = 0; j < count; j++) {
+            status = (batch.jobs[j].status == SUCCESS) ? status : FAIL;
+        }
+
+        fprintf(stderr, "Wrote %d jobs to %s\n", count, dir);
+    }
+
+    if (batch.index != NULL) {
+        fclose(batch.index);
+    }
+    if (batch.best != NULL) {
+        fclose(batch.best);
+    }
+
+    free(batch.jobs);
+    free(dir);
+
+    return status;
+}
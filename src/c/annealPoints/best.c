@@ -0,0 +1,194 @@
+/**
+ * This module keeps track of the best configuration without copying the whole configuration on
+ * every improvement. Early in a run almost every accepted move improves the best objective, and
+ * a copy of N points per move dominates the cost of the move.
+ *
+ * The best configuration B is written (materialised) only at the end of a temperature level and
+ * of the run. In between, two sets of points are kept:
+ *
+ * - the dirty set holds the points moved since B was last written, so the current configuration
+ *   differs from B in those points only.
+ * - the journal holds the points moved since the last improvement together with their
+ *   positions at the time of the improvement.
+ *
+ * An improvement only clears the journal. Materialising copies the dirty points from the current
+ * configuration and then restores the journaled points to their positions at the improvement.
+ * Afterwards, the current configuration differs from B in the journaled points only. Every
+ * move costs O(1), and materialising costs O(number of points moved). Only a configuration
+ * replaced as a whole, like the exchange of the parallel tempering, costs O(N).
+ *
+ * @author Dominik Dahlem
+ */
+#include <stdlib.h>
+
+#include "best.h"
+#include "vector.h"
+#include "workspace.h"
+
+
+/**
+ * The state of the best configuration.
+ */
+struct best_t {
+    struct vector_t *best_points; /** the best configuration as last materialised */
+    const struct vector_t *points; /** the current configuration */
+    int n; /** number of points */
+    int pending; /** flag for an improvement since the last materialisation */
+    int *dirty; /** the points moved since the last materialisation */
+    int dirtyCount; /** number of dirty points */
+    char *isDirty; /** flags the dirty points */
+    int *journal; /** the points moved since the last improvement */
+    struct vector_t *saved; /** their positions at the last improvement */
+    int journalCount; /** number of journaled points */
+    char *isJournaled; /** flags the journaled points */
+};
+
+
+/**
+ * Add a point to the dirty set.
+ *
+ * @param struct best_t *const the state
+ * @param const int the point
+ */
+static void markDirty(struct best_t *const best, const int index)
+{
+    if (!best->isDirty[index]) {
+        best->isDirty[index] = 1;
+        best->dirty[best->dirtyCount++] = index;
+    }
+}
+
+/**
+ * Create the tracking of the best configuration. The best configuration may still be set up
+ * after this, e.g. from a checkpoint, so all points start out dirty.
+ *
+ * @param struct workspace_t *const the workspace the state is allocated from
+ * @param struct vector_t *const the best configuration
+ * @param const struct vector_t *const the current configuration
+ * @param const int number of points
+ * @return struct best_t* the state or NULL, if the memory could not be allocated
+ */
+struct best_t *best_create(struct workspace_t *const workspace, struct vector_t *const best_points,
+                           const struct vector_t *const points, const int n)
+{
+    struct best_t *best = (struct best_t *) workspace_alloc(workspace, sizeof(struct best_t));
+    int i = 0;
+
+    if (best == NULL) {
+        return NULL;
+    }
+
+    best->dirty = (int *) workspace_alloc(workspace, n * sizeof(int));
+    best->journal = (int *) workspace_alloc(workspace, n * sizeof(int));
+    best->saved = (struct vector_t *) workspace_alloc(workspace, n * sizeof(struct vector_t));
+    best->isDirty = (char *) workspace_alloc(workspace, n * sizeof(char));
+    best->isJournaled = (char *) workspace_alloc(workspace, n * sizeof(char));
+
+    if (best->dirty == NULL || best->journal == NULL || best->saved == NULL
+        || best->isDirty == NULL || best->isJournaled == NULL) {
+        return NULL;
+    }
+
+    best->best_points = best_points;
+    best->points = points;
+    best->n = n;
+    best->pending = 0;
+    best->dirtyCount = 0;
+    best->journalCount = 0;
+
+    for (i = 0; i < n; i++) {
+        best->isDirty[i] = 0;
+        best->isJournaled[i] = 0;
+        markDirty(best, i);
+    }
+
+    return best;
+}
+
+/**
+ * Record that a point is about to be moved. Has to be called before the current configuration
+ * is changed.
+ *
+ * @param struct best_t *const the state
+ * @param const int the point
+ */
+void best_moved(struct best_t *const best, const int index)
+{
+    markDirty(best, index);
+
+    /* remember the position of the point in the best configuration */
+    if (best->pending && !best->isJournaled[index]) {
+        best->isJournaled[index] = 1;
+        best->journal[best->journalCount] = index;
+        best->saved[best->journalCount++] = best->points[index];
+    }
+}
+
+/**
+ * Record that the current configuration is the new best one.
+ *
+ * @param struct best_t *const the state
+ */
+void best_improved(struct best_t *const best)
+{
+    int j = 0;
+
+    for (j = 0; j < best->journalCount; j++) {
+        best->isJournaled[best->journal[j]] = 0;
+    }
+
+    best->journalCount = 0;
+    best->pending = 1;
+}
+
+/**
+ * Write the best configuration, if it improved since it was last written.
+ *
+ * @param struct best_t *const the state
+ */
+void best_materialise(struct best_t *const best)
+{
+    int i = 0;
+    int j = 0;
+
+    if (!best->pending) {
+        return;
+    }
+
+    for (i = 0; i < best->dirtyCount; i++) {
+        best->best_points[best->dirty[i]] = best->points[best->dirty[i]];
+        best->isDirty[best->dirty[i]] = 0;
+    }
+
+    best->dirtyCount = 0;
+
+    /* undo the moves after the improvement, which leaves those points dirty */
+    for (j = 0; j < best->journalCount; j++) {
+        best->best_points[best->journal[j]] = best->saved[j];
+        best->isJournaled[best->journal[j]] = 0;
+        markDirty(best, best->journal[j]);
+    }
+
+    best->journalCount = 0;
+    best->pending = 0;
+}
+
+/**
+ * Track another current configuration, e.g. after configurations have been exchanged. A pending
+ * improvement is materialised from the previous configuration first. All points count as moved,
+ * since the new configuration may differ from the best one in any point.
+ *
+ * @param struct best_t *const the tracking of the best configuration
+ * @param const struct vector_t *const the new current configuration
+ */
+void best_replaced(struct best_t *const best, const struct vector_t *const points)
+{
+    int i = 0;
+
+    best_materialise(best);
+    best->points = points;
+
+    for (i = 0; i < best->n; i++) {
+        markDirty(best, i);
+    }
+}
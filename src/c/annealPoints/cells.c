@@ -0,0 +1,303 @@
+/**
+ * This module provides a spatial index for closest-pair and nearest-neighbour queries. The
+ * points are binned into a hashed grid of cubic cells of side h, so that all points within
+ * distance h of a point lie in the 27 cells around its own cell.
+ *
+ * For every point, the nearest neighbour within distance h is maintained, and an indexed binary
+ * heap orders the points by their nearest-neighbour distance. The top of the heap is the
+ * globally closest pair. Moving a point only touches the points in the 27 cells around its old
+ * and its new position, and the heap entries of the points whose neighbours changed.
+ *
+ * @author Dominik Dahlem
+ */
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "cells.h"
+#include "grid.h"
+#include "kernel.h"
+#include "logging.h"
+#include "points.h"
+
+
+/**
+ * The state of the spatial index.
+ */
+struct cells_t {
+    const struct points_t *points; /** the indexed points */
+    struct grid_t grid; /** the grid of cells holding the points */
+    double size2; /** the squared side of a cell */
+    int *nn; /** the nearest neighbour within one cell size of every point, or -1 */
+    double *nd2; /** the squared distance to the nearest neighbour, or DBL_MAX */
+    int *heap; /** the points ordered by their nearest-neighbour distance */
+    int *pos; /** the position of every point in the heap */
+};
+
+
+/**
+ * @return the squared distance between two indexed points
+ */
+static double distance2(const struct points_t *const points, const int i, const int j)
+{
+    double dx = points->x[i] - points->x[j];
+    double dy = points->y[i] - points->y[j];
+    double dz = points->z[i] - points->z[j];
+
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * Swap two entries of the heap.
+ */
+static void heapSwap(struct cells_t *const cells, const int a, const int b)
+{
+    int tmp = cells->heap[a];
+
+    cells->heap[a] = cells->heap[b];
+    cells->heap[b] = tmp;
+    cells->pos[cells->heap[a]] = a;
+    cells->pos[cells->heap[b]] = b;
+}
+
+/**
+ * Restore the heap order after the nearest-neighbour distance of a point changed.
+ */
+static void heapUpdate(struct cells_t *const cells, const int index)
+{
+    int n = cells->points->n;
+    int p = cells->pos[index];
+    int child;
+
+    /* sift up */
+    while (p > 0 && cells->nd2[cells->heap[(p - 1) / 2]] > cells->nd2[cells->heap[p]]) {
+        heapSwap(cells, p, (p - 1) / 2);
+        p = (p - 1) / 2;
+    }
+
+    /* sift down */
+    for (;;) {
+        child = 2 * p + 1;
+
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && cells->nd2[cells->heap[child + 1]] < cells->nd2[cells->heap[child]]) {
+            child++;
+        }
+        if (cells->nd2[cells->heap[child]] >= cells->nd2[cells->heap[p]]) {
+            break;
+        }
+
+        heapSwap(cells, p, child);
+        p = child;
+    }
+}
+
+/**
+ * Insert a point into the grid at its current position.
+ */
+static void insert(struct cells_t *const cells, const int index)
+{
+    const struct points_t *points = cells->points;
+
+    grid_insert(&cells->grid, index, points->x[index], points->y[index], points->z[index]);
+}
+
+/**
+ * Recompute the nearest neighbour within one cell size of the given point.
+ */
+static void nearest(struct cells_t *const cells, const int index)
+{
+    int list[GRID_NEIGHBOURS];
+    int count, k, j;
+    double d2;
+
+    cells->nn[index] = -1;
+    cells->nd2[index] = DBL_MAX;
+    count = grid_neighbours(&cells->grid, &cells->grid.cell[3 * index], list);
+
+    for (k = 0; k < count; k++) {
+        for (j = cells->grid.head[list[k]]; j >= 0; j = cells->grid.next[j]) {
+            if (j != index) {
+                d2 = distance2(cells->points, index, j);
+
+                if (d2 < cells->size2 && d2 < cells->nd2[index]) {
+                    cells->nn[index] = j;
+                    cells->nd2[index] = d2;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Create the spatial index over the given points. The index keeps a reference to the point
+ * store, and cells_move has to be called whenever a point of the store is changed.
+ *
+ * @param const struct points_t *const the point store
+ * @return struct cells_t* the spatial index or NULL, if the memory could not be allocated
+ */
+struct cells_t *cells_create(const struct points_t *const points)
+{
+    struct cells_t *cells;
+    double size;
+    int n = points->n;
+    int i = 0;
+
+    cells = (struct cells_t *) calloc(1, sizeof(struct cells_t));
+
+    if (cells == NULL) {
+        return NULL;
+    }
+
+    size = CELLS_SPACING * sqrt(4.0 * M_PI / (n > 0 ? n : 1));
+    size = (size > 2.0) ? 2.0 : size;
+
+    cells->points = points;
+    cells->size2 = size * size;
+    cells->nn = (int *) malloc(n * sizeof(int));
+    cells->nd2 = (double *) malloc(n * sizeof(double));
+    cells->heap = (int *) malloc(n * sizeof(int));
+    cells->pos = (int *) malloc(n * sizeof(int));
+
+    if (grid_alloc(&cells->grid, n, size) == FAIL
+        || cells->nn == NULL || cells->nd2 == NULL || cells->heap == NULL || cells->pos == NULL) {
+        cells_destroy(cells);
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++) {
+        insert(cells, i);
+    }
+
+    for (i = 0; i < n; i++) {
+        nearest(cells, i);
+        cells->heap[i] = i;
+        cells->pos[i] = i;
+    }
+
+    for (i = n / 2 - 1; i >= 0; i--) {
+        heapUpdate(cells, cells->heap[i]);
+    }
+
+    return cells;
+}
+
+/**
+ * Free the spatial index.
+ *
+ * @param struct cells_t* the spatial index
+ */
+void cells_destroy(struct cells_t *cells)
+{
+    if (cells == NULL) {
+        return;
+    }
+
+    grid_free(&cells->grid);
+    free(cells->nn);
+    free(cells->nd2);
+    free(cells->heap);
+    free(cells->pos);
+    free(cells);
+}
+
+/**
+ * Update the index after the point at the given index has been moved in the point store.
+ *
+ * @param struct cells_t *const the spatial index
+ * @param const int the index of the moved point
+ */
+void cells_move(struct cells_t *const cells, const int index)
+{
+    int list[GRID_NEIGHBOURS];
+    int count, k, j;
+    double d2;
+
+    /* the points that had the moved point as neighbour are around its old cell */
+    grid_remove(&cells->grid, index);
+    count = grid_neighbours(&cells->grid, &cells->grid.cell[3 * index], list);
+
+    for (k = 0; k < count; k++) {
+        for (j = cells->grid.head[list[k]]; j >= 0; j = cells->grid.next[j]) {
+            if (cells->nn[j] == index) {
+                nearest(cells, j);
+                heapUpdate(cells, j);
+            }
+        }
+    }
+
+    /* the moved point may be the new neighbour of points around its new cell */
+    insert(cells, index);
+    nearest(cells, index);
+    heapUpdate(cells, index);
+    count = grid_neighbours(&cells->grid, &cells->grid.cell[3 * index], list);
+
+    for (k = 0; k < count; k++) {
+        for (j = cells->grid.head[list[k]]; j >= 0; j = cells->grid.next[j]) {
+            if (j != index) {
+                d2 = distance2(cells->points, index, j);
+
+                if (d2 < cells->size2 && d2 < cells->nd2[j]) {
+                    cells->nn[j] = index;
+                    cells->nd2[j] = d2;
+                    heapUpdate(cells, j);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Find the two points with the shortest distance to each other.
+ *
+ * @param const struct cells_t *const the spatial index
+ * @param int* the array of indices for the two closest points, or -1 if no two points are
+ *        closer than one cell size
+ * @return the distance between the two closest points, or DBL_MAX
+ */
+double cells_closest(const struct cells_t *const cells, int *index_min)
+{
+    int top;
+
+    if (cells->points->n < 2 || cells->nn[cells->heap[0]] < 0) {
+        index_min[0] = index_min[1] = -1;
+        return DBL_MAX;
+    }
+
+    top = cells->heap[0];
+    index_min[0] = (top < cells->nn[top]) ? top : cells->nn[top];
+    index_min[1] = (top < cells->nn[top]) ? cells->nn[top] : top;
+
+    return sqrt(cells->nd2[top]);
+}
+
+/**
+ * Find the nearest neighbour of a point. If there is no point within one cell size, all points
+ * are searched.
+ *
+ * @param const struct cells_t *const the spatial index
+ * @param const int the index of the point
+ * @param int* the index of the nearest neighbour
+ * @return the distance to the nearest neighbour
+ */
+double cells_nearest(const struct cells_t *const cells, const int index, int *neighbour)
+{
+    struct vector_t point;
+    double d2_low, d2_high;
+    int low, high;
+
+    if (cells->nn[index] >= 0) {
+        *neighbour = cells->nn[index];
+        return sqrt(cells->nd2[index]);
+    }
+
+    point = points_get(cells->points, index);
+    d2_low = kernel_closestRow(cells->points, 0, index, &point, &low);
+    d2_high = kernel_closestRow(cells->points, index + 1, cells->points->n, &point, &high);
+
+    *neighbour = (d2_low <= d2_high) ? low : high;
+
+    return sqrt((d2_low <= d2_high) ? d2_low : d2_high);
+}
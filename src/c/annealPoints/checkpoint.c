@@ -0,0 +1,319 @@
+/**
+ * This module writes and reads the checkpoints of the simulated annealing. A checkpoint file
+ * consists of a fixed header followed by the current and the best configuration and the tuned
+ * step sizes of the random walk, each starting at a 64-byte aligned offset. The file is mapped into memory when it is read, so the
+ * configurations are used without parsing.
+ *
+ * A checkpoint is first written to a temporary file, flushed to disk, and then renamed over the
+ * previous one. A crash during the write therefore leaves the previous checkpoint intact.
+ *
+ * @author Dominik Dahlem
+ */
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+#include "global.h"
+#include "logging.h"
+#include "rng.h"
+#include "schedule.h"
+#include "vector.h"
+
+
+/**
+ * The header of a checkpoint file.
+ */
+struct header_t {
+    char magic[8]; /** CHECKPOINT_MAGIC */
+    uint32_t version; /** CHECKPOINT_VERSION */
+    uint32_t vector; /** sizeof(struct vector_t), guards against foreign layouts */
+    uint64_t size; /** the size of the file */
+    uint64_t points; /** the offset of the current configuration */
+    uint64_t best_points; /** the offset of the best configuration */
+    uint64_t scales; /** the offset of the step sizes */
+    uint64_t scale_count; /** number of step sizes */
+    struct globalArgs_t args; /** the parameters of the simulation */
+    struct rng_t rng; /** the random number generator */
+    struct schedule_t schedule; /** the state of the cooling schedule */
+    double temperature; /** the temperature of the next level */
+    double current; /** the running objective */
+    double best; /** the best objective */
+    int64_t iteration; /** number of proposals so far */
+};
+
+
+/**
+ * @return the offset rounded up to the next multiple of 64 bytes
+ */
+static uint64_t align(const uint64_t offset)
+{
+    return (offset + 63) & ~((uint64_t) 63);
+}
+
+/**
+ * @return the path of a file in a directory, to be freed by the caller
+ */
+static char *path(const char *const dir, const char *const file)
+{
+    char *name = (char *) malloc(strlen(dir) + strlen(file) + 2);
+
+    if (name != NULL) {
+        sprintf(name, "%s/%s", dir, file);
+    }
+
+    return name;
+}
+
+/**
+ * Write a buffer completely.
+ *
+ * @return int SUCCESS or FAIL
+ */
+static int writeAll(const int fd, const void *buffer, size_t size)
+{
+    const char *bytes = (const char *) buffer;
+    ssize_t written;
+
+    while (size > 0) {
+        written = write(fd, bytes, size);
+
+        if (written < 0) {
+            return FAIL;
+        }
+
+        bytes += written;
+        size -= (size_t) written;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Check whether the next checkpoint is due. The first call starts the clock.
+ *
+ * @param struct timespec *const the time of the last due checkpoint (zero before the first call)
+ * @param const double the interval between two checkpoints in seconds (0 for no checkpoints)
+ * @return int 1, if more than the interval has passed since the last due checkpoint
+ */
+int checkpoint_due(struct timespec *const last, const double interval)
+{
+    struct timespec now;
+
+    if (interval <= 0.0) {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (last->tv_sec == 0 && last->tv_nsec == 0) {
+        *last = now;
+        return 0;
+    }
+
+    if ((double) (now.tv_sec - last->tv_sec) + 1e-9 * (double) (now.tv_nsec - last->tv_nsec)
+        < interval) {
+        return 0;
+    }
+
+    *last = now;
+
+    return 1;
+}
+
+/**
+ * Write a checkpoint atomically into the given directory.
+ *
+ * @param const char *const the directory
+ * @param const struct checkpoint_t *const the state of the simulation
+ * @return int SUCCESS or FAIL
+ */
+int checkpoint_save(const char *const dir, const struct checkpoint_t *const checkpoint)
+{
+    static const char zeros[64] = {0};
+    struct header_t header;
+    size_t bytes = checkpoint->args.n * sizeof(struct vector_t);
+    char *file, *tmp;
+    int status = FAIL;
+    int fd;
+
+    if (dir == NULL) {
+        return FAIL;
+    }
+
+    memset(&header, 0, sizeof(struct header_t));
+    strncpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.vector = sizeof(struct vector_t);
+    header.points = align(sizeof(struct header_t));
+    header.best_points = align(header.points + bytes);
+    header.scales = align(header.best_points + bytes);
+    header.scale_count = (checkpoint->scales != NULL) ? (uint64_t) checkpoint->scale_count : 0;
+    header.size = header.scales + header.scale_count * sizeof(double);
+    header.args = checkpoint->args;
+    header.rng = checkpoint->rng;
+    header.schedule = checkpoint->schedule;
+    header.temperature = checkpoint->temperature;
+    header.current = checkpoint->current;
+    header.best = checkpoint->best;
+    header.iteration = checkpoint->iteration;
+
+    file = path(dir, CHECKPOINT_FILE);
+    tmp = path(dir, CHECKPOINT_FILE ".tmp");
+
+    if (file == NULL || tmp == NULL) {
+        free(file);
+        free(tmp);
+        return FAIL;
+    }
+
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+
+    if (fd >= 0) {
+        if (writeAll(fd, &header, sizeof(struct header_t)) == SUCCESS
+            && writeAll(fd, zeros, header.points - sizeof(struct header_t)) == SUCCESS
+            && writeAll(fd, checkpoint->points, bytes) == SUCCESS
+            && writeAll(fd, zeros, header.best_points - header.points - bytes) == SUCCESS
+            && writeAll(fd, checkpoint->best_points, bytes) == SUCCESS
+            && writeAll(fd, zeros, header.scales - header.best_points - bytes) == SUCCESS
+            && writeAll(fd, checkpoint->scales, header.scale_count * sizeof(double)) == SUCCESS
+            && fsync(fd) == 0) {
+            status = SUCCESS;
+        }
+
+        close(fd);
+    }
+
+    if (status == SUCCESS && rename(tmp, file) != 0) {
+        status = FAIL;
+    }
+
+    /* make the rename itself durable */
+    if (status == SUCCESS && (fd = open(dir, O_RDONLY)) >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+
+    if (status == FAIL) {
+        fprintf(stderr, "Could not write the checkpoint %s\n", file);
+        unlink(tmp);
+    }
+
+    free(file);
+    free(tmp);
+
+    return status;
+}
+
+/**
+ * Map a checkpoint file into memory. The configurations of the checkpoint point into the
+ * mapping, which has to be released with checkpoint_release.
+ *
+ * @param const char *const the checkpoint file
+ * @param struct checkpoint_t *const the state of the simulation to be filled
+ * @return int SUCCESS or FAIL, if the file is not a valid checkpoint
+ */
+int checkpoint_map(const char *const file, struct checkpoint_t *const checkpoint)
+{
+    const struct header_t *header;
+    struct stat info;
+    void *map = MAP_FAILED;
+    int fd;
+
+    checkpoint->map = NULL;
+
+    fd = open(file, O_RDONLY);
+
+    if (fd >= 0 && fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(struct header_t)) {
+        map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Could not read the checkpoint %s\n", file);
+        return FAIL;
+    }
+
+    header = (const struct header_t *) map;
+
+    /* the configurations have to lie within the mapping, one after the other, without wrapping */
+    if (strncmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != CHECKPOINT_VERSION
+        || header->vector != sizeof(struct vector_t)
+        || header->size != (uint64_t) info.st_size
+        || header->args.n <= 0
+        || (uint64_t) header->args.n > header->size / sizeof(struct vector_t)
+        || header->scale_count > header->size / sizeof(double)
+        || header->points < sizeof(struct header_t)
+        || header->points > header->size
+        || header->best_points > header->size
+        || header->scales > header->size
+        || header->points + header->args.n * sizeof(struct vector_t) > header->best_points
+        || header->best_points + header->args.n * sizeof(struct vector_t) > header->scales
+        || header->scales + header->scale_count * sizeof(double) != header->size) {
+        fprintf(stderr, "%s is not a valid checkpoint\n", file);
+        munmap(map, (size_t) info.st_size);
+        return FAIL;
+    }
+
+    checkpoint->args = header->args;
+    checkpoint->rng = header->rng;
+    checkpoint->schedule = header->schedule;
+    checkpoint->temperature = header->temperature;
+    checkpoint->current = header->current;
+    checkpoint->best = header->best;
+    checkpoint->iteration = (long) header->iteration;
+    checkpoint->points = (struct vector_t *) ((char *) map + header->points);
+    checkpoint->best_points = (struct vector_t *) ((char *) map + header->best_points);
+    checkpoint->scales = (header->scale_count > 0)
+        ? (double *) ((char *) map + header->scales) : NULL;
+    checkpoint->scale_count = (int) header->scale_count;
+    checkpoint->map = map;
+    checkpoint->size = (size_t) info.st_size;
+
+    return SUCCESS;
+}
+
+/**
+ * Map the checkpoint of the given directory into memory (see checkpoint_map).
+ *
+ * @param const char *const the directory
+ * @param struct checkpoint_t *const the state of the simulation to be filled
+ * @return int SUCCESS or FAIL, if there is no valid checkpoint
+ */
+int checkpoint_load(const char *const dir, struct checkpoint_t *const checkpoint)
+{
+    char *file = path(dir, CHECKPOINT_FILE);
+    int status = FAIL;
+
+    checkpoint->map = NULL;
+
+    if (file != NULL) {
+        status = checkpoint_map(file, checkpoint);
+        free(file);
+    }
+
+    return status;
+}
+
+/**
+ * Release the mapping of a loaded checkpoint.
+ *
+ * @param struct checkpoint_t *const the state of the simulation
+ */
+void checkpoint_release(struct checkpoint_t *const checkpoint)
+{
+    if (checkpoint->map != NULL) {
+        munmap(checkpoint->map, checkpoint->size);
+        checkpoint->map = NULL;
+    }
+}
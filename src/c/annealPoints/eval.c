@@ -0,0 +1,296 @@
+/**
+ * This module evaluates the objectives over the whole configuration in parallel. The rows of the
+ * i<j triangle are grouped into EVAL_TILES tiles holding roughly the same number of pairs. Each
+ * tile is reduced by one task of the thread pool, and the partial results are combined in tile
+ * order afterwards.
+ *
+ * The gradients need the full rows instead of the triangle, since every point gets its own
+ * result. The rows are split evenly, and each task writes only the gradients of its own rows.
+ *
+ * @author Dominik Dahlem
+ */
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "eval.h"
+#include "kernel.h"
+#include "points.h"
+#include "pool.h"
+
+
+/**
+ * Identifies the pair reduction of a parallel evaluation.
+ */
+enum reduction_t {
+    REDUCE_DISTANCE,
+    REDUCE_ENERGY,
+    REDUCE_CLOSEST
+};
+
+/**
+ * The shared state of a parallel evaluation.
+ */
+struct tiles_t {
+    const struct points_t *points; /** the point store */
+    enum reduction_t reduction; /** the pair reduction */
+    int count; /** number of tiles */
+    int first[EVAL_TILES + 1]; /** the first row of every tile */
+    double partial[EVAL_TILES]; /** the partial result of every tile */
+    int index[EVAL_TILES][2]; /** the closest pair of every tile */
+};
+
+/**
+ * The shared state of a parallel gradient evaluation.
+ */
+struct gradient_t {
+    const struct points_t *points; /** the point store */
+    struct vector_t *gradient; /** the gradient of every point */
+    int energy; /** 1 for the energy, 0 for the distance */
+    int count; /** number of tasks */
+};
+
+
+/**
+ * Split the rows 0..n-2 into tiles of roughly equal numbers of pairs. Row i holds n-1-i pairs.
+ *
+ * @param struct tiles_t *const the tiles to be set up
+ * @param const int the number of points
+ */
+static void split(struct tiles_t *const tiles, const int n)
+{
+    double pairs = 0.5 * (double) n * (double) (n - 1);
+    double cumulative = 0.0;
+    int rows = n - 1;
+    int tile = 0;
+    int i = 0;
+
+    tiles->count = (rows < EVAL_TILES) ? rows : EVAL_TILES;
+    tiles->first[0] = 0;
+    tile = 1;
+
+    for (i = 0; i < rows && tile < tiles->count; i++) {
+        cumulative += (double) (n - 1 - i);
+
+        /* close the tile once its share of the pairs is reached */
+        if (cumulative >= pairs * tile / tiles->count) {
+            tiles->first[tile++] = i + 1;
+        }
+    }
+
+    /* rows may run out before the last tiles got any */
+    while (tile <= tiles->count) {
+        tiles->first[tile++] = rows;
+    }
+}
+
+/**
+ * Reduce the rows of one tile.
+ *
+ * @param void* the tiles
+ * @param int the tile
+ */
+static void reduceTile(void *arg, int tile)
+{
+    struct tiles_t *tiles = (struct tiles_t *) arg;
+    const struct points_t *points = tiles->points;
+    struct vector_t point;
+    double result, dist;
+    int i = 0;
+    int j = 0;
+
+    result = (tiles->reduction == REDUCE_CLOSEST) ? DBL_MAX : 0.0;
+    tiles->index[tile][0] = tiles->index[tile][1] = -1;
+
+    for (i = tiles->first[tile]; i < tiles->first[tile + 1]; i++) {
+        point = points_get(points, i);
+
+        switch (tiles->reduction) {
+            case REDUCE_DISTANCE:
+                result += kernel_distanceRow(points, i + 1, points->n, &point);
+                break;
+            case REDUCE_ENERGY:
+                result += kernel_energyRow(points, i + 1, points->n, &point);
+                break;
+            case REDUCE_CLOSEST:
+                dist = kernel_closestRow(points, i + 1, points->n, &point, &j);
+                if (dist < result) {
+                    result = dist;
+                    tiles->index[tile][0] = i;
+                    tiles->index[tile][1] = j;
+                }
+                break;
+        }
+    }
+
+    tiles->partial[tile] = result;
+}
+
+/**
+ * Run a parallel reduction over all tiles.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param const struct points_t *const the point store
+ * @param enum reduction_t the pair reduction
+ * @param struct tiles_t *const the tiles holding the partial results
+ */
+static void reduce(struct pool_t *const pool, const struct points_t *const points,
+                   enum reduction_t reduction, struct tiles_t *const tiles)
+{
+    /* make sure the kernels are selected before any of the workers may race to do so */
+    (void) kernel_name();
+
+    tiles->points = points;
+    tiles->reduction = reduction;
+    split(tiles, points->n);
+
+    pool_run(pool, tiles->count, reduceTile, tiles);
+}
+
+/**
+ * Evaluate the gradients of the rows of one task.
+ *
+ * @param void* the gradient evaluation
+ * @param int the task
+ */
+static void gradientTask(void *arg, int task)
+{
+    struct gradient_t *gradient = (struct gradient_t *) arg;
+    const struct points_t *points = gradient->points;
+    int first = (int) ((long) points->n * task / gradient->count);
+    int last = (int) ((long) points->n * (task + 1) / gradient->count);
+    struct vector_t point;
+    int i = 0;
+
+    for (i = first; i < last; i++) {
+        point = points_get(points, i);
+        gradient->gradient[i] = gradient->energy
+            ? kernel_energyGradientTo(points, i, &point)
+            : kernel_distanceGradientTo(points, i, &point);
+    }
+}
+
+/**
+ * Evaluate the gradient of every point in parallel.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param const struct points_t *const the point store
+ * @param const int 1 for the energy, 0 for the distance
+ * @param struct vector_t *const the gradient of every point
+ */
+static void gradient(struct pool_t *const pool, const struct points_t *const points,
+                     const int energy, struct vector_t *const result)
+{
+    struct gradient_t arg;
+
+    (void) kernel_name();
+
+    arg.points = points;
+    arg.gradient = result;
+    arg.energy = energy;
+    arg.count = (points->n < EVAL_TILES) ? points->n : EVAL_TILES;
+
+    pool_run(pool, arg.count, gradientTask, &arg);
+}
+
+/**
+ * The sum of the euclidean distances between any two points, evaluated in parallel.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @return the sum of the distances
+ */
+double eval_distance(struct pool_t *const pool, const struct points_t *const points)
+{
+    struct tiles_t tiles;
+    double dist = 0.0;
+    int t = 0;
+
+    reduce(pool, points, REDUCE_DISTANCE, &tiles);
+
+    for (t = 0; t < tiles.count; t++) {
+        dist += tiles.partial[t];
+    }
+
+    return dist;
+}
+
+/**
+ * The logarithmic Riesz energy of the configuration, evaluated in parallel.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @return the energy of the configuration
+ */
+double eval_energy(struct pool_t *const pool, const struct points_t *const points)
+{
+    struct tiles_t tiles;
+    double energy = 0.0;
+    int t = 0;
+
+    reduce(pool, points, REDUCE_ENERGY, &tiles);
+
+    for (t = 0; t < tiles.count; t++) {
+        energy += tiles.partial[t];
+    }
+
+    return energy;
+}
+
+/**
+ * Find the two points with the shortest distance to each other in parallel. Ties are resolved
+ * towards the pair found first in row order, as in the sequential search.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @param int* the array of indices for the two closest points
+ * @return the distance between the two closest points
+ */
+double eval_closest(struct pool_t *const pool, const struct points_t *const points, int *index_min)
+{
+    struct tiles_t tiles;
+    double dist_min = DBL_MAX;
+    int t = 0;
+
+    reduce(pool, points, REDUCE_CLOSEST, &tiles);
+
+    index_min[0] = index_min[1] = -1;
+
+    for (t = 0; t < tiles.count; t++) {
+        if (tiles.partial[t] < dist_min) {
+            dist_min = tiles.partial[t];
+            index_min[0] = tiles.index[t][0];
+            index_min[1] = tiles.index[t][1];
+        }
+    }
+
+    return sqrt(dist_min);
+}
+
+/**
+ * The gradient of the sum of the euclidean distances with respect to every point, evaluated in
+ * parallel. The result is the same for any number of threads.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @param struct vector_t *const the gradient of every point
+ */
+void eval_distanceGradient(struct pool_t *const pool, const struct points_t *const points,
+                           struct vector_t *const result)
+{
+    gradient(pool, points, 0, result);
+}
+
+/**
+ * The gradient of the logarithmic Riesz energy with respect to every point, evaluated in
+ * parallel. The result is the same for any number of threads.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @param struct vector_t *const the gradient of every point
+ */
+void eval_energyGradient(struct pool_t *const pool, const struct points_t *const points,
+                         struct vector_t *const result)
+{
+    gradient(pool, points, 1, result);
+}
@@ -0,0 +1,173 @@
+/**
+ * This module provides the hashed grid of cubic cells underlying the spatial indices.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdlib.h>
+
+#include "grid.h"
+#include "logging.h"
+
+
+/**
+ * @return the bucket of the given cell coordinates
+ */
+static int bucket(const struct grid_t *const grid, const int cx, const int cy, const int cz)
+{
+    unsigned int hash;
+
+    hash = ((unsigned int) cx * 73856093u) ^ ((unsigned int) cy * 19349663u)
+        ^ ((unsigned int) cz * 83492791u);
+
+    return (int) (hash & (unsigned int) (grid->buckets - 1));
+}
+
+/**
+ * Allocate an empty grid for the given number of points.
+ *
+ * @param struct grid_t *const the grid
+ * @param const int the number of points
+ * @param const double the side of a cell
+ * @return int SUCCESS or FAIL, if the memory could not be allocated
+ */
+int grid_alloc(struct grid_t *const grid, const int n, const double size)
+{
+    int i = 0;
+
+    grid->size = size;
+    grid->n = n;
+
+    for (grid->buckets = 16; grid->buckets < 2 * n; grid->buckets *= 2) {
+    }
+
+    grid->head = (int *) malloc(grid->buckets * sizeof(int));
+    grid->next = (int *) malloc(n * sizeof(int));
+    grid->prev = (int *) malloc(n * sizeof(int));
+    grid->cell = (int *) malloc(3 * n * sizeof(int));
+
+    if (grid->head == NULL || grid->next == NULL || grid->prev == NULL || grid->cell == NULL) {
+        grid_free(grid);
+        return FAIL;
+    }
+
+    for (i = 0; i < grid->buckets; i++) {
+        grid->head[i] = -1;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Free the grid.
+ *
+ * @param struct grid_t *const the grid
+ */
+void grid_free(struct grid_t *const grid)
+{
+    free(grid->head);
+    free(grid->next);
+    free(grid->prev);
+    free(grid->cell);
+
+    grid->head = grid->next = grid->prev = grid->cell = NULL;
+}
+
+/**
+ * Compute the cell coordinates of a position.
+ *
+ * @param const struct grid_t *const the grid
+ * @param const double the x-coordinate
+ * @param const double the y-coordinate
+ * @param const double the z-coordinate
+ * @param int* the three cell coordinates
+ */
+void grid_cell(const struct grid_t *const grid, const double x, const double y, const double z,
+               int *cell)
+{
+    cell[0] = (int) floor((x + 1.0) / grid->size);
+    cell[1] = (int) floor((y + 1.0) / grid->size);
+    cell[2] = (int) floor((z + 1.0) / grid->size);
+}
+
+/**
+ * Insert a point at the given position into the bucket of its cell.
+ *
+ * @param struct grid_t *const the grid
+ * @param const int the index of the point
+ * @param const double the x-coordinate
+ * @param const double the y-coordinate
+ * @param const double the z-coordinate
+ */
+void grid_insert(struct grid_t *const grid, const int index, const double x, const double y,
+                 const double z)
+{
+    int *c = &grid->cell[3 * index];
+    int b;
+
+    grid_cell(grid, x, y, z, c);
+    b = bucket(grid, c[0], c[1], c[2]);
+
+    grid->prev[index] = -1;
+    grid->next[index] = grid->head[b];
+
+    if (grid->head[b] >= 0) {
+        grid->prev[grid->head[b]] = index;
+    }
+
+    grid->head[b] = index;
+}
+
+/**
+ * Remove a point from the bucket of its cell.
+ *
+ * @param struct grid_t *const the grid
+ * @param const int the index of the point
+ */
+void grid_remove(struct grid_t *const grid, const int index)
+{
+    const int *c = &grid->cell[3 * index];
+
+    if (grid->prev[index] >= 0) {
+        grid->next[grid->prev[index]] = grid->next[index];
+    } else {
+        grid->head[bucket(grid, c[0], c[1], c[2])] = grid->next[index];
+    }
+
+    if (grid->next[index] >= 0) {
+        grid->prev[grid->next[index]] = grid->prev[index];
+    }
+}
+
+/**
+ * Collect the distinct buckets of the 27 cells around the given cell. Points of other cells
+ * may share these buckets, so callers still have to check the distances.
+ *
+ * @param const struct grid_t *const the grid
+ * @param const int* the three cell coordinates
+ * @param int* the array of at least GRID_NEIGHBOURS buckets
+ * @return the number of distinct buckets
+ */
+int grid_neighbours(const struct grid_t *const grid, const int *cell, int *list)
+{
+    int count = 0;
+    int dx, dy, dz, b, k;
+
+    for (dx = -1; dx <= 1; dx++) {
+        for (dy = -1; dy <= 1; dy++) {
+            for (dz = -1; dz <= 1; dz++) {
+                b = bucket(grid, cell[0] + dx, cell[1] + dy, cell[2] + dz);
+
+                /* neighbouring cells may share a bucket */
+                for (k = 0; k < count && list[k] != b; k++) {
+                }
+
+                if (k == count) {
+                    list[count++] = b;
+                }
+            }
+        }
+    }
+
+    return count;
+}
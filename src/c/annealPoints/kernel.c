@@ -0,0 +1,902 @@
+/**
+ * This module provides the pair kernels over a structure-of-arrays point store. Every kernel
+ * reduces the pair terms between one query point and a range of stored points. There is a
+ * scalar implementation and vectorised AVX2 and AVX-512 implementations, which are selected at
+ * runtime depending on the features of the CPU.
+ *
+ * The log-energy kernels avoid calling log() for every pair. Instead, the squared distances are
+ * multiplied into a running product, whose exponent is split off after every multiplication to
+ * keep the product in [1, 2). The logarithm is then taken once per vector lane.
+ *
+ * The gradient kernels sum the derivatives of the pair terms with respect to the query point,
+ * \f$ (x - x_j) / \mid x - x_j \mid \f$ for the distance and
+ * \f$ -2 (x - x_j) / \mid x - x_j \mid^2 \f$ for the energy.
+ *
+ * @author Dominik Dahlem
+ */
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define KERNEL_X86 1
+#endif
+
+#include "kernel.h"
+#include "points.h"
+#include "vector.h"
+
+
+/**
+ * A set of row kernels of one instruction set.
+ */
+struct kernel_t {
+    const char *name; /** name of the instruction set */
+    double (*distanceRow)(const double *, const double *, const double *, int, int,
+                          const struct vector_t *);
+    double (*energyRow)(const double *, const double *, const double *, int, int,
+                        const struct vector_t *);
+    double (*closestRow)(const double *, const double *, const double *, int, int,
+                         const struct vector_t *, int *);
+    struct vector_t (*gradientRow)(const double *, const double *, const double *, int, int,
+                                   const struct vector_t *, int);
+};
+
+/**
+ * The selected kernel implementation.
+ */
+static const struct kernel_t *kernel = NULL;
+
+/**
+ * Selects the kernel implementation once, even if the first kernels are called from several
+ * threads at the same time.
+ */
+static pthread_once_t selection = PTHREAD_ONCE_INIT;
+
+
+/**
+ * Scalar sum of the euclidean distances between a point and the stored points in [from, to).
+ */
+static double distanceRow_scalar(const double *x, const double *y, const double *z,
+                                 int from, int to, const struct vector_t *point)
+{
+    double dist = 0.0;
+    double dx, dy, dz;
+    int j = 0;
+
+    for (j = from; j < to; j++) {
+        dx = point->x - x[j];
+        dy = point->y - y[j];
+        dz = point->z - z[j];
+        dist += sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    return dist;
+}
+
+/**
+ * Scalar sum of the pair energies \f$ \log{1 / \mid x - x_j \mid^2} \f$ between a point and the
+ * stored points in [from, to).
+ */
+static double energyRow_scalar(const double *x, const double *y, const double *z,
+                               int from, int to, const struct vector_t *point)
+{
+    double energy = 0.0;
+    double dx, dy, dz;
+    int j = 0;
+
+    for (j = from; j < to; j++) {
+        dx = point->x - x[j];
+        dy = point->y - y[j];
+        dz = point->z - z[j];
+        energy -= log(dx * dx + dy * dy + dz * dz);
+    }
+
+    return energy;
+}
+
+/**
+ * Scalar search for the stored point in [from, to) closest to the given point.
+ */
+static double closestRow_scalar(const double *x, const double *y, const double *z,
+                                int from, int to, const struct vector_t *point, int *index)
+{
+    double dist_min = DBL_MAX;
+    double dx, dy, dz, d2;
+    int j = 0;
+
+    *index = -1;
+
+    for (j = from; j < to; j++) {
+        dx = point->x - x[j];
+        dy = point->y - y[j];
+        dz = point->z - z[j];
+        d2 = dx * dx + dy * dy + dz * dz;
+
+        if (d2 < dist_min) {
+            dist_min = d2;
+            *index = j;
+        }
+    }
+
+    return dist_min;
+}
+
+/**
+ * Scalar gradient of the distances (energy = 0) or the pair energies (energy = 1) between a point
+ * and the stored points in [from, to) with respect to the point.
+ */
+static struct vector_t gradientRow_scalar(const double *x, const double *y, const double *z,
+                                          int from, int to, const struct vector_t *point,
+                                          int energy)
+{
+    struct vector_t gradient = {0.0, 0.0, 0.0};
+    double dx, dy, dz, d2, w;
+    int j = 0;
+
+    for (j = from; j < to; j++) {
+        dx = point->x - x[j];
+        dy = point->y - y[j];
+        dz = point->z - z[j];
+        d2 = dx * dx + dy * dy + dz * dz;
+        w = energy ? -2.0 / d2 : 1.0 / sqrt(d2);
+        gradient.x += w * dx;
+        gradient.y += w * dy;
+        gradient.z += w * dz;
+    }
+
+    return gradient;
+}
+
+static const struct kernel_t kernel_scalar = {
+    "scalar", distanceRow_scalar, energyRow_scalar, closestRow_scalar, gradientRow_scalar
+};
+
+
+#ifdef KERNEL_X86
+
+/**
+ * AVX2 sum of the euclidean distances.
+ */
+__attribute__((target("avx2,fma")))
+static double distanceRow_avx2(const double *x, const double *y, const double *z,
+                               int from, int to, const struct vector_t *point)
+{
+    __m256d px = _mm256_set1_pd(point->x);
+    __m256d py = _mm256_set1_pd(point->y);
+    __m256d pz = _mm256_set1_pd(point->z);
+    __m256d acc = _mm256_setzero_pd();
+    __m256d dx, dy, dz, d2;
+    double lanes[4];
+    int j = from;
+
+    for (; j + 4 <= to; j += 4) {
+        dx = _mm256_sub_pd(px, _mm256_loadu_pd(x + j));
+        dy = _mm256_sub_pd(py, _mm256_loadu_pd(y + j));
+        dz = _mm256_sub_pd(pz, _mm256_loadu_pd(z + j));
+        d2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        acc = _mm256_add_pd(acc, _mm256_sqrt_pd(d2));
+    }
+
+    _mm256_storeu_pd(lanes, acc);
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3])
+        + distanceRow_scalar(x, y, z, j, to, point);
+}
+
+/**
+ * AVX2 sum of the pair energies. The exponents of the running products are accumulated as
+ * 64-bit integers. A coincident pair has an infinite energy, as in the scalar kernel, which the
+ * split product would turn into a finite one.
+ */
+__attribute__((target("avx2,fma")))
+static double energyRow_avx2(const double *x, const double *y, const double *z,
+                             int from, int to, const struct vector_t *point)
+{
+    const __m256i mantissa = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+    const __m256i one = _mm256_set1_epi64x(0x3FF0000000000000LL);
+    const __m256i bias = _mm256_set1_epi64x(1023);
+    __m256d px = _mm256_set1_pd(point->x);
+    __m256d py = _mm256_set1_pd(point->y);
+    __m256d pz = _mm256_set1_pd(point->z);
+    __m256d prod = _mm256_set1_pd(1.0);
+    __m256i expo = _mm256_setzero_si256();
+    __m256d coincident = _mm256_setzero_pd();
+    __m256i bits;
+    __m256d dx, dy, dz, d2;
+    double lanes[4];
+    long long exponents[4];
+    double logSum = 0.0;
+    int j = from;
+    int l = 0;
+
+    for (; j + 4 <= to; j += 4) {
+        dx = _mm256_sub_pd(px, _mm256_loadu_pd(x + j));
+        dy = _mm256_sub_pd(py, _mm256_loadu_pd(y + j));
+        dz = _mm256_sub_pd(pz, _mm256_loadu_pd(z + j));
+        d2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        coincident = _mm256_or_pd(coincident,
+                                  _mm256_cmp_pd(d2, _mm256_setzero_pd(), _CMP_EQ_OQ));
+
+        /* split the product into exponent and mantissa in [1, 2) */
+        bits = _mm256_castpd_si256(_mm256_mul_pd(prod, d2));
+        expo = _mm256_add_epi64(expo, _mm256_sub_epi64(_mm256_srli_epi64(bits, 52), bias));
+        prod = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mantissa), one));
+    }
+
+    if (_mm256_movemask_pd(coincident) != 0) {
+        return HUGE_VAL;
+    }
+
+    _mm256_storeu_pd(lanes, prod);
+    _mm256_storeu_si256((__m256i *) exponents, expo);
+
+    for (l = 0; l < 4; l++) {
+        logSum += (double) exponents[l] * M_LN2 + log(lanes[l]);
+    }
+
+    return energyRow_scalar(x, y, z, j, to, point) - logSum;
+}
+
+/**
+ * AVX2 search for the closest point. Ties are resolved towards the lower index, so that the
+ * result is the same as the one of the scalar kernel.
+ */
+__attribute__((target("avx2,fma")))
+static double closestRow_avx2(const double *x, const double *y, const double *z,
+                              int from, int to, const struct vector_t *point, int *index)
+{
+    __m256d px = _mm256_set1_pd(point->x);
+    __m256d py = _mm256_set1_pd(point->y);
+    __m256d pz = _mm256_set1_pd(point->z);
+    __m256d best = _mm256_set1_pd(DBL_MAX);
+    __m256d bestIndex = _mm256_set1_pd(-1.0);
+    __m256d indices = _mm256_setr_pd(from, from + 1, from + 2, from + 3);
+    const __m256d step = _mm256_set1_pd(4.0);
+    __m256d dx, dy, dz, d2, less;
+    double lanes[4], laneIndex[4];
+    double dist_min, d2_tail;
+    int index_tail;
+    int j = from;
+    int l = 0;
+
+    for (; j + 4 <= to; j += 4) {
+        dx = _mm256_sub_pd(px, _mm256_loadu_pd(x + j));
+        dy = _mm256_sub_pd(py, _mm256_loadu_pd(y + j));
+        dz = _mm256_sub_pd(pz, _mm256_loadu_pd(z + j));
+        d2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        less = _mm256_cmp_pd(d2, best, _CMP_LT_OQ);
+        best = _mm256_blendv_pd(best, d2, less);
+        bestIndex = _mm256_blendv_pd(bestIndex, indices, less);
+        indices = _mm256_add_pd(indices, step);
+    }
+
+    _mm256_storeu_pd(lanes, best);
+    _mm256_storeu_pd(laneIndex, bestIndex);
+
+    dist_min = DBL_MAX;
+    *index = -1;
+
+    for (l = 0; l < 4; l++) {
+        if (laneIndex[l] >= 0.0
+            && (lanes[l] < dist_min || (lanes[l] == dist_min && (int) laneIndex[l] < *index))) {
+            dist_min = lanes[l];
+            *index = (int) laneIndex[l];
+        }
+    }
+
+    d2_tail = closestRow_scalar(x, y, z, j, to, point, &index_tail);
+
+    if (d2_tail < dist_min) {
+        dist_min = d2_tail;
+        *index = index_tail;
+    }
+
+    return dist_min;
+}
+
+/**
+ * AVX2 gradient of the distances or the pair energies.
+ */
+__attribute__((target("avx2,fma")))
+static struct vector_t gradientRow_avx2(const double *x, const double *y, const double *z,
+                                        int from, int to, const struct vector_t *point,
+                                        int energy)
+{
+    const __m256d scale = _mm256_set1_pd(energy ? -2.0 : 1.0);
+    __m256d px = _mm256_set1_pd(point->x);
+    __m256d py = _mm256_set1_pd(point->y);
+    __m256d pz = _mm256_set1_pd(point->z);
+    __m256d gx = _mm256_setzero_pd();
+    __m256d gy = _mm256_setzero_pd();
+    __m256d gz = _mm256_setzero_pd();
+    __m256d dx, dy, dz, d2, w;
+    struct vector_t gradient, rest;
+    double lanes[4];
+    int j = from;
+
+    for (; j + 4 <= to; j += 4) {
+        dx = _mm256_sub_pd(px, _mm256_loadu_pd(x + j));
+        dy = _mm256_sub_pd(py, _mm256_loadu_pd(y + j));
+        dz = _mm256_sub_pd(pz, _mm256_loadu_pd(z + j));
+        d2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        w = _mm256_div_pd(scale, energy ? d2 : _mm256_sqrt_pd(d2));
+        gx = _mm256_fmadd_pd(w, dx, gx);
+        gy = _mm256_fmadd_pd(w, dy, gy);
+        gz = _mm256_fmadd_pd(w, dz, gz);
+    }
+
+    rest = gradientRow_scalar(x, y, z, j, to, point, energy);
+
+    _mm256_storeu_pd(lanes, gx);
+    gradient.x = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + rest.x;
+    _mm256_storeu_pd(lanes, gy);
+    gradient.y = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + rest.y;
+    _mm256_storeu_pd(lanes, gz);
+    gradient.z = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + rest.z;
+
+    return gradient;
+}
+
+static const struct kernel_t kernel_avx2 = {
+    "avx2", distanceRow_avx2, energyRow_avx2, closestRow_avx2, gradientRow_avx2
+};
+
+
+/**
+ * AVX-512 sum of the euclidean distances. The remainder is handled with masked loads.
+ */
+__attribute__((target("avx512f")))
+static double distanceRow_avx512(const double *x, const double *y, const double *z,
+                                 int from, int to, const struct vector_t *point)
+{
+    __m512d px = _mm512_set1_pd(point->x);
+    __m512d py = _mm512_set1_pd(point->y);
+    __m512d pz = _mm512_set1_pd(point->z);
+    __m512d acc = _mm512_setzero_pd();
+    __m512d dx, dy, dz, d2;
+    __mmask8 mask;
+    int j = from;
+
+    for (; j + 8 <= to; j += 8) {
+        dx = _mm512_sub_pd(px, _mm512_loadu_pd(x + j));
+        dy = _mm512_sub_pd(py, _mm512_loadu_pd(y + j));
+        dz = _mm512_sub_pd(pz, _mm512_loadu_pd(z + j));
+        d2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        acc = _mm512_add_pd(acc, _mm512_sqrt_pd(d2));
+    }
+
+    if (j < to) {
+        mask = (__mmask8) ((1u << (to - j)) - 1);
+        dx = _mm512_sub_pd(px, _mm512_maskz_loadu_pd(mask, x + j));
+        dy = _mm512_sub_pd(py, _mm512_maskz_loadu_pd(mask, y + j));
+        dz = _mm512_sub_pd(pz, _mm512_maskz_loadu_pd(mask, z + j));
+        d2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        acc = _mm512_mask_add_pd(acc, mask, acc, _mm512_sqrt_pd(d2));
+    }
+
+    return _mm512_reduce_add_pd(acc);
+}
+
+/**
+ * AVX-512 sum of the pair energies. The exponents and mantissas are split with getexp and
+ * getmant, and the exponents are accumulated exactly as doubles. A coincident pair has an
+ * infinite energy, as in the scalar kernel.
+ */
+__attribute__((target("avx512f")))
+static double energyRow_avx512(const double *x, const double *y, const double *z,
+                               int from, int to, const struct vector_t *point)
+{
+    __m512d px = _mm512_set1_pd(point->x);
+    __m512d py = _mm512_set1_pd(point->y);
+    __m512d pz = _mm512_set1_pd(point->z);
+    __m512d prod = _mm512_set1_pd(1.0);
+    __m512d expo = _mm512_setzero_pd();
+    __m512d dx, dy, dz, d2;
+    __mmask8 mask;
+    __mmask8 coincident = 0;
+    double lanes[8], exponents[8];
+    double logSum = 0.0;
+    int j = from;
+    int l = 0;
+
+    for (; j + 8 <= to; j += 8) {
+        dx = _mm512_sub_pd(px, _mm512_loadu_pd(x + j));
+        dy = _mm512_sub_pd(py, _mm512_loadu_pd(y + j));
+        dz = _mm512_sub_pd(pz, _mm512_loadu_pd(z + j));
+        d2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        coincident |= _mm512_cmp_pd_mask(d2, _mm512_setzero_pd(), _CMP_EQ_OQ);
+        prod = _mm512_mul_pd(prod, d2);
+        expo = _mm512_add_pd(expo, _mm512_getexp_pd(prod));
+        prod = _mm512_getmant_pd(prod, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+    }
+
+    if (j < to) {
+        /* the masked lanes keep their product, whose exponent is zero */
+        mask = (__mmask8) ((1u << (to - j)) - 1);
+        dx = _mm512_sub_pd(px, _mm512_maskz_loadu_pd(mask, x + j));
+        dy = _mm512_sub_pd(py, _mm512_maskz_loadu_pd(mask, y + j));
+        dz = _mm512_sub_pd(pz, _mm512_maskz_loadu_pd(mask, z + j));
+        d2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        coincident |= _mm512_mask_cmp_pd_mask(mask, d2, _mm512_setzero_pd(), _CMP_EQ_OQ);
+        prod = _mm512_mask_mul_pd(prod, mask, prod, d2);
+        expo = _mm512_add_pd(expo, _mm512_getexp_pd(prod));
+        prod = _mm512_getmant_pd(prod, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+    }
+
+    if (coincident != 0) {
+        return HUGE_VAL;
+    }
+
+    _mm512_storeu_pd(lanes, prod);
+    _mm512_storeu_pd(exponents, expo);
+
+    for (l = 0; l < 8; l++) {
+        logSum += exponents[l] * M_LN2 + log(lanes[l]);
+    }
+
+    return -logSum;
+}
+
+/**
+ * AVX-512 search for the closest point. Ties are resolved towards the lower index.
+ */
+__attribute__((target("avx512f")))
+static double closestRow_avx512(const double *x, const double *y, const double *z,
+                                int from, int to, const struct vector_t *point, int *index)
+{
+    __m512d px = _mm512_set1_pd(point->x);
+    __m512d py = _mm512_set1_pd(point->y);
+    __m512d pz = _mm512_set1_pd(point->z);
+    __m512d best = _mm512_set1_pd(DBL_MAX);
+    __m512d bestIndex = _mm512_set1_pd(-1.0);
+    __m512d indices = _mm512_setr_pd(from, from + 1, from + 2, from + 3,
+                                     from + 4, from + 5, from + 6, from + 7);
+    const __m512d step = _mm512_set1_pd(8.0);
+    __m512d dx, dy, dz, d2;
+    __mmask8 mask, less;
+    double lanes[8], laneIndex[8];
+    double dist_min;
+    int j = from;
+    int l = 0;
+
+    for (; j < to; j += 8) {
+        mask = (to - j >= 8) ? (__mmask8) 0xFF : (__mmask8) ((1u << (to - j)) - 1);
+        dx = _mm512_sub_pd(px, _mm512_maskz_loadu_pd(mask, x + j));
+        dy = _mm512_sub_pd(py, _mm512_maskz_loadu_pd(mask, y + j));
+        dz = _mm512_sub_pd(pz, _mm512_maskz_loadu_pd(mask, z + j));
+        d2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        less = _mm512_mask_cmp_pd_mask(mask, d2, best, _CMP_LT_OQ);
+        best = _mm512_mask_blend_pd(less, best, d2);
+        bestIndex = _mm512_mask_blend_pd(less, bestIndex, indices);
+        indices = _mm512_add_pd(indices, step);
+    }
+
+    _mm512_storeu_pd(lanes, best);
+    _mm512_storeu_pd(laneIndex, bestIndex);
+
+    dist_min = DBL_MAX;
+    *index = -1;
+
+    for (l = 0; l < 8; l++) {
+        if (laneIndex[l] >= 0.0
+            && (lanes[l] < dist_min || (lanes[l] == dist_min && (int) laneIndex[l] < *index))) {
+            dist_min = lanes[l];
+            *index = (int) laneIndex[l];
+        }
+    }
+
+    return dist_min;
+}
+
+/**
+ * AVX-512 gradient of the distances or the pair energies. The remainder is handled with masked
+ * loads.
+ */
+__attribute__((target("avx512f")))
+static struct vector_t gradientRow_avx512(const double *x, const double *y, const double *z,
+                                          int from, int to, const struct vector_t *point,
+                                          int energy)
+{
+    const __m512d scale = _mm512_set1_pd(energy ? -2.0 : 1.0);
+    __m512d px = _mm512_set1_pd(point->x);
+    __m512d py = _mm512_set1_pd(point->y);
+    __m512d pz = _mm512_set1_pd(point->z);
+    __m512d gx = _mm512_setzero_pd();
+    __m512d gy = _mm512_setzero_pd();
+    __m512d gz = _mm512_setzero_pd();
+    __m512d dx, dy, dz, d2, w;
+    struct vector_t gradient;
+    __mmask8 mask;
+    int j = from;
+
+    for (; j + 8 <= to; j += 8) {
+        dx = _mm512_sub_pd(px, _mm512_loadu_pd(x + j));
+        dy = _mm512_sub_pd(py, _mm512_loadu_pd(y + j));
+        dz = _mm512_sub_pd(pz, _mm512_loadu_pd(z + j));
+        d2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        w = _mm512_div_pd(scale, energy ? d2 : _mm512_sqrt_pd(d2));
+        gx = _mm512_fmadd_pd(w, dx, gx);
+        gy = _mm512_fmadd_pd(w, dy, gy);
+        gz = _mm512_fmadd_pd(w, dz, gz);
+    }
+
+    if (j < to) {
+        mask = (__mmask8) ((1u << (to - j)) - 1);
+        dx = _mm512_sub_pd(px, _mm512_maskz_loadu_pd(mask, x + j));
+        dy = _mm512_sub_pd(py, _mm512_maskz_loadu_pd(mask, y + j));
+        dz = _mm512_sub_pd(pz, _mm512_maskz_loadu_pd(mask, z + j));
+        d2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        w = _mm512_div_pd(scale, energy ? d2 : _mm512_sqrt_pd(d2));
+        gx = _mm512_mask3_fmadd_pd(w, dx, gx, mask);
+        gy = _mm512_mask3_fmadd_pd(w, dy, gy, mask);
+        gz = _mm512_mask3_fmadd_pd(w, dz, gz, mask);
+    }
+
+    gradient.x = _mm512_reduce_add_pd(gx);
+    gradient.y = _mm512_reduce_add_pd(gy);
+    gradient.z = _mm512_reduce_add_pd(gz);
+
+    return gradient;
+}
+
+static const struct kernel_t kernel_avx512 = {
+    "avx512", distanceRow_avx512, energyRow_avx512, closestRow_avx512, gradientRow_avx512
+};
+
+#endif /* KERNEL_X86 */
+
+
+/**
+ * Select the kernel implementation for this CPU. The widest supported instruction set is used,
+ * unless the environment variable SA_KERNEL names a specific one. An unknown or unsupported
+ * kernel is reported, and the widest supported one is used instead. The kernels are selected
+ * once, on first use.
+ */
+static void selectKernel()
+{
+    const char *requested = getenv(KERNEL_ENV);
+    const struct kernel_t *widest = &kernel_scalar;
+    int known = 0;
+
+#ifdef KERNEL_X86
+    int avx2 = 0;
+    int avx512 = 0;
+
+    __builtin_cpu_init();
+    avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    avx512 = __builtin_cpu_supports("avx512f");
+    widest = avx512 ? &kernel_avx512 : (avx2 ? &kernel_avx2 : &kernel_scalar);
+#endif
+
+    kernel = widest;
+
+    if (requested == NULL) {
+        return;
+    }
+
+    if (strcmp(requested, kernel_scalar.name) == 0) {
+        kernel = &kernel_scalar;
+        return;
+    }
+
+#ifdef KERNEL_X86
+    if (strcmp(requested, kernel_avx2.name) == 0) {
+        known = 1;
+
+        if (avx2) {
+            kernel = &kernel_avx2;
+            return;
+        }
+    } else if (strcmp(requested, kernel_avx512.name) == 0) {
+        known = 1;
+
+        if (avx512) {
+            kernel = &kernel_avx512;
+            return;
+        }
+    }
+#endif
+
+    if (known) {
+        fprintf(stderr, "%s=%s is not supported by this CPU, using the %s kernel\n", KERNEL_ENV,
+                requested, kernel->name);
+    } else {
+        fprintf(stderr, "Unknown kernel %s=%s (scalar, avx2, or avx512), using the %s kernel\n",
+                KERNEL_ENV, requested, kernel->name);
+    }
+}
+
+/**
+ * @return the name of the selected kernel implementation
+ */
+const char *kernel_name()
+{
+    pthread_once(&selection, selectKernel);
+
+    return kernel->name;
+}
+
+/**
+ * Sum of the euclidean distances between a point and the stored points in [from, to).
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the first stored point
+ * @param const int one past the last stored point
+ * @param const struct vector_t *const the query point
+ * @return the sum of the distances
+ */
+double kernel_distanceRow(const struct points_t *const points, const int from, const int to,
+                          const struct vector_t *const point)
+{
+    pthread_once(&selection, selectKernel);
+
+    return kernel->distanceRow(points->x, points->y, points->z, from, to, point);
+}
+
+/**
+ * Sum of the pair energies \f$ \log{1 / \mid x - x_j \mid^2} \f$ between a point and the stored
+ * points in [from, to).
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the first stored point
+ * @param const int one past the last stored point
+ * @param const struct vector_t *const the query point
+ * @return the sum of the pair energies
+ */
+double kernel_energyRow(const struct points_t *const points, const int from, const int to,
+                        const struct vector_t *const point)
+{
+    pthread_once(&selection, selectKernel);
+
+    return kernel->energyRow(points->x, points->y, points->z, from, to, point);
+}
+
+/**
+ * Find the stored point in [from, to) that is closest to the query point.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the first stored point
+ * @param const int one past the last stored point
+ * @param const struct vector_t *const the query point
+ * @param int* the index of the closest point, or -1 if the range is empty
+ * @return the squared distance to the closest point
+ */
+double kernel_closestRow(const struct points_t *const points, const int from, const int to,
+                         const struct vector_t *const point, int *index)
+{
+    pthread_once(&selection, selectKernel);
+
+    return kernel->closestRow(points->x, points->y, points->z, from, to, point, index);
+}
+
+/**
+ * The distance contribution of a single point at the given position, i.e., the sum of the
+ * distances to all stored points except the one at the given index.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point to skip
+ * @param const struct vector_t *const the position of the point
+ * @return the sum of the distances
+ */
+double kernel_distanceTo(const struct points_t *const points, const int index,
+                         const struct vector_t *const point)
+{
+    return kernel_distanceRow(points, 0, index, point)
+        + kernel_distanceRow(points, index + 1, points->n, point);
+}
+
+/**
+ * The energy contribution of a single point at the given position, i.e., the sum of the pair
+ * energies with all stored points except the one at the given index.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point to skip
+ * @param const struct vector_t *const the position of the point
+ * @return the sum of the pair energies
+ */
+double kernel_energyTo(const struct points_t *const points, const int index,
+                       const struct vector_t *const point)
+{
+    return kernel_energyRow(points, 0, index, point)
+        + kernel_energyRow(points, index + 1, points->n, point);
+}
+
+/**
+ * Score a batch of positions of a single point. The stored points are visited in tiles of
+ * KERNEL_BATCH_TILE points, and every tile is scored against all positions while it is in the
+ * cache, so the store is read from memory once instead of once per position.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point to skip
+ * @param const struct vector_t *const the positions of the point
+ * @param const int number of positions
+ * @param double* the contribution of every position
+ * @param const int 1 for the energy, 0 for the distance
+ */
+static void batchTo(const struct points_t *const points, const int index,
+                    const struct vector_t *const candidates, const int count, double *result,
+                    const int energy)
+{
+    double (*row)(const double *, const double *, const double *, int, int,
+                  const struct vector_t *);
+    int from, to, c;
+
+    pthread_once(&selection, selectKernel);
+
+    row = energy ? kernel->energyRow : kernel->distanceRow;
+
+    for (c = 0; c < count; c++) {
+        result[c] = 0.0;
+    }
+
+    for (from = 0; from < points->n; from = to) {
+        to = (from + KERNEL_BATCH_TILE < points->n) ? from + KERNEL_BATCH_TILE : points->n;
+
+        for (c = 0; c < count; c++) {
+            if (index >= from && index < to) {
+                result[c] += row(points->x, points->y, points->z, from, index, &candidates[c])
+                    + row(points->x, points->y, points->z, index + 1, to, &candidates[c]);
+            } else {
+                result[c] += row(points->x, points->y, points->z, from, to, &candidates[c]);
+            }
+        }
+    }
+}
+
+/**
+ * The distance contributions of a batch of positions of a single point.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point to skip
+ * @param const struct vector_t *const the positions of the point
+ * @param const int number of positions
+ * @param double* the sum of the distances of every position
+ */
+void kernel_distanceBatchTo(const struct points_t *const points, const int index,
+                            const struct vector_t *const candidates, const int count,
+                            double *result)
+{
+    batchTo(points, index, candidates, count, result, 0);
+}
+
+/**
+ * The energy contributions of a batch of positions of a single point.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point to skip
+ * @param const struct vector_t *const the positions of the point
+ * @param const int number of positions
+ * @param double* the sum of the pair energies of every position
+ */
+void kernel_energyBatchTo(const struct points_t *const points, const int index,
+                          const struct vector_t *const candidates, const int count,
+                          double *result)
+{
+    batchTo(points, index, candidates, count, result, 1);
+}
+
+/**
+ * The gradient of the distance contribution of a single point at the given position with
+ * respect to its position.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point to skip
+ * @param const struct vector_t *const the position of the point
+ * @return the gradient of the sum of the distances
+ */
+struct vector_t kernel_distanceGradientTo(const struct points_t *const points, const int index,
+                                          const struct vector_t *const point)
+{
+    struct vector_t lower, upper;
+
+    pthread_once(&selection, selectKernel);
+
+    lower = kernel->gradientRow(points->x, points->y, points->z, 0, index, point, 0);
+    upper = kernel->gradientRow(points->x, points->y, points->z, index + 1, points->n, point, 0);
+    lower.x += upper.x;
+    lower.y += upper.y;
+    lower.z += upper.z;
+
+    return lower;
+}
+
+/**
+ * The gradient of the energy contribution of a single point at the given position with respect
+ * to its position.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point to skip
+ * @param const struct vector_t *const the position of the point
+ * @return the gradient of the sum of the pair energies
+ */
+struct vector_t kernel_energyGradientTo(const struct points_t *const points, const int index,
+                                        const struct vector_t *const point)
+{
+    struct vector_t lower, upper;
+
+    pthread_once(&selection, selectKernel);
+
+    lower = kernel->gradientRow(points->x, points->y, points->z, 0, index, point, 1);
+    upper = kernel->gradientRow(points->x, points->y, points->z, index + 1, points->n, point, 1);
+    lower.x += upper.x;
+    lower.y += upper.y;
+    lower.z += upper.z;
+
+    return lower;
+}
+
+/**
+ * The sum of the euclidean distances between any two stored points.
+ *
+ * @param const struct points_t *const the point store
+ * @return the sum of the distances
+ */
+double kernel_distance(const struct points_t *const points)
+{
+    struct vector_t point;
+    double dist = 0.0;
+    int i = 0;
+
+    for (i = 0; i < points->n - 1; i++) {
+        point = points_get(points, i);
+        dist += kernel_distanceRow(points, i + 1, points->n, &point);
+    }
+
+    return dist;
+}
+
+/**
+ * The logarithmic Riesz energy of the stored points.
+ *
+ * @param const struct points_t *const the point store
+ * @return the energy of the configuration
+ */
+double kernel_energy(const struct points_t *const points)
+{
+    struct vector_t point;
+    double energy = 0.0;
+    int i = 0;
+
+    for (i = 0; i < points->n - 1; i++) {
+        point = points_get(points, i);
+        energy += kernel_energyRow(points, i + 1, points->n, &point);
+    }
+
+    return energy;
+}
+
+/**
+ * Find the two stored points with the shortest distance to each other.
+ *
+ * @param const struct points_t *const the point store
+ * @param int* the array of indices for the two closest points
+ * @return the distance between the two closest points
+ */
+double kernel_closest(const struct points_t *const points, int *index_min)
+{
+    struct vector_t point;
+    double dist_min = DBL_MAX;
+    double dist;
+    int i = 0;
+    int j = 0;
+
+    index_min[0] = index_min[1] = -1;
+
+    for (i = 0; i < points->n - 1; i++) {
+        point = points_get(points, i);
+        dist = kernel_closestRow(points, i + 1, points->n, &point, &j);
+
+        if (dist < dist_min) {
+            dist_min = dist;
+            index_min[0] = i;
+            index_min[1] = j;
+        }
+    }
+
+    return sqrt(dist_min);
+}
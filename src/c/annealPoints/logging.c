@@ -1,8 +1,22 @@
 /**
  * Logging facility for the simulated annealing.
  *
+ * The annealing thread does not write to the log files itself. The logging functions push
+ * fixed-size records into a single-producer/single-consumer ring, which a writer thread drains
+ * into the trace and into fully buffered log files. Every run has log files of its own, and all
+ * logging functions of a run have to be called from the same thread.
+ *
+ * The proposals are sampled or aggregated per temperature level before they are pushed, so the
+ * annealing thread only hands over the records that end up in the trace, and the seconds of a
+ * level are taken by the annealing thread. If the ring is full, sampled proposals are dropped
+ * and counted, unless the logging blocks; the levels and the configurations are never dropped.
+ *
  * @author Dominik Dahlem
  */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,16 +25,55 @@
 #include <sys/stat.h>
 
 #include "logging.h"
+#include "ring.h"
+#include "trace.h"
 
 
 #define DATE_MAX_SIZE 15
 
 
 /**
- * log files for the simulation results, the best configuration, the initial configuration,
- * the parameters for a given simulation.
+ * The kind of a log record.
  */
-FILE *all, *best, *initial, *param;
+enum record_kind_t {
+    RECORD_SIM,
+    RECORD_LEVEL,
+    RECORD_BEST,
+    RECORD_INITIAL
+};
+
+/**
+ * A log record passed from the annealing thread to the writer thread.
+ */
+struct record_t {
+    enum record_kind_t kind; /** the kind of the record */
+    int accepted; /** flag indicating whether the proposal was accepted */
+    long iteration; /** the iteration */
+    union {
+        double v[4]; /** objective, delta, temperature, variance or x, y, z */
+        struct trace_level_t level; /** the aggregate of a temperature level */
+    } data;
+};
+
+
+/**
+ * The state of the log files of a run.
+ */
+struct logging_t {
+    FILE *best; /** log file of the best configuration */
+    FILE *initial; /** log file of the initial configuration */
+    FILE *param; /** log file of the parameters */
+    struct trace_t *trace; /** the trace of the simulation */
+    struct ring_t *ring; /** the ring buffer between the annealing thread and the writer thread */
+    pthread_t writer; /** the writer thread */
+    int writing; /** flag indicating that the writer thread is running */
+    atomic_int closing; /** flag telling the writer thread to drain the ring and terminate */
+    int blocking; /** flag to block the annealing thread instead of dropping trace records */
+    int sampling; /** push every sampling-th proposal, or aggregate the levels, if 0 */
+    struct trace_aggregate_t aggregate; /** the current level, kept by the annealing thread */
+    long dropped; /** number of dropped trace records */
+    char *directory; /** the time-stamped directory of the log files */
+};
 
 
 /**
@@ -31,171 +84,360 @@ FILE *all, *best, *initial, *param;
  * @param double the y-coordinate
  * @param double the z-coordinate
  */
-void logVector(FILE *file, double x, double y, double z)
+static void logVector(FILE *file, double x, double y, double z)
 {
     fprintf(file, "%f,%f,%f\n", x, y, z);
 }
 
 /**
- * Open the log files. This function is responsible of opening the three log files,
- * sim.log, best.log, and initial.log. Those log files are put into a time-stapmed
- * directory with the format YYYYMMDDhhmmss, so that we can run multiple simulations
- * without having to append to files and being able to correlate the parameters to
- * initial and best configurations.
+ * Write a record to its log file.
+ *
+ * @param struct logging_t *const the log files
+ * @param const struct record_t *const the record
+ */
+static void writeRecord(struct logging_t *const log, const struct record_t *const record)
+{
+    switch (record->kind) {
+        case RECORD_SIM:
+            trace_sample(log->trace, record->iteration, record->data.v[0], record->data.v[1],
+                         record->data.v[2], record->data.v[3], record->accepted);
+            break;
+        case RECORD_LEVEL:
+            trace_level(log->trace, &record->data.level);
+            break;
+        case RECORD_BEST:
+            logVector(log->best, record->data.v[0], record->data.v[1], record->data.v[2]);
+            break;
+        case RECORD_INITIAL:
+            logVector(log->initial, record->data.v[0], record->data.v[1], record->data.v[2]);
+            break;
+    }
+}
+
+/**
+ * The writer thread. It drains the ring, and sleeps while the ring is empty.
  *
- * @return int returns the status of the log files: 0 for failure, 1 for success.
+ * @param void* the log files
+ * @return void* NULL
  */
-int logging_open()
+static void *drain(void *arg)
+{
+    struct logging_t *log = (struct logging_t *) arg;
+    struct timespec idle = {0, LOGGING_IDLE};
+    struct record_t record;
+    int last = 0;
+
+    for (;;) {
+        /* records pushed before the closing flag was raised are still picked up */
+        last = atomic_load_explicit(&log->closing, memory_order_acquire);
+
+        while (ring_pop(log->ring, &record) == SUCCESS) {
+            writeRecord(log, &record);
+        }
+
+        if (last) {
+            return NULL;
+        }
+
+        nanosleep(&idle, NULL);
+    }
+}
+
+/**
+ * Hand a record to the writer thread. Sampled proposals are dropped, if the ring is full and the
+ * logging does not block.
+ *
+ * @param struct logging_t *const the log files
+ * @param const struct record_t *const the record
+ */
+static void push(struct logging_t *const log, const struct record_t *const record)
+{
+    while (ring_push(log->ring, record) == FAIL) {
+        if (record->kind == RECORD_SIM && !log->blocking) {
+            log->dropped++;
+            return;
+        }
+
+        sched_yield();
+    }
+}
+
+/**
+ * Create a new time-stamped log directory with the format YYYYMMDDhhmmss. If the directory of
+ * the current second exists already, a counter is appended (YYYYMMDDhhmmss-1, -2, ...), so that
+ * runs starting in the same second, also in different processes, never share a directory.
+ *
+ * @return char* the name of the directory (to be freed) or NULL, if it could not be created
+ */
+char *logging_createDirectory()
 {
     time_t time_now;
-    struct tm *time_ptr;
-    int status;
+    struct tm time_parts;
     char time_str[DATE_MAX_SIZE];
-    const char *log_base_dir = "./log/";
-    const char *log_sim_name = "/sim.log";
-    const char *log_best_name = "/best.log";
-    const char *log_initial_name = "/initial.log";
-    const char *log_param_name = "/param.log";
-    char *log_dir, *log_sim, *log_best, *log_initial, *log_param;
-    int logdirSize;
+    size_t size = strlen(LOGGING_BASE) + DATE_MAX_SIZE + 16;
+    char *dir = (char *) malloc(size * sizeof(char));
+    int suffix = 0;
 
+    if (dir == NULL) {
+        return NULL;
+    }
 
-    /* we go through a bit of labour to create a time-stamped directory */
     /* get the current time */
     time(&time_now);
-    time_ptr = gmtime(&time_now);
-    strftime(time_str, DATE_MAX_SIZE, "%Y%m%d%H%M%S", time_ptr);
-
-    /* allocate memory for the file names */
-    logdirSize = (strlen(log_base_dir) + strlen(time_str) + 1);
-    log_dir = (char *) malloc(logdirSize * sizeof(char));
-    log_sim = (char *) malloc((logdirSize + strlen(log_sim_name)) * sizeof(char));
-    log_best = (char *) malloc((logdirSize + strlen(log_best_name)) * sizeof(char));
-    log_initial = (char *) malloc((logdirSize + strlen(log_initial_name)) * sizeof(char));
-    log_param = (char *) malloc((logdirSize + strlen(log_param_name)) * sizeof(char));
-
-    /* initialise the char* */
-    memset(log_dir, '\0', logdirSize);
-    memset(log_sim, '\0', logdirSize + strlen(log_sim_name));
-    memset(log_best, '\0', logdirSize + strlen(log_best_name));
-    memset(log_initial, '\0', logdirSize + strlen(log_initial_name));
-    memset(log_param, '\0', logdirSize + strlen(log_param_name));
+    gmtime_r(&time_now, &time_parts);
+    strftime(time_str, DATE_MAX_SIZE, "%Y%m%d%H%M%S", &time_parts);
 
-    /* construct the file names */
-    strcat(log_dir, log_base_dir);
-    strcat(log_dir, time_str);
-    strcat(log_sim, log_dir);
-    strcat(log_sim, log_sim_name);
-    strcat(log_best, log_dir);
-    strcat(log_best, log_best_name);
-    strcat(log_initial, log_dir);
-    strcat(log_initial, log_initial_name);
-    strcat(log_param, log_dir);
-    strcat(log_param, log_param_name);
-
-    /* create directory with mode 700 */
-    status = mkdir(log_dir, S_IRWXU);
-
-    if (status == FAIL) {
-        fprintf(stderr, "Could not create directory %s\n", log_dir);
-    } else {
-        all = fopen(log_sim, "w");
-        best = fopen(log_best, "w");
-        initial = fopen(log_initial, "w");
-        param = fopen(log_param, "w");
-
-        if ((all != NULL) && (best != NULL) && (initial != NULL) && (param != NULL)) {
-            fprintf(all, "Iteration,Distance,DistanceDelta,Temperature,Variance,Accepted\n");
-            fprintf(best, "x,y,z\n");
-            fprintf(initial, "x,y,z\n");
-            fprintf(param, "RandomNum,Iteration,Points,TMax,TDamping,"
-                    "UniformInitialConfiguration\n");
-            status = SUCCESS;
+    /* creating the directory fails, if another run has created it before */
+    for (suffix = 0; suffix < LOGGING_SUFFIXES; suffix++) {
+        if (suffix == 0) {
+            snprintf(dir, size, "%s%s", LOGGING_BASE, time_str);
         } else {
-            logging_close();
-            status = FAIL;
+            snprintf(dir, size, "%s%s-%d", LOGGING_BASE, time_str, suffix);
+        }
+
+        /* create directory with mode 700 */
+        if (mkdir(dir, S_IRWXU) == 0) {
+            return dir;
+        }
+
+        if (errno != EEXIST) {
+            break;
         }
     }
 
+    fprintf(stderr, "Could not create directory %s\n", dir);
+    free(dir);
+
+    return NULL;
+}
+
+/**
+ * The name of a file in a directory.
+ *
+ * @param const char *const the directory
+ * @param const char *const the name of the file
+ * @return char* the path of the file (to be freed) or NULL, if the memory could not be allocated
+ */
+static char *path(const char *const dir, const char *const name)
+{
+    size_t size = strlen(dir) + strlen(name) + 2;
+    char *file = (char *) malloc(size * sizeof(char));
+
+    if (file != NULL) {
+        snprintf(file, size, "%s/%s", dir, name);
+    }
+
+    return file;
+}
+
+/**
+ * Open the log files. This function is responsible of opening the trace sim.trace and the log
+ * files best.log, initial.log, and param.log. Those log files are put into a time-stamped
+ * directory (see logging_createDirectory), so that we can run multiple simulations
+ * without having to append to files and being able to correlate the parameters to
+ * initial and best configurations.
+ *
+ * @param const int record every sampling-th proposal in the trace, or aggregate the temperature
+ *        levels, if 0
+ * @param const int flag to block instead of dropping trace records, if the writer falls behind
+ * @return struct logging_t* the log files or NULL, if they could not be opened
+ */
+struct logging_t *logging_open(const int sampling, const int block)
+{
+    struct logging_t *log;
+    char *log_sim, *log_best, *log_initial, *log_param;
+    int status = FAIL;
+
+    log = (struct logging_t *) calloc(1, sizeof(struct logging_t));
+
+    if (log == NULL) {
+        return NULL;
+    }
+
+    /* the directory is kept for logging_directory */
+    log->directory = logging_createDirectory();
+
+    if (log->directory == NULL) {
+        free(log);
+        return NULL;
+    }
+
+    /* construct the file names */
+    log_sim = path(log->directory, "sim.trace");
+    log_best = path(log->directory, "best.log");
+    log_initial = path(log->directory, "initial.log");
+    log_param = path(log->directory, "param.log");
+
+    if ((log_sim != NULL) && (log_best != NULL) && (log_initial != NULL) && (log_param != NULL)) {
+        log->trace = trace_open(log_sim, sampling);
+        log->best = fopen(log_best, "w");
+        log->initial = fopen(log_initial, "w");
+        log->param = fopen(log_param, "w");
+        log->ring = ring_create(LOGGING_RING, sizeof(struct record_t));
+    }
+
+    if ((log->trace != NULL) && (log->best != NULL) && (log->initial != NULL)
+        && (log->param != NULL) && (log->ring != NULL)) {
+        setvbuf(log->best, NULL, _IOFBF, LOGGING_BUFFER);
+        setvbuf(log->initial, NULL, _IOFBF, LOGGING_BUFFER);
+        fprintf(log->best, "x,y,z\n");
+        fprintf(log->initial, "x,y,z\n");
+        fprintf(log->param, "RandomNum,Iteration,Points,TMax,TDamping,"
+                "UniformInitialConfiguration,InitialAcceptance\n");
+
+        log->blocking = block;
+        log->sampling = (sampling > 0) ? sampling : 0;
+        atomic_store(&log->closing, 0);
+        log->writing = (pthread_create(&log->writer, NULL, drain, log) == 0);
+        status = log->writing ? SUCCESS : FAIL;
+    }
+
     /* free up the memory again */
-    free(log_dir);
     free(log_sim);
     free(log_best);
     free(log_initial);
     free(log_param);
 
-    return status;
+    if (status != SUCCESS) {
+        logging_close(log);
+        return NULL;
+    }
+
+    return log;
 }
 
 /**
- * Close the log files.
+ * Wait for the writer thread to write all records, and close the log files.
+ *
+ * @param struct logging_t* the log files (may be NULL)
  */
-void logging_close()
+void logging_close(struct logging_t *log)
 {
-    if (all != NULL) {
-        fclose(all);
+    struct record_t record;
+
+    if (log == NULL) {
+        return;
     }
-    if (best != NULL) {
-        fclose(best);
+
+    if (log->writing) {
+        /* the last level is complete once the run is over */
+        record.kind = RECORD_LEVEL;
+
+        if (log->sampling == 0 && trace_finish(&log->aggregate, &record.data.level)) {
+            push(log, &record);
+        }
+
+        atomic_store_explicit(&log->closing, 1, memory_order_release);
+        pthread_join(log->writer, NULL);
+
+        if (log->dropped > 0) {
+            fprintf(stderr, "Dropped %ld trace records, the writer could not keep up\n",
+                    log->dropped);
+        }
     }
-    if (initial != NULL) {
-        fclose(initial);
+
+    ring_destroy(log->ring);
+    trace_close(log->trace);
+    if (log->best != NULL) {
+        fclose(log->best);
     }
-    if (param != NULL) {
-        fclose(param);
+    if (log->initial != NULL) {
+        fclose(log->initial);
     }
+    if (log->param != NULL) {
+        fclose(log->param);
+    }
+
+    free(log->directory);
+    free(log);
+}
+
+/**
+ * @param const struct logging_t *const the log files
+ * @return the directory of the log files
+ */
+const char *logging_directory(const struct logging_t *const log)
+{
+    return log->directory;
 }
 
 /**
  * Log the best result at the end of the simulation.
  *
+ * @param struct logging_t *const the log files
  * @param long the random seed
  * @param int the iteration of the inner loop
  * @param int the number of points
  * @param double the initial temperature setting
  * @param double the damping factor
  * @param int flag indicating the initial method of distributing points across the sphere
+ * @param double the initial acceptance ratio the temperature was estimated for (0, if it was
+ *        given)
  */
-void logging_logParam(long seed, int iteration, int points, double initialTemperature,
-                      double damping, int uniform)
+void logging_logParam(struct logging_t *const log, long seed, int iteration, int points,
+                      double initialTemperature, double damping, int uniform,
+                      double initialAcceptance)
 {
-    fprintf(param, "%ld,%d,%d,%f,%f,%d\n",
+    fprintf(log->param, "%ld,%d,%d,%f,%f,%d,%f\n",
             seed, iteration, points, initialTemperature,
-            damping, uniform);
+            damping, uniform, initialAcceptance);
 }
 
 /**
  * Log the best result at the end of the simulation.
  *
+ * @param struct logging_t *const the log files
  * @param double the x-coordinate
  * @param double the y-coordinate
  * @param double the z-coordinate
  */
-void logging_logBest(double x, double y, double z)
+void logging_logBest(struct logging_t *const log, double x, double y, double z)
 {
-    logVector(best, x, y, z);
+    struct record_t record = {RECORD_BEST, 0, 0, {{x, y, z, 0.0}}};
+
+    push(log, &record);
 }
 
 /**
  * Log the initial configuration before starting the simulation.
  *
+ * @param struct logging_t *const the log files
  * @param double the x-coordinate
  * @param double the y-coordinate
  * @param double the z-coordinate
  */
-void logging_logInitial(double x, double y, double z)
+void logging_logInitial(struct logging_t *const log, double x, double y, double z)
 {
-    logVector(initial, x, y, z);
+    struct record_t record = {RECORD_INITIAL, 0, 0, {{x, y, z, 0.0}}};
+
+    push(log, &record);
 }
 
 /**
- * Logging throughout the simulation.
+ * Logging throughout the simulation. Every sampling-th proposal is handed to the writer, or the
+ * proposals are aggregated and the levels handed to the writer once they are complete.
  *
+ * @param struct logging_t *const the log files
+ * @param long the iteration
  * @param double the best distance
+ * @param double the change of the distance
  * @param double the current temperature
  * @param double the variance of the random walk distance
+ * @param int flag indicating whether the proposal was accepted
  */
-void logging_logSim(long iteration, double bestDistance, double deltaDistance, double temperature, double variance, int accepted)
+void logging_logSim(struct logging_t *const log, long iteration, double bestDistance,
+                    double deltaDistance, double temperature, double variance, int accepted)
 {
-    fprintf(all, "%ld,%f,%f,%f,%f,%d\n", iteration, bestDistance, deltaDistance, temperature, variance, accepted);
+    struct record_t record = {RECORD_SIM, accepted, iteration,
+                              {{bestDistance, deltaDistance, temperature, variance}}};
+
+    if (log->sampling > 0) {
+        if (iteration % log->sampling == 0) {
+            push(log, &record);
+        }
+    } else if (trace_aggregate(&log->aggregate, iteration, bestDistance, temperature, variance,
+                               accepted, &record.data.level)) {
+        record.kind = RECORD_LEVEL;
+        push(log, &record);
+    }
 }
@@ -0,0 +1,152 @@
+/**
+ * This module implements multiple-try Metropolis proposals (Liu, Liang and Wong 2000). Instead
+ * of a single random walk, K candidate positions of the selected point are drawn, and one of
+ * them is selected with a probability proportional to its Boltzmann weight
+ * \f$ w(y) = \exp(\pm (f(y) - f(x)) / T) \f$. To keep the detailed balance, K-1 reference
+ * positions are drawn around the selected candidate, and the move is accepted with probability
+ * \f$ \min(1, \sum_j w(y_j) / (\sum_{j<K} w(x^*_j) + w(x))) \f$. The random walk is symmetric, so
+ * the proposal densities cancel.
+ *
+ * The current position is scored in the same batch as the candidates, and the references in a
+ * second batch, so a proposal reads the configuration twice, like a plain Metropolis step, but
+ * looks at K positions. At low temperatures, where almost every single random walk is rejected,
+ * the best of K candidates is accepted much more often.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdlib.h>
+
+#include "mtm.h"
+#include "rng.h"
+#include "sphere.h"
+#include "vector.h"
+
+
+/**
+ * The state of multiple-try Metropolis proposals.
+ */
+struct mtm_t {
+    int tries; /** number of candidates K */
+    int sense; /** 1, if the objective is maximised, -1 if it is minimised */
+    mtm_score_t score; /** scores a batch of positions */
+    void *arg; /** the argument of the scoring function */
+    struct vector_t *positions; /** the candidates followed by the current position */
+    double *values; /** the contributions of the candidates and the current position */
+    double *weights; /** the logarithmic weights of the candidates */
+};
+
+
+/**
+ * Create the state of multiple-try Metropolis proposals.
+ *
+ * @param const int number of candidates K (2 to MTM_MAX_TRIES)
+ * @param const int 1, if the objective is maximised, -1 if it is minimised
+ * @param mtm_score_t the function scoring a batch of positions
+ * @param void* the argument of the scoring function
+ * @return struct mtm_t* the state or NULL, if the memory could not be allocated
+ */
+struct mtm_t *mtm_create(const int tries, const int sense, mtm_score_t score, void *arg)
+{
+    struct mtm_t *mtm = (struct mtm_t *) malloc(sizeof(struct mtm_t));
+
+    if (mtm == NULL) {
+        return NULL;
+    }
+
+    mtm->positions = (struct vector_t *) malloc((tries + 1) * sizeof(struct vector_t));
+    mtm->values = (double *) malloc((tries + 1) * sizeof(double));
+    mtm->weights = (double *) malloc(tries * sizeof(double));
+
+    if (mtm->positions == NULL || mtm->values == NULL || mtm->weights == NULL) {
+        mtm_destroy(mtm);
+        return NULL;
+    }
+
+    mtm->tries = tries;
+    mtm->sense = sense;
+    mtm->score = score;
+    mtm->arg = arg;
+
+    return mtm;
+}
+
+/**
+ * Destroy the state of multiple-try Metropolis proposals.
+ *
+ * @param struct mtm_t* the state (may be NULL)
+ */
+void mtm_destroy(struct mtm_t *mtm)
+{
+    if (mtm != NULL) {
+        free(mtm->positions);
+        free(mtm->values);
+        free(mtm->weights);
+        free(mtm);
+    }
+}
+
+/**
+ * Draw K candidates for a point, select one, and decide whether to accept it.
+ *
+ * @param struct mtm_t *const the state
+ * @param const int the index of the point
+ * @param const struct vector_t *const the current position of the point
+ * @param const double the variance of the random walk
+ * @param const double the temperature
+ * @param struct rng_t *const the random number generator
+ * @param struct vector_t *const the selected candidate
+ * @param double* the change of the objective, if the candidate is accepted
+ * @return 1, if the candidate is accepted, 0 otherwise
+ */
+int mtm_propose(struct mtm_t *const mtm, const int index, const struct vector_t *const current,
+                const double variance, const double temperature, struct rng_t *const rng,
+                struct vector_t *const chosen, double *delta)
+{
+    const int tries = mtm->tries;
+    double max, forward, backward, u;
+    int c, selected;
+
+    for (c = 0; c < tries; c++) {
+        mtm->positions[c] = sphere_walk(current, variance, rng);
+    }
+    mtm->positions[tries] = *current;
+
+    mtm->score(mtm->arg, index, mtm->positions, tries + 1, mtm->values);
+
+    /* the weights relative to the current position, shifted by their maximum for the sums */
+    max = 0.0;
+    for (c = 0; c < tries; c++) {
+        mtm->weights[c] = mtm->sense * (mtm->values[c] - mtm->values[tries]) / temperature;
+        max = (mtm->weights[c] > max) ? mtm->weights[c] : max;
+    }
+
+    forward = 0.0;
+    for (c = 0; c < tries; c++) {
+        mtm->weights[c] = exp(mtm->weights[c] - max);
+        forward += mtm->weights[c];
+    }
+
+    /* select a candidate proportional to its weight */
+    u = rng_uniform(rng) * forward;
+    for (selected = 0; selected < tries - 1 && u >= mtm->weights[selected]; selected++) {
+        u -= mtm->weights[selected];
+    }
+
+    *chosen = mtm->positions[selected];
+    *delta = mtm->values[selected] - mtm->values[tries];
+
+    /* the reference positions around the selected candidate, completed by the current one */
+    for (c = 0; c < tries - 1; c++) {
+        mtm->positions[c] = sphere_walk(chosen, variance, rng);
+    }
+
+    mtm->score(mtm->arg, index, mtm->positions, tries - 1, mtm->values);
+
+    backward = exp(-max);
+    for (c = 0; c < tries - 1; c++) {
+        backward += exp(mtm->sense * (mtm->values[c] - mtm->values[tries]) / temperature - max);
+    }
+
+    return forward >= backward || rng_uniform(rng) * backward < forward;
+}
@@ -0,0 +1,215 @@
+/**
+ * This module collects the counters and cycle timers of the annealing loops. It is only compiled
+ * with SA_PERF defined (make PERF=1); otherwise the macros of perf.h expand to nothing and the
+ * loops carry no instrumentation at all.
+ *
+ * The timers accumulate time stamp counter ticks. They are converted into seconds with the rate
+ * of the counter measured against the monotonic clock over the whole run. Every run counts into
+ * the accumulators it is given with its output, which are attached to the thread running it for
+ * the duration of the run. Runs on different threads thus neither race nor mix their counts, and
+ * the accumulators need no synchronisation.
+ *
+ * @author Dominik Dahlem
+ */
+#ifdef SA_PERF
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "perf.h"
+
+
+/**
+ * The names of the phases in the report.
+ */
+static const char *phases[PERF_PHASES] = {
+    "propose", "evaluate", "commit", "best", "logging", "resync", "checkpoint"
+};
+
+/**
+ * The names of the counters in the report.
+ */
+static const char *counters[PERF_COUNTERS] = {
+    "proposals", "accepted", "levels"
+};
+
+/**
+ * The counters and cycle timers of a run.
+ */
+struct perf_t {
+    uint64_t ticks[PERF_PHASES]; /** the accumulated ticks of every phase */
+    long calls[PERF_PHASES]; /** the number of timed sections of every phase */
+    long events[PERF_COUNTERS]; /** the events of every counter */
+    uint64_t tsc_start, tsc_stop; /** the time stamp counter at the start and the end */
+    struct timespec wall_start, wall_stop; /** the monotonic clock at the start and the end */
+};
+
+/**
+ * The accumulators of the run on this thread (NULL, if the run is not counted).
+ */
+static __thread struct perf_t *current = NULL;
+
+
+/**
+ * @return the seconds between two points in time
+ */
+static double seconds(const struct timespec *const from, const struct timespec *const to)
+{
+    return (double) (to->tv_sec - from->tv_sec) + 1e-9 * (double) (to->tv_nsec - from->tv_nsec);
+}
+
+/**
+ * Create the accumulators of a run.
+ *
+ * @return struct perf_t* the accumulators or NULL, if the memory could not be allocated
+ */
+struct perf_t *perf_create()
+{
+    return (struct perf_t *) calloc(1, sizeof(struct perf_t));
+}
+
+/**
+ * Destroy the accumulators of a run.
+ *
+ * @param struct perf_t* the accumulators (may be NULL)
+ */
+void perf_destroy(struct perf_t *perf)
+{
+    free(perf);
+}
+
+/**
+ * Reset the accumulators, attach them to the calling thread, and start the clock of the run.
+ *
+ * @param struct perf_t *const the accumulators (NULL for a run that is not counted)
+ */
+void perf_attach(struct perf_t *const perf)
+{
+    current = perf;
+
+    if (perf != NULL) {
+        memset(perf, 0, sizeof(struct perf_t));
+        clock_gettime(CLOCK_MONOTONIC, &perf->wall_start);
+        perf->tsc_start = __rdtsc();
+    }
+}
+
+/**
+ * Stop the clock of the run on the calling thread and detach its accumulators.
+ */
+void perf_detach()
+{
+    if (current != NULL) {
+        current->tsc_stop = __rdtsc();
+        clock_gettime(CLOCK_MONOTONIC, &current->wall_stop);
+    }
+
+    current = NULL;
+}
+
+/**
+ * Add the ticks of a timed section to its phase.
+ *
+ * @param const enum perf_phase_t the phase
+ * @param const uint64_t the ticks of the section
+ */
+void perf_add(const enum perf_phase_t phase, const uint64_t cycles)
+{
+    if (current != NULL) {
+        current->ticks[phase] += cycles;
+        current->calls[phase]++;
+    }
+}
+
+/**
+ * Count events.
+ *
+ * @param const enum perf_counter_t the counter
+ * @param const long number of events
+ */
+void perf_count(const enum perf_counter_t counter, const long n)
+{
+    if (current != NULL) {
+        current->events[counter] += n;
+    }
+}
+
+/**
+ * Write the report of a run into perf.log of the given directory, and a one-line summary to
+ * stderr.
+ *
+ * @param const struct perf_t *const the accumulators of the run (may be NULL)
+ * @param const char *const the log directory (NULL for the summary only)
+ */
+void perf_report(const struct perf_t *const perf, const char *const dir)
+{
+    const uint64_t *ticks;
+    const long *calls, *events;
+    double wall = 0.0;
+    double rate = 1.0;
+    double timed = 0.0;
+    double share[PERF_PHASES];
+    char *name;
+    FILE *file = NULL;
+    int p = 0;
+
+    if (perf == NULL) {
+        return;
+    }
+
+    ticks = perf->ticks;
+    calls = perf->calls;
+    events = perf->events;
+    wall = seconds(&perf->wall_start, &perf->wall_stop);
+    rate = (wall > 0.0) ? (double) (perf->tsc_stop - perf->tsc_start) / wall : 1.0;
+
+    for (p = 0; p < PERF_PHASES; p++) {
+        share[p] = (wall > 0.0) ? (double) ticks[p] / rate / wall : 0.0;
+        timed += share[p];
+    }
+
+    if (dir != NULL) {
+        name = (char *) malloc(strlen(dir) + strlen("/perf.log") + 1);
+
+        if (name != NULL) {
+            sprintf(name, "%s/perf.log", dir);
+            file = fopen(name, "w");
+            free(name);
+        }
+    }
+
+    if (file != NULL) {
+        fprintf(file, "Name,Count,Seconds,Share,NanosecondsPerCall\n");
+
+        for (p = 0; p < PERF_PHASES; p++) {
+            fprintf(file, "%s,%ld,%f,%f,%f\n", phases[p], calls[p], share[p] * wall, share[p],
+                    (calls[p] > 0) ? 1e9 * share[p] * wall / (double) calls[p] : 0.0);
+        }
+
+        fprintf(file, "other,,%f,%f,\n", (1.0 - timed) * wall, 1.0 - timed);
+        fprintf(file, "total,%ld,%f,1.0,%f\n", events[PERF_PROPOSALS], wall,
+                (events[PERF_PROPOSALS] > 0) ? 1e9 * wall / (double) events[PERF_PROPOSALS] : 0.0);
+
+        /* the counters only have a count */
+        for (p = 0; p < PERF_COUNTERS; p++) {
+            fprintf(file, "%s,%ld,,,\n", counters[p], events[p]);
+        }
+
+        fclose(file);
+    }
+
+    fprintf(stderr, "perf: %.3fs, %.0f proposals/s, acceptance %.3f, evaluate %.0f%%, "
+            "propose %.0f%%, commit %.0f%%, best %.0f%%, logging %.0f%%, resync %.0f%%\n",
+            wall, (wall > 0.0) ? (double) events[PERF_PROPOSALS] / wall : 0.0,
+            (events[PERF_PROPOSALS] > 0)
+            ? (double) events[PERF_ACCEPTED] / (double) events[PERF_PROPOSALS] : 0.0,
+            100.0 * share[PERF_EVALUATE], 100.0 * share[PERF_PROPOSE],
+            100.0 * share[PERF_COMMIT], 100.0 * share[PERF_BEST],
+            100.0 * share[PERF_LOGGING], 100.0 * share[PERF_RESYNC]);
+}
+
+#endif /* SA_PERF */
@@ -0,0 +1,133 @@
+/**
+ * This module provides the structure-of-arrays store for points on the sphere.
+ *
+ * @author Dominik Dahlem
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "points.h"
+#include "vector.h"
+
+
+/**
+ * Allocate the coordinate arrays for the given number of points. All three arrays live in one
+ * aligned block and the padding beyond the last point is zeroed.
+ *
+ * @param struct points_t *const the point store to be allocated
+ * @param const int the number of points
+ * @return int SUCCESS or FAIL, if the memory could not be allocated
+ */
+int points_alloc(struct points_t *const points, const int n)
+{
+    void *block = NULL;
+    int capacity;
+
+    capacity = ((n + POINTS_PADDING - 1) / POINTS_PADDING) * POINTS_PADDING;
+
+    if (capacity == 0) {
+        capacity = POINTS_PADDING;
+    }
+
+    if (posix_memalign(&block, POINTS_ALIGNMENT, 3 * capacity * sizeof(double)) != 0) {
+        points->x = points->y = points->z = NULL;
+        points->n = points->capacity = 0;
+        return FAIL;
+    }
+
+    memset(block, 0, 3 * capacity * sizeof(double));
+
+    points->x = (double *) block;
+    points->y = points->x + capacity;
+    points->z = points->y + capacity;
+    points->n = n;
+    points->capacity = capacity;
+
+    return SUCCESS;
+}
+
+/**
+ * Free the coordinate arrays of the point store.
+ *
+ * @param struct points_t *const the point store
+ */
+void points_free(struct points_t *const points)
+{
+    free(points->x);
+
+    points->x = points->y = points->z = NULL;
+    points->n = points->capacity = 0;
+}
+
+/**
+ * Set the point at the given index.
+ *
+ * @param struct points_t *const the point store
+ * @param const int the index of the point
+ * @param const struct vector_t *const the new coordinates
+ */
+void points_set(struct points_t *const points, const int index, const struct vector_t *const vector)
+{
+    assert(index >= 0 && index < points->n);
+
+    points->x[index] = vector->x;
+    points->y[index] = vector->y;
+    points->z[index] = vector->z;
+}
+
+/**
+ * Get the point at the given index.
+ *
+ * @param const struct points_t *const the point store
+ * @param const int the index of the point
+ * @return struct vector_t the coordinates of the point
+ */
+struct vector_t points_get(const struct points_t *const points, const int index)
+{
+    struct vector_t vector;
+
+    assert(index >= 0 && index < points->n);
+
+    vector.x = points->x[index];
+    vector.y = points->y[index];
+    vector.z = points->z[index];
+
+    return vector;
+}
+
+/**
+ * Fill the point store from an array of vectors. The store has to be allocated for the
+ * number of points to copy.
+ *
+ * @param struct points_t *const the point store
+ * @param const struct vector_t *const the vector array of size points->n
+ */
+void points_fromVectors(struct points_t *const points, const struct vector_t *const vectors)
+{
+    int i = 0;
+
+    for (i = 0; i < points->n; i++) {
+        points->x[i] = (vectors + i)->x;
+        points->y[i] = (vectors + i)->y;
+        points->z[i] = (vectors + i)->z;
+    }
+}
+
+/**
+ * Copy the point store into an array of vectors.
+ *
+ * @param const struct points_t *const the point store
+ * @param struct vector_t *const the vector array of size points->n
+ */
+void points_toVectors(const struct points_t *const points, struct vector_t *const vectors)
+{
+    int i = 0;
+
+    for (i = 0; i < points->n; i++) {
+        (vectors + i)->x = points->x[i];
+        (vectors + i)->y = points->y[i];
+        (vectors + i)->z = points->z[i];
+    }
+}
@@ -0,0 +1,331 @@
+/**
+ * This module polishes the best configuration of the annealing with a Riemannian L-BFGS descent
+ * on the product of unit spheres. The annealing gets close to a good minimum, but the last
+ * digits of the objective are only reached by an exponentially slow random walk at low
+ * temperatures. The analytic gradients converge to the nearest stationary point in a few
+ * hundred iterations instead.
+ *
+ * The euclidean gradient of every point is projected onto the tangent plane of the sphere at the
+ * point, \f$ g - (g \cdot x) x \f$, and a step is mapped back onto the sphere by normalising
+ * every point (retraction). The correction pairs of the L-BFGS recursion are transported to the
+ * tangent planes of the new configuration by the same projection. The step length is found by
+ * backtracking until the Armijo condition holds.
+ *
+ * All objectives are minimised, i.e., the sum of the distances enters with a negative sign.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdlib.h>
+
+#include "eval.h"
+#include "global.h"
+#include "logging.h"
+#include "points.h"
+#include "polish.h"
+#include "pool.h"
+#include "vector.h"
+
+
+/**
+ * The objective of the descent.
+ */
+struct polish_t {
+    struct pool_t *pool; /** the thread pool */
+    struct points_t store; /** the configuration last evaluated */
+    enum objective_t objective; /** the objective */
+    int n; /** number of points */
+};
+
+
+/**
+ * The cost of a configuration.
+ *
+ * @param struct polish_t *const the objective
+ * @param const struct vector_t *const the configuration
+ * @return the energy or the negative sum of the distances
+ */
+static double cost(struct polish_t *const polish, const struct vector_t *const points)
+{
+    points_fromVectors(&polish->store, points);
+
+    if (polish->objective == OBJECTIVE_ENERGY) {
+        return eval_energy(polish->pool, &polish->store);
+    }
+
+    return -eval_distance(polish->pool, &polish->store);
+}
+
+/**
+ * Project every vector onto the tangent plane of the sphere at the corresponding point.
+ *
+ * @param const struct vector_t *const the points
+ * @param struct vector_t *const the vectors
+ * @param const int number of points
+ */
+static void project(const struct vector_t *const points, struct vector_t *const vectors,
+                    const int n)
+{
+    double radial;
+    int i = 0;
+
+    for (i = 0; i < n; i++) {
+        radial = vector_dotProduct(&vectors[i], &points[i]);
+        vectors[i].x -= radial * points[i].x;
+        vectors[i].y -= radial * points[i].y;
+        vectors[i].z -= radial * points[i].z;
+    }
+}
+
+/**
+ * The Riemannian gradient of the cost of the configuration last evaluated with cost().
+ *
+ * @param struct polish_t *const the objective
+ * @param const struct vector_t *const the configuration
+ * @param struct vector_t *const the gradient
+ */
+static void gradient(struct polish_t *const polish, const struct vector_t *const points,
+                     struct vector_t *const gradient)
+{
+    int i = 0;
+
+    if (polish->objective == OBJECTIVE_ENERGY) {
+        eval_energyGradient(polish->pool, &polish->store, gradient);
+    } else {
+        eval_distanceGradient(polish->pool, &polish->store, gradient);
+
+        for (i = 0; i < polish->n; i++) {
+            gradient[i].x = -gradient[i].x;
+            gradient[i].y = -gradient[i].y;
+            gradient[i].z = -gradient[i].z;
+        }
+    }
+
+    project(points, gradient, polish->n);
+}
+
+/**
+ * @param const struct vector_t *const the first vectors
+ * @param const struct vector_t *const the second vectors
+ * @param const int number of vectors
+ * @return the dot product of the concatenated vectors
+ */
+static double dot(const struct vector_t *const a, const struct vector_t *const b, const int n)
+{
+    double sum = 0.0;
+    int i = 0;
+
+    for (i = 0; i < n; i++) {
+        sum += vector_dotProduct(&a[i], &b[i]);
+    }
+
+    return sum;
+}
+
+/**
+ * @param const struct vector_t *const the vectors
+ * @param const int number of vectors
+ * @return the largest length of a vector
+ */
+static double largest(const struct vector_t *const vectors, const int n)
+{
+    double length, max = 0.0;
+    int i = 0;
+
+    for (i = 0; i < n; i++) {
+        length = sqrt(vector_dotProduct(&vectors[i], &vectors[i]));
+        max = (length > max) ? length : max;
+    }
+
+    return max;
+}
+
+/**
+ * Add a multiple of the second vectors to the first ones.
+ *
+ * @param struct vector_t *const the vectors to be updated
+ * @param const double the factor
+ * @param const struct vector_t *const the vectors to be added
+ * @param const int number of vectors
+ */
+static void axpy(struct vector_t *const y, const double a, const struct vector_t *const x,
+                 const int n)
+{
+    int i = 0;
+
+    for (i = 0; i < n; i++) {
+        y[i].x += a * x[i].x;
+        y[i].y += a * x[i].y;
+        y[i].z += a * x[i].z;
+    }
+}
+
+/**
+ * Polish a configuration by a Riemannian L-BFGS descent. The configuration is replaced by the
+ * polished one, which is never worse than the given one.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param struct vector_t *const the configuration
+ * @param const int number of points
+ * @param const enum objective_t the objective
+ * @param const int maximum number of iterations
+ * @param double* the objective of the given configuration
+ * @param double* the objective of the polished configuration
+ * @return the number of iterations, or FAIL if the memory could not be allocated
+ */
+int polish_run(struct pool_t *const pool, struct vector_t *const points, const int n,
+               const enum objective_t objective, const int iterations,
+               double *before, double *after)
+{
+    struct polish_t polish;
+    struct vector_t *work, *x, *trial, *g, *gtrial, *d, *s, *y;
+    double rho[POLISH_MEMORY], alpha[POLISH_MEMORY];
+    double f, ftrial, slope, step, sy, beta;
+    int head = 0;
+    int stored = 0;
+    int it = 0;
+    int b = 0;
+    int k = 0;
+    int m = 0;
+    int i = 0;
+
+    work = (struct vector_t *) malloc((5 + 2 * POLISH_MEMORY) * (size_t) n
+                                      * sizeof(struct vector_t));
+
+    if (work == NULL || points_alloc(&polish.store, n) == FAIL) {
+        free(work);
+        return FAIL;
+    }
+
+    x = work;
+    trial = x + n;
+    g = trial + n;
+    gtrial = g + n;
+    d = gtrial + n;
+    s = d + n;
+    y = s + POLISH_MEMORY * n;
+
+    polish.pool = pool;
+    polish.objective = objective;
+    polish.n = n;
+
+    vector_arrayCopy(x, points, n);
+    f = cost(&polish, x);
+    gradient(&polish, x, g);
+    *before = f;
+
+    for (it = 0; it < iterations && largest(g, n) > POLISH_TOLERANCE; it++) {
+        /* two-loop recursion for the quasi-Newton direction */
+        vector_arrayCopy(d, g, n);
+
+        for (k = 0; k < stored; k++) {
+            m = (head - 1 - k + POLISH_MEMORY) % POLISH_MEMORY;
+            alpha[m] = rho[m] * dot(s + m * n, d, n);
+            axpy(d, -alpha[m], y + m * n, n);
+        }
+
+        if (stored > 0) {
+            m = (head - 1 + POLISH_MEMORY) % POLISH_MEMORY;
+            beta = 1.0 / (rho[m] * dot(y + m * n, y + m * n, n));
+        } else {
+            beta = POLISH_STEP / largest(g, n);
+        }
+
+        for (i = 0; i < n; i++) {
+            d[i].x *= -beta;
+            d[i].y *= -beta;
+            d[i].z *= -beta;
+        }
+
+        for (k = stored - 1; k >= 0; k--) {
+            m = (head - 1 - k + POLISH_MEMORY) % POLISH_MEMORY;
+            beta = rho[m] * dot(y + m * n, d, n);
+            axpy(d, -alpha[m] - beta, s + m * n, n);
+        }
+
+        project(x, d, n);
+        slope = dot(g, d, n);
+
+        /* restart along the steepest descent if the curvature information went stale */
+        if (!(slope < 0.0)) {
+            stored = 0;
+            beta = POLISH_STEP / largest(g, n);
+
+            for (i = 0; i < n; i++) {
+                d[i].x = -beta * g[i].x;
+                d[i].y = -beta * g[i].y;
+                d[i].z = -beta * g[i].z;
+            }
+
+            slope = dot(g, d, n);
+        }
+
+        /* backtracking line search along the retraction */
+        step = 1.0;
+
+        for (b = 0; b < POLISH_BACKTRACKS; b++) {
+            for (i = 0; i < n; i++) {
+                trial[i].x = x[i].x + step * d[i].x;
+                trial[i].y = x[i].y + step * d[i].y;
+                trial[i].z = x[i].z + step * d[i].z;
+                vector_normalise(&trial[i]);
+            }
+
+            ftrial = cost(&polish, trial);
+
+            if (ftrial <= f + POLISH_ARMIJO * step * slope) {
+                break;
+            }
+
+            step *= 0.5;
+        }
+
+        if (b == POLISH_BACKTRACKS) {
+            break;
+        }
+
+        gradient(&polish, trial, gtrial);
+
+        /* the new correction pair, transported to the tangent planes of the new configuration */
+        for (i = 0; i < n; i++) {
+            s[head * n + i].x = trial[i].x - x[i].x;
+            s[head * n + i].y = trial[i].y - x[i].y;
+            s[head * n + i].z = trial[i].z - x[i].z;
+            y[head * n + i].x = gtrial[i].x - g[i].x;
+            y[head * n + i].y = gtrial[i].y - g[i].y;
+            y[head * n + i].z = gtrial[i].z - g[i].z;
+        }
+
+        project(trial, s + head * n, n);
+        project(trial, y + head * n, n);
+
+        for (k = 0; k < stored; k++) {
+            m = (head - 1 - k + POLISH_MEMORY) % POLISH_MEMORY;
+            project(trial, s + m * n, n);
+            project(trial, y + m * n, n);
+        }
+
+        sy = dot(s + head * n, y + head * n, n);
+
+        /* keep the pair only if it carries positive curvature */
+        if (sy > 0.0) {
+            rho[head] = 1.0 / sy;
+            head = (head + 1) % POLISH_MEMORY;
+            stored = (stored < POLISH_MEMORY) ? stored + 1 : POLISH_MEMORY;
+        }
+
+        vector_arrayCopy(x, trial, n);
+        vector_arrayCopy(g, gtrial, n);
+        f = ftrial;
+    }
+
+    vector_arrayCopy(points, x, n);
+
+    *before = (objective == OBJECTIVE_ENERGY) ? *before : -*before;
+    *after = (objective == OBJECTIVE_ENERGY) ? f : -f;
+
+    points_free(&polish.store);
+    free(work);
+
+    return it;
+}
@@ -0,0 +1,201 @@
+/**
+ * This module provides a fixed-size thread pool. The pool executes one parallel loop at a time:
+ * pool_run hands out the task numbers 0..tasks-1 to the workers and to the calling thread, and
+ * returns once all of them have completed. Which thread executes which task is not determined,
+ * so tasks have to write their results into task-specific slots.
+ *
+ * @author Dominik Dahlem
+ */
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+
+/**
+ * The state of the thread pool.
+ */
+struct pool_t {
+    pthread_t *threads; /** the worker threads */
+    int size; /** number of threads including the calling one */
+    pthread_mutex_t lock; /** protects the fields below */
+    pthread_cond_t start; /** signalled when a new loop is started */
+    pthread_cond_t done; /** signalled when the last worker finished the loop */
+    pool_task_t task; /** the task of the current loop */
+    void *arg; /** the argument of the current loop */
+    int tasks; /** number of tasks of the current loop */
+    int next; /** the next unclaimed task */
+    int busy; /** number of workers still working on the current loop */
+    long generation; /** counts the loops, so that workers detect a new one */
+    int shutdown; /** flag to terminate the workers */
+};
+
+
+/**
+ * Claim and execute tasks of the current loop until none is left.
+ *
+ * @param struct pool_t* the thread pool
+ */
+static void work(struct pool_t *pool)
+{
+    int task;
+
+    while ((task = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->tasks) {
+        pool->task(pool->arg, task);
+    }
+}
+
+/**
+ * The main function of a worker thread.
+ *
+ * @param void* the thread pool
+ */
+static void *worker(void *arg)
+{
+    struct pool_t *pool = (struct pool_t *) arg;
+    long generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        while (pool->generation == generation && !pool->shutdown) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+
+        if (pool->shutdown) {
+            break;
+        }
+
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        work(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/**
+ * Create a thread pool. The calling thread takes part in every loop, so threads-1 worker
+ * threads are started.
+ *
+ * @param const int the number of threads (at least one)
+ * @return struct pool_t* the thread pool or NULL, if it could not be created
+ */
+struct pool_t *pool_create(const int threads)
+{
+    struct pool_t *pool;
+    int i = 0;
+
+    pool = (struct pool_t *) calloc(1, sizeof(struct pool_t));
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->size = (threads < 1) ? 1 : threads;
+    pool->threads = (pthread_t *) malloc(pool->size * sizeof(pthread_t));
+
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (i = 1; i < pool->size; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0) {
+            /* run with the threads we got */
+            pool->size = i;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+/**
+ * Stop the worker threads and free the thread pool.
+ *
+ * @param struct pool_t* the thread pool
+ */
+void pool_destroy(struct pool_t *pool)
+{
+    int i = 0;
+
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 1; i < pool->size; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+/**
+ * @param const struct pool_t *const the thread pool
+ * @return the number of threads of the pool including the calling one
+ */
+int pool_size(const struct pool_t *const pool)
+{
+    return (pool == NULL) ? 1 : pool->size;
+}
+
+/**
+ * Execute the tasks 0..tasks-1 in parallel and wait for their completion. A NULL pool or a
+ * pool of size one executes the tasks in order on the calling thread.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param const int the number of tasks
+ * @param pool_task_t the task function
+ * @param void* the argument passed to every task
+ */
+void pool_run(struct pool_t *const pool, const int tasks, pool_task_t task, void *arg)
+{
+    int i = 0;
+
+    if (pool == NULL || pool->size == 1 || tasks <= 1) {
+        for (i = 0; i < tasks; i++) {
+            task(arg, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->tasks = tasks;
+    pool->next = 0;
+    pool->busy = pool->size - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    work(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
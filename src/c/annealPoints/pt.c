@@ -0,0 +1,357 @@
+/**
+ * Contains the parallel tempering (replica exchange) algorithm. M replicas of the configuration
+ * are sampled at a fixed ladder of temperatures between the initial and the minimum temperature.
+ * Every replica runs the inner loop on its own thread with its own random number generator.
+ * Afterwards, neighbouring replicas exchange their configurations according to the Metropolis
+ * swap criterion, which lets good configurations found at high temperatures cool down and lets
+ * the cold replicas escape local minima.
+ *
+ * Internally, all objectives are minimised, i.e., the sum of the distances enters with a
+ * negative sign.
+ *
+ * @author Dominik Dahlem
+ */
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "best.h"
+#include "eval.h"
+#include "global.h"
+#include "kernel.h"
+#include "logging.h"
+#include "output.h"
+#include "points.h"
+#include "pool.h"
+#include "pt.h"
+#include "rng.h"
+#include "sa.h"
+#include "sphere.h"
+#include "vector.h"
+#include "workspace.h"
+
+
+/**
+ * The state of one replica.
+ */
+struct chain_t {
+    struct points_t store; /** the current configuration for the pair kernels */
+    struct vector_t *points; /** the current configuration */
+    struct vector_t *best_points; /** the best configuration of this replica */
+    struct best_t *best; /** the lazy tracking of the best configuration */
+    struct rng_t rng; /** the random number generator of this replica */
+    double temperature; /** the temperature of this replica */
+    double variance; /** the variance of the random walk at this temperature */
+    double cost; /** the cost of the current configuration */
+    double cost_best; /** the cost of the best configuration */
+    long steps; /** number of steps performed at this temperature */
+};
+
+/**
+ * The state of the replica exchange.
+ */
+struct pt_t {
+    struct chain_t *chains; /** the replicas ordered from the hottest to the coldest */
+    int replicas; /** number of replicas */
+    int n; /** number of points */
+    int iter; /** number of steps between two exchanges */
+    enum objective_t objective; /** the objective */
+};
+
+
+/**
+ * The cost contribution of a single point at the given position.
+ */
+static double costTo(const struct pt_t *const pt, const struct points_t *const store,
+                     const int index, const struct vector_t *const point)
+{
+    if (pt->objective == OBJECTIVE_ENERGY) {
+        return kernel_energyTo(store, index, point);
+    }
+
+    return -kernel_distanceTo(store, index, point);
+}
+
+/**
+ * The cost of the whole configuration. Replicas are already running on their own threads, so
+ * the evaluation is sequential.
+ */
+static double cost(const struct pt_t *const pt, const struct points_t *const store)
+{
+    if (pt->objective == OBJECTIVE_ENERGY) {
+        return eval_energy(NULL, store);
+    }
+
+    return -eval_distance(NULL, store);
+}
+
+/**
+ * The value of the objective as reported by the annealers for a given cost.
+ */
+static double objectiveValue(const struct pt_t *const pt, const double cost)
+{
+    return (pt->objective == OBJECTIVE_ENERGY) ? cost : -cost;
+}
+
+/**
+ * The variance of the random walk at a given temperature. The same variances as in
+ * sa_distance and sa_energy are used.
+ */
+static double walkVariance(const struct pt_t *const pt, const double temperature)
+{
+    double variance;
+
+    if (pt->objective == OBJECTIVE_ENERGY) {
+        return 1 - exp(-0.5 * temperature);
+    }
+
+    variance = 0.5 * (1 - exp(-0.5 * temperature));
+
+    return variance * variance;
+}
+
+/**
+ * Perform the inner loop of one replica. This is a task for the thread pool and only touches
+ * the state of its own replica.
+ *
+ * @param void* the replica exchange
+ * @param int the replica
+ */
+static void chainStep(void *arg, int replica)
+{
+    struct pt_t *pt = (struct pt_t *) arg;
+    struct chain_t *chain = &pt->chains[replica];
+    struct vector_t v_new;
+    double delta;
+    int index = 0;
+    int k = 0;
+
+    for (k = 0; k < pt->iter; k++) {
+        /* select a random walker and perform the random walk */
+        index = rng_index(&chain->rng, pt->n);
+        v_new = sphere_walk(&chain->points[index], chain->variance, &chain->rng);
+
+        delta = costTo(pt, &chain->store, index, &v_new)
+            - costTo(pt, &chain->store, index, &chain->points[index]);
+
+        if (delta < 0.0
+            || rng_uniform(&chain->rng)
+               < exp(-delta / ((double) BOLTZMANN_CONSTANT * chain->temperature))) {
+            best_moved(chain->best, index);
+            vector_copy(&chain->points[index], &v_new);
+            points_set(&chain->store, index, &v_new);
+            chain->cost += delta;
+
+            if (chain->cost < chain->cost_best) {
+                best_improved(chain->best);
+                chain->cost_best = chain->cost;
+            }
+        }
+
+        /* recompute the cost from scratch to bound the drift of the running sum */
+        if (++chain->steps % T_RESYNC == 0) {
+            chain->cost = cost(pt, &chain->store);
+        }
+    }
+
+    /* the best configuration is written once per round, before the exchange */
+    best_materialise(chain->best);
+}
+
+/**
+ * Exchange the configurations of two replicas. The temperatures, the random number generators,
+ * and the best configurations stay with the replicas, which track their new configurations.
+ */
+static void swap(struct chain_t *const a, struct chain_t *const b)
+{
+    struct points_t store;
+    struct vector_t *points;
+    double cost;
+
+    store = a->store;
+    a->store = b->store;
+    b->store = store;
+
+    points = a->points;
+    a->points = b->points;
+    b->points = points;
+
+    cost = a->cost;
+    a->cost = b->cost;
+    b->cost = cost;
+
+    best_replaced(a->best, a->points);
+    best_replaced(b->best, b->points);
+}
+
+/**
+ * Attempt to exchange the configurations of the neighbouring replicas (offset, offset + 1),
+ * (offset + 2, offset + 3), ... The exchange of replicas a and b is accepted with probability
+ * \f$ \min(1, \exp((\beta_a - \beta_b) (E_a - E_b))) \f$.
+ *
+ * @param struct pt_t *const the replica exchange
+ * @param struct rng_t *const the random number generator of the exchange
+ * @param const int the first replica of the pairs (0 or 1)
+ * @return int the number of accepted exchanges
+ */
+static int exchange(struct pt_t *const pt, struct rng_t *const rng, const int offset)
+{
+    struct chain_t *a, *b;
+    double expo;
+    int swapped = 0;
+    int m = 0;
+
+    for (m = offset; m + 1 < pt->replicas; m += 2) {
+        a = &pt->chains[m];
+        b = &pt->chains[m + 1];
+        expo = (1.0 / ((double) BOLTZMANN_CONSTANT * a->temperature)
+                - 1.0 / ((double) BOLTZMANN_CONSTANT * b->temperature))
+            * (a->cost - b->cost);
+
+        if (expo >= 0.0 || rng_uniform(rng) < exp(expo)) {
+            swap(a, b);
+            swapped++;
+        }
+    }
+
+    return swapped;
+}
+
+/**
+ * @return the replica holding the best configuration found so far
+ */
+static struct chain_t *bestChain(const struct pt_t *const pt)
+{
+    struct chain_t *best = &pt->chains[0];
+    int m = 0;
+
+    for (m = 1; m < pt->replicas; m++) {
+        if (pt->chains[m].cost_best < best->cost_best) {
+            best = &pt->chains[m];
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Free the replicas.
+ */
+static void freeChains(struct pt_t *const pt)
+{
+    int m = 0;
+
+    for (m = 0; m < pt->replicas; m++) {
+        points_free(&pt->chains[m].store);
+    }
+
+    free(pt->chains);
+}
+
+/**
+ * Optimise the points with parallel tempering. The number of exchange rounds is the number of
+ * temperature levels the simulated annealing would run through with the same parameters, and
+ * every round performs globalArgs->iter steps per replica.
+ *
+ * Every replica draws from its own stream of the given generator, while the exchanges draw
+ * from the generator itself. Only the distance and the energy are optimised; the closeness
+ * moves the closest pair apart, which has no counterpart in the replicas.
+ *
+ * @param struct vector_t* the points to be distributed across a sphere, which return the best
+ *        configuration
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @param struct rng_t *const the random number generator
+ * @param struct workspace_t *const the workspace the configurations are allocated from
+ * @param const struct output_t *const where the run reports to
+ * @return int SUCCESS, or FAIL if the memory could not be allocated
+ */
+int pt_run(struct vector_t *points, const struct globalArgs_t *const globalArgs,
+           struct rng_t *const rng, struct workspace_t *const workspace,
+           const struct output_t *const output)
+{
+    struct pt_t pt;
+    struct chain_t *chain, *best, *coldest;
+    struct pool_t *pool;
+    double temperature = globalArgs->temp;
+    long round = 0;
+    int swapped = 0;
+    int m = 0;
+
+    pt.replicas = globalArgs->replicas;
+    pt.n = globalArgs->n;
+    pt.iter = globalArgs->iter;
+    pt.objective = globalArgs->objective;
+    pt.chains = (struct chain_t *) calloc(pt.replicas, sizeof(struct chain_t));
+
+    if (pt.chains == NULL) {
+        fprintf(stderr, "Could not allocate %d replicas\n", pt.replicas);
+        return FAIL;
+    }
+
+    /* set up the temperature ladder from the initial down to the minimum temperature */
+    for (m = 0; m < pt.replicas; m++) {
+        chain = &pt.chains[m];
+        chain->points = (struct vector_t *) workspace_alloc(workspace,
+                                                            pt.n * sizeof(struct vector_t));
+        chain->best_points = (struct vector_t *) workspace_alloc(workspace,
+                                                                 pt.n * sizeof(struct vector_t));
+        chain->best = (chain->points == NULL || chain->best_points == NULL) ? NULL
+            : best_create(workspace, chain->best_points, chain->points, pt.n);
+
+        if (points_alloc(&chain->store, pt.n) == FAIL || chain->best == NULL) {
+            fprintf(stderr, "Could not allocate the configuration of replica %d\n", m);
+            freeChains(&pt);
+            return FAIL;
+        }
+
+        vector_arrayCopy(&chain->points[0], &points[0], pt.n);
+        vector_arrayCopy(&chain->best_points[0], &points[0], pt.n);
+        points_fromVectors(&chain->store, &points[0]);
+
+        chain->temperature = globalArgs->temp
+            * pow(T_MIN / globalArgs->temp, (double) m / (double) (pt.replicas - 1));
+        chain->variance = walkVariance(&pt, chain->temperature);
+        chain->cost = cost(&pt, &chain->store);
+        chain->cost_best = chain->cost;
+        rng_stream(&chain->rng, rng, m + 1);
+    }
+
+    coldest = &pt.chains[pt.replicas - 1];
+
+    /* one thread per replica */
+    pool = pool_create(pt.replicas);
+
+    do {
+        pool_run(pool, pt.replicas, chainStep, &pt);
+        swapped = exchange(&pt, rng, (int) (round % 2));
+
+        best = bestChain(&pt);
+
+        if (output->progress != NULL) {
+            output->progress(output->arg, round, objectiveValue(&pt, best->cost_best),
+                             objectiveValue(&pt, coldest->cost)
+                             - objectiveValue(&pt, best->cost_best),
+                             coldest->temperature, coldest->variance, swapped);
+        }
+        round++;
+
+        anneal(&temperature, globalArgs->damping);
+    } while (temperature > T_MIN);
+
+    pool_destroy(pool);
+
+    /* report the best configuration of all replicas */
+    best = bestChain(&pt);
+
+    pool = pool_create(globalArgs->threads);
+    sa_polish(pool, best->best_points, globalArgs);
+    pool_destroy(pool);
+
+    /* the points return the best configuration */
+    vector_arrayCopy(&points[0], &best->best_points[0], pt.n);
+
+    freeChains(&pt);
+
+    return SUCCESS;
+}
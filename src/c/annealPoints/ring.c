@@ -0,0 +1,124 @@
+/**
+ * This module provides a lock-free single-producer/single-consumer ring buffer. The producer only
+ * writes the head and the consumer only writes the tail. A record is published by the release
+ * store of the head after it was copied in, and its slot is handed back by the release store of
+ * the tail after it was copied out, so no record is read while it is being written.
+ *
+ * The head and the tail count records without wrapping around, and the slot of a record is its
+ * count modulo the capacity, which is a power of two.
+ *
+ * @author Dominik Dahlem
+ */
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "ring.h"
+
+
+/**
+ * The state of the ring buffer. The head and the tail are kept on separate cache lines, so that
+ * the producer and the consumer do not invalidate each other's line on every record.
+ */
+struct ring_t {
+    _Alignas(64) atomic_size_t head; /** number of records pushed */
+    _Alignas(64) atomic_size_t tail; /** number of records popped */
+    _Alignas(64) size_t mask; /** the capacity minus one */
+    size_t size; /** the size of a record */
+    char *records; /** the slots of the records */
+};
+
+
+/**
+ * Create a ring buffer.
+ *
+ * @param const int the minimum number of records (rounded up to a power of two)
+ * @param const size_t the size of a record
+ * @return struct ring_t* the ring buffer or NULL, if the memory could not be allocated
+ */
+struct ring_t *ring_create(const int capacity, const size_t size)
+{
+    struct ring_t *ring;
+    void *block = NULL;
+    size_t slots = 1;
+
+    while (slots < (size_t) capacity) {
+        slots <<= 1;
+    }
+
+    if (posix_memalign(&block, 64, sizeof(struct ring_t)) != 0) {
+        return NULL;
+    }
+
+    ring = (struct ring_t *) block;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->mask = slots - 1;
+    ring->size = size;
+    ring->records = (char *) malloc(slots * size);
+
+    if (ring->records == NULL) {
+        free(ring);
+        return NULL;
+    }
+
+    return ring;
+}
+
+/**
+ * Free the ring buffer.
+ *
+ * @param struct ring_t* the ring buffer
+ */
+void ring_destroy(struct ring_t *ring)
+{
+    if (ring == NULL) {
+        return;
+    }
+
+    free(ring->records);
+    free(ring);
+}
+
+/**
+ * Append a record. Only the producer thread may call this function.
+ *
+ * @param struct ring_t *const the ring buffer
+ * @param const void *const the record
+ * @return int SUCCESS or FAIL, if the ring buffer is full
+ */
+int ring_push(struct ring_t *const ring, const void *const record)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) > ring->mask) {
+        return FAIL;
+    }
+
+    memcpy(ring->records + (head & ring->mask) * ring->size, record, ring->size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return SUCCESS;
+}
+
+/**
+ * Remove the oldest record. Only the consumer thread may call this function.
+ *
+ * @param struct ring_t *const the ring buffer
+ * @param void *const the record to be filled
+ * @return int SUCCESS or FAIL, if the ring buffer is empty
+ */
+int ring_pop(struct ring_t *const ring, void *const record)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (atomic_load_explicit(&ring->head, memory_order_acquire) == tail) {
+        return FAIL;
+    }
+
+    memcpy(record, ring->records + (tail & ring->mask) * ring->size, ring->size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return SUCCESS;
+}
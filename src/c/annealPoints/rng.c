@@ -0,0 +1,222 @@
+/**
+ * This module provides a reentrant random number generator. The generator is xoshiro256**
+ * (Blackman and Vigna, 2018), which is fast, has a period of 2^256 - 1, and supports jumping
+ * ahead by 2^128 steps to obtain non-overlapping streams for parallel chains. Jumping ahead by
+ * 2^192 steps separates the jobs of a batch, each of which may derive such streams.
+ *
+ * Normal variates are generated in batches with the polar method, which yields two independent
+ * variates per accepted pair of uniforms. Both of them are kept.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rng.h"
+
+
+/**
+ * Rotate a 64-bit word to the left.
+ */
+static inline uint64_t rotl(const uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * The splitmix64 generator, which expands the seed into the state of xoshiro256**.
+ */
+static uint64_t splitmix64(uint64_t *const x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seed the generator. The seed is expanded with splitmix64, as recommended by the authors of
+ * xoshiro256**.
+ *
+ * @param struct rng_t *const the generator
+ * @param const long the seed
+ */
+void rng_seed(struct rng_t *const rng, const long seed)
+{
+    uint64_t x = (uint64_t) seed;
+    int i = 0;
+
+    for (i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&x);
+    }
+
+    rng->normal = RNG_NORMALS;
+}
+
+/**
+ * Advance the generator by the number of steps given by a jump polynomial. Buffered normal
+ * variates are discarded.
+ *
+ * @param struct rng_t *const the generator
+ * @param const uint64_t *const the jump polynomial
+ */
+static void jumpBy(struct rng_t *const rng, const uint64_t *const jump)
+{
+    uint64_t s[4] = { 0, 0, 0, 0 };
+    int i = 0;
+    int b = 0;
+
+    for (i = 0; i < 4; i++) {
+        for (b = 0; b < 64; b++) {
+            if (jump[i] & (UINT64_C(1) << b)) {
+                s[0] ^= rng->s[0];
+                s[1] ^= rng->s[1];
+                s[2] ^= rng->s[2];
+                s[3] ^= rng->s[3];
+            }
+            rng_next(rng);
+        }
+    }
+
+    memcpy(rng->s, s, sizeof(s));
+    rng->normal = RNG_NORMALS;
+}
+
+/**
+ * Advance the generator by 2^128 steps. Buffered normal variates are discarded.
+ *
+ * @param struct rng_t *const the generator
+ */
+void rng_jump(struct rng_t *const rng)
+{
+    static const uint64_t jump[] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+
+    jumpBy(rng, jump);
+}
+
+/**
+ * Advance the generator by 2^192 steps. The 2^64 streams of rng_stream derived from the
+ * generator before and after the long jump do not overlap. Buffered normal variates are
+ * discarded.
+ *
+ * @param struct rng_t *const the generator
+ */
+void rng_longJump(struct rng_t *const rng)
+{
+    static const uint64_t jump[] = {
+        0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL,
+        0x77710069854EE241ULL, 0x39109BB02ACBE635ULL
+    };
+
+    jumpBy(rng, jump);
+}
+
+/**
+ * Derive an independent stream from a base generator. Stream k starts k * 2^128 steps after
+ * the base generator, so the streams of parallel chains never overlap.
+ *
+ * @param struct rng_t *const the generator of the stream
+ * @param const struct rng_t *const the base generator
+ * @param const int the number of the stream
+ */
+void rng_stream(struct rng_t *const rng, const struct rng_t *const base, const int stream)
+{
+    int i = 0;
+
+    memcpy(rng->s, base->s, sizeof(rng->s));
+    rng->normal = RNG_NORMALS;
+
+    for (i = 0; i < stream; i++) {
+        rng_jump(rng);
+    }
+}
+
+/**
+ * @param struct rng_t *const the generator
+ * @return the next 64-bit output of xoshiro256**
+ */
+uint64_t rng_next(struct rng_t *const rng)
+{
+    uint64_t *s = rng->s;
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * @param struct rng_t *const the generator
+ * @return a uniform random number in [0, 1) with 53 random bits
+ */
+double rng_uniform(struct rng_t *const rng)
+{
+    return (double) (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * Draw a uniform random index with Lemire's multiply-shift method, which avoids the modulo.
+ *
+ * @param struct rng_t *const the generator
+ * @param const int the number of choices
+ * @return a uniform random index in [0, number)
+ */
+int rng_index(struct rng_t *const rng, const int number)
+{
+    return (int) (((rng_next(rng) >> 32) * (uint64_t) number) >> 32);
+}
+
+/**
+ * Fill an array with standard normal variates using the polar method. Both variates of every
+ * accepted pair are used.
+ *
+ * @param struct rng_t *const the generator
+ * @param double *const the array of normal variates
+ * @param const int the number of variates
+ */
+void rng_normals(struct rng_t *const rng, double *const normals, const int count)
+{
+    double u, v, w, scale;
+    int i = 0;
+
+    while (i < count) {
+        do {
+            u = 2.0 * rng_uniform(rng) - 1.0;
+            v = 2.0 * rng_uniform(rng) - 1.0;
+            w = u * u + v * v;
+        } while (w >= 1.0 || w == 0.0);
+
+        scale = sqrt((-2 * log(w)) / w);
+        normals[i++] = u * scale;
+
+        if (i < count) {
+            normals[i++] = v * scale;
+        }
+    }
+}
+
+/**
+ * @param struct rng_t *const the generator
+ * @return a standard normal variate from the buffer, which is refilled in batches
+ */
+double rng_normal(struct rng_t *const rng)
+{
+    if (rng->normal == RNG_NORMALS) {
+        rng_normals(rng, rng->normals, RNG_NORMALS);
+        rng->normal = 0;
+    }
+
+    return rng->normals[rng->normal++];
+}
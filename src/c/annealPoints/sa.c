@@ -9,11 +9,30 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include "adapt.h"
+#include "best.h"
+#include "cells.h"
+#include "checkpoint.h"
+#include "eval.h"
+#include "kernel.h"
+#include "mtm.h"
+#include "output.h"
+#include "perf.h"
+#include "points.h"
+#include "polish.h"
+#include "pool.h"
+#include "rng.h"
 #include "sa.h"
+#include "schedule.h"
 #include "vector.h"
+#include "spec.h"
 #include "sphere.h"
+#include "tree.h"
+#include "verlet.h"
+#include "workspace.h"
 #include "logging.h"
 #include "global.h"
 
@@ -21,11 +40,13 @@
 /**
  * Select a point uniformly random.
  *
+ * @param struct rng_t *const the random number generator
+ * @param int the number of points
  * @return Index into the point array
  */
-int selectPoint(int number)
+int selectPoint(struct rng_t *const rng, int number)
 {
-    return lrand48() % number;
+    return rng_index(rng, number);
 }
 
 /**
@@ -39,262 +60,1146 @@ void anneal(double *temperature, double damping)
     *temperature = damping * (*temperature);
 }
 
+/**
+ * The opening angle of the tree evaluation. If an accuracy target is given, the angle is tuned
+ * for the given configuration.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param const struct points_t *const the point store
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @return the opening angle, or 0 for the exact evaluation
+ */
+double sa_openingAngle(struct pool_t *const pool, const struct points_t *const store,
+                       const struct globalArgs_t *const globalArgs)
+{
+    double theta = globalArgs->theta;
+
+    if (globalArgs->accuracy > 0.0) {
+        theta = tree_tune(pool, store, globalArgs->objective, theta, globalArgs->accuracy);
+        fprintf(stderr, "Tree opening angle %f for an accuracy of %e\n", theta,
+                globalArgs->accuracy);
+    }
+
+    return theta;
+}
+
+/**
+ * Polish the best configuration by a gradient descent, if requested. The annealing only reports
+ * the polished configuration.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param struct vector_t *const the best configuration
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ */
+void sa_polish(struct pool_t *const pool, struct vector_t *const best_points,
+               const struct globalArgs_t *const globalArgs)
+{
+    double before, after;
+    int iterations;
+
+    if (globalArgs->polish <= 0) {
+        return;
+    }
+
+    iterations = polish_run(pool, best_points, globalArgs->n, globalArgs->objective,
+                            globalArgs->polish, &before, &after);
+
+    if (iterations == FAIL) {
+        fprintf(stderr, "Could not allocate the memory to polish the best configuration\n");
+    } else {
+        fprintf(stderr, "Polished the best objective from %f to %f in %d iterations\n",
+                before, after, iterations);
+    }
+}
+
+/**
+ * The change of the sum of the distances, if both points of a pair move. Each contribution sees
+ * the other point of the pair at its old position, so the pair term between both is corrected.
+ *
+ * @param const struct points_t *const the point store holding the old positions
+ * @param const int* the indices of the pair
+ * @param const struct vector_t *const the old positions of the pair
+ * @param const struct vector_t *const the new positions of the pair
+ * @return the change of the sum of the distances
+ */
+static double pairDelta(const struct points_t *const store, const int *index_pair,
+                        const struct vector_t *const v_old, const struct vector_t *const v_new)
+{
+    return kernel_distanceTo(store, index_pair[0], &v_new[0])
+        - kernel_distanceTo(store, index_pair[0], &v_old[0])
+        + kernel_distanceTo(store, index_pair[1], &v_new[1])
+        - kernel_distanceTo(store, index_pair[1], &v_old[1])
+        + euclideanDistance(&v_new[0], &v_new[1])
+        + euclideanDistance(&v_old[0], &v_old[1])
+        - euclideanDistance(&v_new[0], &v_old[1])
+        - euclideanDistance(&v_old[0], &v_new[1]);
+}
+
+/**
+ * Sample the moves of the closeness annealer for the estimate of the initial temperature. Its
+ * only move pushes the closest pair apart, which is deterministic, so the pair is moved T_SAMPLES
+ * times in a row as in a first level that accepts every move.
+ *
+ * @param struct points_t *const the point store holding the initial configuration, which is
+ *        changed
+ * @param double *const the sum of the worsenings
+ * @return int the number of moves that worsen the objective
+ */
+static int sampleApart(struct points_t *const store, double *const worse)
+{
+    struct vector_t v_old[2], v_new[2];
+    double delta;
+    int index_pair[2];
+    int k, count = 0;
+
+    eval_closest(NULL, store, index_pair);
+    v_old[0] = points_get(store, index_pair[0]);
+    v_old[1] = points_get(store, index_pair[1]);
+
+    for (k = 0; k < T_SAMPLES; k++) {
+        v_new[0] = v_old[0];
+        v_new[1] = v_old[1];
+        sphere_moveApart(&v_new[0], &v_new[1], T_APART);
+
+        /* the distance is maximised */
+        delta = -pairDelta(store, index_pair, v_old, v_new);
+
+        if (delta > 0.0) {
+            *worse += delta;
+            count++;
+        }
+
+        points_set(store, index_pair[0], &v_new[0]);
+        points_set(store, index_pair[1], &v_new[1]);
+        v_old[0] = v_new[0];
+        v_old[1] = v_new[1];
+    }
+
+    return count;
+}
+
+/**
+ * Estimate the initial temperature for the initial acceptance ratio \f$ \chi_0 \f$. T_SAMPLES
+ * random walks of random points are scored against the initial configuration without moving
+ * any point, and the temperature is chosen such that the mean worsening \f$ \bar\Delta^+ \f$ is
+ * accepted with probability \f$ \chi_0 \f$, i.e. \f$ T_0 = -\bar\Delta^+ / \log \chi_0 \f$. The
+ * walks use the step size of the first level at the given initial temperature and a stream of
+ * their own, so the annealing itself draws the same random numbers as with T_0 given. The
+ * closeness is sampled with the moves of its annealer instead, which push the closest pair
+ * apart.
+ *
+ * @param const struct vector_t *const the initial configuration
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @param const struct rng_t *const the random number generator of the simulation
+ * @return the initial temperature, or the given one, if no move worsens the objective
+ */
+double sa_initialTemperature(const struct vector_t *const points,
+                             const struct globalArgs_t *const globalArgs,
+                             const struct rng_t *const rng)
+{
+    struct points_t store;
+    struct rng_t sample;
+    struct vector_t v_new;
+    double variance, delta, worse = 0.0;
+    int index, k, count = 0;
+
+    if (globalArgs->initialAcceptance <= 0.0 || globalArgs->initialAcceptance >= 1.0
+        || points_alloc(&store, globalArgs->n) == FAIL) {
+        return globalArgs->temp;
+    }
+    points_fromVectors(&store, points);
+
+    /* the parallel tempering chains take the streams 1 to M, the sampler the one beyond */
+    rng_stream(&sample, rng, globalArgs->replicas + 1);
+
+    /* the step sizes of the annealers at the given initial temperature */
+    if (globalArgs->objective == OBJECTIVE_ENERGY) {
+        variance = 1 - exp(-0.5 * globalArgs->temp);
+    } else {
+        variance = 0.5 * (1 - exp(-0.5 * globalArgs->temp));
+        variance = variance * variance;
+    }
+
+    if (globalArgs->objective == OBJECTIVE_CLOSENESS) {
+        count = sampleApart(&store, &worse);
+    } else {
+        for (k = 0; k < T_SAMPLES; k++) {
+            index = selectPoint(&sample, globalArgs->n);
+            v_new = sphere_walk(&points[index], variance, &sample);
+
+            /* the worsening of the objective, which is maximised unless it is the energy */
+            if (globalArgs->objective == OBJECTIVE_ENERGY) {
+                delta = kernel_energyTo(&store, index, &v_new)
+                    - kernel_energyTo(&store, index, &points[index]);
+            } else {
+                delta = kernel_distanceTo(&store, index, &points[index])
+                    - kernel_distanceTo(&store, index, &v_new);
+            }
+
+            if (delta > 0.0) {
+                worse += delta;
+                count++;
+            }
+        }
+    }
+
+    points_free(&store);
+
+    if (count == 0) {
+        fprintf(stderr, "No sampled move worsens the objective, keeping the initial temperature "
+                "%f\n", globalArgs->temp);
+        return globalArgs->temp;
+    }
+
+    return -(worse / (double) count) / log(globalArgs->initialAcceptance) / BOLTZMANN_CONSTANT;
+}
+
+/**
+ * Compare the distance of the final configuration approximated with the octree with the exact
+ * one. The running sum is always kept exact, so the tree only serves this report.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param const struct points_t *const the point store
+ * @param const struct globalArgs_t *const the parameters
+ * @param const double the opening angle of the tree evaluation (0 for the exact evaluation)
+ */
+static void reportDistance(struct pool_t *const pool, const struct points_t *const store,
+                           const struct globalArgs_t *const globalArgs, const double theta)
+{
+    double approximate, exact;
+
+    if (theta > 0.0 && globalArgs->reportError) {
+        approximate = tree_distance(pool, store, theta);
+        exact = eval_distance(pool, store);
+        fprintf(stderr, "Approximate distance %f, exact distance %f, relative error %e\n",
+                approximate, exact, fabs(approximate - exact) / fabs(exact));
+    }
+}
+
+/**
+ * Write a checkpoint into the checkpoint directory at the end of a temperature level, if one is
+ * due. No checkpoint is written after the last level. The opening angle is stored as tuned, so
+ * that a resumed run does not tune it again for a different configuration.
+ *
+ * @param const struct output_t *const where the run reports to
+ * @param struct timespec *const the time of the last checkpoint
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @param const struct rng_t *const the random number generator
+ * @param const double the temperature of the next level
+ * @param const long number of proposals so far
+ * @param const double the running objective
+ * @param const double the best objective
+ * @param const double the opening angle of the tree evaluation
+ * @param struct vector_t *const the current configuration
+ * @param struct vector_t *const the best configuration
+ * @param struct adapt_t *const the step size controller (may be NULL)
+ * @param const struct schedule_t *const the cooling schedule
+ */
+static void checkpoint(const struct output_t *const output, struct timespec *const due,
+                       const struct globalArgs_t *const globalArgs, const struct rng_t *const rng,
+                       const double temperature, const long iteration, const double current,
+                       const double best, const double theta, struct vector_t *const points,
+                       struct vector_t *const best_points, struct adapt_t *const adapt,
+                       const struct schedule_t *const schedule)
+{
+    struct checkpoint_t state;
+
+    if (output->checkpoints == NULL || temperature <= T_MIN
+        || !checkpoint_due(due, globalArgs->checkpoint)) {
+        return;
+    }
+
+    state.args = *globalArgs;
+    state.args.theta = theta;
+    state.args.accuracy = 0.0;
+    state.rng = *rng;
+    state.schedule = *schedule;
+    state.temperature = temperature;
+    state.current = current;
+    state.best = best;
+    state.iteration = iteration;
+    state.points = points;
+    state.best_points = best_points;
+    state.scales = (adapt != NULL) ? adapt_scales(adapt) : NULL;
+    state.scale_count = (adapt != NULL) ? adapt_count(adapt) : 0;
+
+    checkpoint_save(output->checkpoints, &state);
+}
+
+/**
+ * Create the step size controller, if a target acceptance ratio is given, and restore its step
+ * sizes from the checkpoint.
+ *
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @param const struct checkpoint_t *const the checkpoint to resume from (NULL for a new run)
+ * @return struct adapt_t* the controller or NULL for the fixed schedule
+ */
+static struct adapt_t *adaptive(const struct globalArgs_t *const globalArgs,
+                                const struct checkpoint_t *const resume)
+{
+    struct adapt_t *adapt;
+
+    if (globalArgs->acceptance <= 0.0) {
+        return NULL;
+    }
+
+    adapt = adapt_create(globalArgs->acceptance, globalArgs->perPoint ? globalArgs->n : 1);
+
+    if (adapt == NULL) {
+        fprintf(stderr, "Could not allocate the step sizes, using the fixed schedule\n");
+        return NULL;
+    }
+
+    if (resume != NULL && resume->scales != NULL && resume->scale_count == adapt_count(adapt)) {
+        memcpy(adapt_scales(adapt), resume->scales, resume->scale_count * sizeof(double));
+    }
+
+    return adapt;
+}
+
+/**
+ * The configuration a batch of positions of a point is scored against.
+ */
+struct batch_t {
+    const struct points_t *store; /** the point store */
+    const struct verlet_t *verlet; /** the neighbour lists (may be NULL) */
+};
+
+/**
+ * Score a batch of positions of a point by the sum of their distances to the other points.
+ *
+ * @param void* the configuration
+ * @param int the index of the point
+ * @param const struct vector_t* the positions
+ * @param int number of positions
+ * @param double* the sum of the distances of every position
+ */
+static void batchDistance(void *arg, int index, const struct vector_t *positions, int count,
+                          double *result)
+{
+    struct batch_t *batch = (struct batch_t *) arg;
+
+    kernel_distanceBatchTo(batch->store, index, positions, count, result);
+}
+
+/**
+ * Score a batch of positions of a point by the sum of their pair energies with the other
+ * points. The neighbour lists are few and short, so they are looked up for one position after
+ * the other.
+ *
+ * @param void* the configuration
+ * @param int the index of the point
+ * @param const struct vector_t* the positions
+ * @param int number of positions
+ * @param double* the sum of the pair energies of every position
+ */
+static void batchEnergy(void *arg, int index, const struct vector_t *positions, int count,
+                        double *result)
+{
+    struct batch_t *batch = (struct batch_t *) arg;
+    int c = 0;
+
+    if (batch->verlet != NULL) {
+        for (c = 0; c < count; c++) {
+            result[c] = verlet_energyTo(batch->verlet, index, &positions[c]);
+        }
+    } else {
+        kernel_energyBatchTo(batch->store, index, positions, count, result);
+    }
+}
+
+/**
+ * Create the state of the multiple-try proposals, if more than one try is requested.
+ *
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @param const int 1, if the objective is maximised, -1 if it is minimised
+ * @param mtm_score_t the function scoring a batch of positions
+ * @param struct batch_t *const the configuration the positions are scored against
+ * @return struct mtm_t* the state or NULL for plain Metropolis proposals
+ */
+static struct mtm_t *multipleTry(const struct globalArgs_t *const globalArgs, const int sense,
+                                 mtm_score_t score, struct batch_t *const batch)
+{
+    struct mtm_t *mtm;
+    int tries = globalArgs->tries;
+
+    if (tries <= 1) {
+        return NULL;
+    }
+
+    if (tries > MTM_MAX_TRIES) {
+        fprintf(stderr, "Reduced the number of tries to %d\n", MTM_MAX_TRIES);
+        tries = MTM_MAX_TRIES;
+    }
+
+    mtm = mtm_create(tries, sense, score, batch);
+
+    if (mtm == NULL) {
+        fprintf(stderr, "Could not allocate the candidates, using plain Metropolis proposals\n");
+    }
+
+    return mtm;
+}
+
+/**
+ * Create the state of the speculative proposals, if more than one proposal per round is
+ * requested. The rounds score the proposals exactly, so they are not combined with the
+ * multiple-try proposals or the neighbour lists.
+ *
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @param const struct mtm_t *const the multiple-try proposals (may be NULL)
+ * @param const struct verlet_t *const the neighbour lists (may be NULL)
+ * @return struct spec_t* the state or NULL for sequential proposals
+ */
+static struct spec_t *speculative(const struct globalArgs_t *const globalArgs,
+                                  const struct mtm_t *const mtm,
+                                  const struct verlet_t *const verlet)
+{
+    struct spec_t *spec;
+
+    if (globalArgs->speculative <= 1) {
+        return NULL;
+    }
+
+    if (mtm != NULL || verlet != NULL) {
+        fprintf(stderr, "Speculative proposals need single tries and the exact objective, "
+                "proposing sequentially\n");
+        return NULL;
+    }
+
+    spec = spec_create(globalArgs->speculative, globalArgs->n, globalArgs->objective);
+
+    if (spec == NULL) {
+        fprintf(stderr, "Could not allocate the speculative proposals, proposing sequentially\n");
+    }
+
+    return spec;
+}
+
 /**
  * This is the heart of the simulation using simulated annealing.
  *
- * @param struct vector* the points to be distributed across a sphere
+ * @param struct vector* the points to be distributed across a sphere, which return the best
+ *        configuration
+ * @param const struct globalArgs_t* the parameters of the simulation
+ * @param struct rng_t *const the random number generator
+ * @param const struct checkpoint_t *const the checkpoint to resume from (NULL for a new run)
+ * @param struct workspace_t *const the workspace the configurations are allocated from
+ * @param const struct output_t *const where the run reports to
+ * @return int SUCCESS, or FAIL if the memory could not be allocated
  */
-void sa_distance(struct vector_t *points, const struct globalArgs_t const* globalArgs)
+int sa_distance(struct vector_t *points, const struct globalArgs_t const* globalArgs,
+                struct rng_t *const rng, const struct checkpoint_t *const resume,
+                struct workspace_t *const workspace, const struct output_t *const output)
 {
     double temperature = globalArgs->temp;
     double distance_old, distance_new, distance_best, distance_cur, distance_delta, expo, variance;
-    struct vector_t new_points[globalArgs->n];
-    struct vector_t best_points[globalArgs->n];
+    struct vector_t *best_points;
+    struct best_t *best;
     struct vector_t v_new;
+    struct points_t store;
+    struct pool_t *pool;
+    double theta;
     int index = 0;
     int k = 0;
     int accepted = 0;
+    int accepted_level = 0;
     long iteration = 0;
+    struct timespec due = {0, 0};
+    struct adapt_t *adapt;
+    struct schedule_t schedule;
+    struct batch_t batch;
+    struct mtm_t *mtm;
+    struct spec_t *spec;
 
-    vector_arrayCopy(&new_points[0], &points[0], globalArgs->n);
+    /* the best configuration is too large for the stack */
+    best_points = (struct vector_t *) workspace_alloc(workspace,
+                                                      globalArgs->n * sizeof(struct vector_t));
+    best = (best_points == NULL) ? NULL
+        : best_create(workspace, best_points, points, globalArgs->n);
+    if (best == NULL) {
+        fprintf(stderr, "Could not allocate the best configuration of %d points\n", globalArgs->n);
+        return FAIL;
+    }
+
+    /* the pair kernels operate on a structure-of-arrays copy of the points */
+    if (points_alloc(&store, globalArgs->n) == FAIL) {
+        fprintf(stderr, "Could not allocate the point store for %d points\n", globalArgs->n);
+        return FAIL;
+    }
+    points_fromVectors(&store, &points[0]);
+
+    /* the whole configuration is evaluated in parallel */
+    pool = pool_create(globalArgs->threads);
+
+    theta = sa_openingAngle(pool, &store, globalArgs);
+    adapt = adaptive(globalArgs, resume);
+    batch.store = &store;
+    batch.verlet = NULL;
+    mtm = multipleTry(globalArgs, 1, batchDistance, &batch);
+    spec = speculative(globalArgs, mtm, NULL);
+    vector_arrayCopy(&best_points[0], &points[0], globalArgs->n);
 
     distance_best = 0.0;
 
+    if (resume != NULL) {
+        /* continue from the end of the checkpointed level */
+        temperature = resume->temperature;
+        iteration = resume->iteration;
+        distance_cur = resume->current;
+        distance_best = resume->best;
+        vector_arrayCopy(&best_points[0], &resume->best_points[0], globalArgs->n);
+    } else {
+        distance_cur = eval_distance(pool, &store);
+    }
+
+    /* the schedule of a resumed run continues where it was checkpointed */
+    schedule_init(&schedule, 1, distance_best);
+    if (resume != NULL) {
+        schedule = resume->schedule;
+    }
+
     do {
         /* select a random walker */
-        index = selectPoint(globalArgs->n);
+        index = selectPoint(rng, globalArgs->n);
         variance = 0.5 * (1 - exp(-0.5 * temperature));
+        if (adapt != NULL) {
+            /* the proposals of a speculative round share the step size of the first point */
+            variance = adapt_scale(adapt, (spec != NULL) ? 0 : index, variance);
+        }
+        accepted_level = 0;
 
         for (k = 0; k < globalArgs->iter; k++) {
-            /* perform the random walk */
-            v_new = sphere_walk(&points[index], variance * variance);
+            distance_old = distance_cur;
 
-            /* copy the new location of the walker */
-            vector_copy(&new_points[index], &v_new);
+            if (spec != NULL) {
+                /* the proposals of a round of distinct points are scored in parallel */
+                PERF_BEGIN(PERF_EVALUATE);
+                if (k % spec_size(spec) == 0) {
+                    spec_round(spec, pool, &store, points, variance * variance, rng,
+                               globalArgs->iter - k);
+                }
+                distance_delta = spec_next(spec, &index, &v_new);
+                distance_new = distance_cur + distance_delta;
 
-            /* calcuate the old and the new distance */
-            distance_old = sphere_distance(&points[0], globalArgs->n);
-            distance_new = sphere_distance(&new_points[0], globalArgs->n);
-            distance_delta = distance_new - distance_old;
-            accepted = 0;
+                expo = exp(-fabs(distance_delta) /
+                        ((double) BOLTZMANN_CONSTANT * temperature));
+                PERF_END(PERF_EVALUATE);
 
-            expo = exp(-abs(distance_delta) /
-                    ((double) BOLTZMANN_CONSTANT * temperature));
+                accepted = (distance_new > distance_old) || (rng_uniform(rng) < expo);
+            } else if (mtm != NULL) {
+                /* draw a batch of candidates and select one of them */
+                PERF_BEGIN(PERF_EVALUATE);
+                accepted = mtm_propose(mtm, index, &points[index], variance * variance,
+                                       temperature, rng, &v_new, &distance_delta);
+                distance_new = distance_cur + distance_delta;
+                PERF_END(PERF_EVALUATE);
+            } else {
+                /* perform the random walk */
+                PERF_BEGIN(PERF_PROPOSE);
+                v_new = sphere_walk(&points[index], variance * variance, rng);
+                PERF_END(PERF_PROPOSE);
 
-            if (distance_new > distance_old) {
-                /* accept the new distance, because it is bigger */
+                /*
+                 * only the distances to the moved walker change, so the new distance is
+                 * the current one plus the difference of the walker's contributions.
+                 */
+                PERF_BEGIN(PERF_EVALUATE);
+                distance_delta = kernel_distanceTo(&store, index, &v_new)
+                    - kernel_distanceTo(&store, index, &points[index]);
+                distance_new = distance_cur + distance_delta;
+
+                expo = exp(-fabs(distance_delta) /
+                        ((double) BOLTZMANN_CONSTANT * temperature));
+                PERF_END(PERF_EVALUATE);
+
+                /*
+                 * accept the new distance, if it is bigger. Otherwise, accept it with a given
+                 * probability anyway to be able to escape local minima.
+                 */
+                accepted = (distance_new > distance_old) || (rng_uniform(rng) < expo);
+            }
+            PERF_COUNT(PERF_PROPOSALS, 1);
+
+            if (accepted) {
+                PERF_BEGIN(PERF_COMMIT);
+                if (spec != NULL) {
+                    spec_commit(spec);
+                }
+                best_moved(best, index);
                 vector_copy(&points[index], &v_new);
+                points_set(&store, index, &v_new);
                 distance_cur = distance_new;
-                accepted = 1;
+                PERF_END(PERF_COMMIT);
 
                 /*
                  * if the new distance is higher than the best distance,
                  * then keep the best configuration.
                  */
-                if (distance_best < distance_new) {
-                    vector_arrayCopy(
-                            &best_points[0],
-                            &points[0],
-                            (int) globalArgs->n);
+                if (distance_new > distance_old && distance_best < distance_new) {
+                    PERF_BEGIN(PERF_BEST);
+                    best_improved(best);
+                    PERF_END(PERF_BEST);
 
                     distance_best = distance_new;
                     distance_cur = distance_best;
-                  }
-            } else if (drand48() < expo) {
-                /*
-                 * if the new distance is not higher than the old one
-                 * then accept with a given probability anyway to be able to escape
-                 * local minima.
-                 */
-                vector_copy(&points[index], &v_new);
-                distance_cur = distance_old;
-                accepted = 1;
+                }
             }
 
-            logging_logSim(iteration, distance_cur, distance_delta, temperature, variance, accepted);
+            accepted_level += accepted;
+            schedule_observe(&schedule, distance_cur);
+            PERF_COUNT(PERF_ACCEPTED, accepted);
+            PERF_BEGIN(PERF_LOGGING);
+            if (output->progress != NULL) {
+                output->progress(output->arg, iteration, distance_cur, distance_delta, temperature,
+                                 variance, accepted);
+            }
+            PERF_END(PERF_LOGGING);
             iteration++;
+
+            /* recompute the distance from scratch to bound the drift of the running sum */
+            if (iteration % T_RESYNC == 0) {
+                PERF_BEGIN(PERF_RESYNC);
+                distance_cur = eval_distance(pool, &store);
+                PERF_END(PERF_RESYNC);
+            }
         }
 
-        anneal(&temperature, globalArgs->damping);
+        if (adapt != NULL) {
+            adapt_update(adapt, (spec != NULL) ? 0 : index, variance, accepted_level,
+                         globalArgs->iter);
+        }
+
+        temperature = schedule_next(&schedule, globalArgs, temperature, distance_best);
+        PERF_COUNT(PERF_LEVELS, 1);
+        PERF_BEGIN(PERF_CHECKPOINT);
+        best_materialise(best);
+        checkpoint(output, &due, globalArgs, rng, temperature, iteration, distance_cur,
+                   distance_best, theta, points, best_points, adapt, &schedule);
+        PERF_END(PERF_CHECKPOINT);
     } while (temperature > T_MIN);
 
-    for (k = 0; k < globalArgs->n; k++) {
-        logging_logBest((best_points + k)->x, (best_points + k)->y, (best_points + k)->z);
+    best_materialise(best);
+    sa_polish(pool, best_points, globalArgs);
+
+    /* the points return the best configuration */
+    vector_arrayCopy(&points[0], &best_points[0], globalArgs->n);
+    reportDistance(pool, &store, globalArgs, theta);
+
+    spec_destroy(spec);
+    mtm_destroy(mtm);
+    adapt_destroy(adapt);
+    pool_destroy(pool);
+    points_free(&store);
+
+    return SUCCESS;
+}
+
+/**
+ * Update the spatial index after the two points of a pair have been moved.
+ *
+ * @param struct cells_t *const the spatial index (may be NULL)
+ * @param const int* the indices of the pair
+ */
+static void moved(struct cells_t *const cells, const int *index_pair)
+{
+    if (cells != NULL) {
+        cells_move(cells, index_pair[0]);
+        cells_move(cells, index_pair[1]);
     }
 }
 
 /**
  * This is the heart of the simulation using simulated annealing.
  *
- * @param struct vector* the points to be distributed across a sphere
+ * @param struct vector* the points to be distributed across a sphere, which return the best
+ *        configuration
+ * @param const struct globalArgs_t* the parameters of the simulation
+ * @param struct rng_t *const the random number generator
+ * @param const struct checkpoint_t *const the checkpoint to resume from (NULL for a new run)
+ * @param struct workspace_t *const the workspace the configurations are allocated from
+ * @param const struct output_t *const where the run reports to
+ * @return int SUCCESS, or FAIL if the memory could not be allocated
  */
-void sa_closeness(struct vector_t *points, const struct globalArgs_t const* globalArgs)
+int sa_closeness(struct vector_t *points, const struct globalArgs_t const* globalArgs,
+                 struct rng_t *const rng, const struct checkpoint_t *const resume,
+                 struct workspace_t *const workspace, const struct output_t *const output)
 {
     double temperature = globalArgs->temp;
     double distance_old, distance_new, distance_best, distance_cur, distance_delta, expo, variance;
-    struct vector_t new_points[globalArgs->n];
-    struct vector_t best_points[globalArgs->n];
+    struct vector_t *best_points;
+    struct best_t *best;
+    struct vector_t v_old[2];
     struct vector_t v_new[2];
+    struct points_t store;
+    struct pool_t *pool;
+    struct cells_t *cells;
+    double theta;
     int index_min[2];
     int k = 0;
     int accepted = 0;
+    int accepted_level = 0;
     long iteration = 0;
+    struct timespec due = {0, 0};
+    struct adapt_t *adapt;
+    struct schedule_t schedule;
+
+    /* the best configuration is too large for the stack */
+    best_points = (struct vector_t *) workspace_alloc(workspace,
+                                                      globalArgs->n * sizeof(struct vector_t));
+    best = (best_points == NULL) ? NULL
+        : best_create(workspace, best_points, points, globalArgs->n);
+    if (best == NULL) {
+        fprintf(stderr, "Could not allocate the best configuration of %d points\n", globalArgs->n);
+        return FAIL;
+    }
+
+    /* the pair kernels operate on a structure-of-arrays copy of the points */
+    if (points_alloc(&store, globalArgs->n) == FAIL) {
+        fprintf(stderr, "Could not allocate the point store for %d points\n", globalArgs->n);
+        return FAIL;
+    }
+    points_fromVectors(&store, &points[0]);
+
+    /* the whole configuration is evaluated in parallel */
+    pool = pool_create(globalArgs->threads);
+
+    /* the spatial index keeps track of the closest pair as points move */
+    cells = cells_create(&store);
 
-    vector_arrayCopy(&new_points[0], &points[0], globalArgs->n);
+    theta = sa_openingAngle(pool, &store, globalArgs);
+    adapt = adaptive(globalArgs, resume);
+    vector_arrayCopy(&best_points[0], &points[0], globalArgs->n);
 
     distance_best = 0.0;
 
+    if (resume != NULL) {
+        /* continue from the end of the checkpointed level */
+        temperature = resume->temperature;
+        iteration = resume->iteration;
+        distance_cur = resume->current;
+        distance_best = resume->best;
+        vector_arrayCopy(&best_points[0], &resume->best_points[0], globalArgs->n);
+    } else {
+        distance_cur = eval_distance(pool, &store);
+    }
+
+    /* the schedule of a resumed run continues where it was checkpointed */
+    schedule_init(&schedule, 1, distance_best);
+    if (resume != NULL) {
+        schedule = resume->schedule;
+    }
+
     do {
-        /* select a random walker */
-        sphere_selectClosest(&points[0], globalArgs->n, index_min);
+        /* select the closest pair, searching all pairs if the index cannot provide it */
+        if (cells == NULL || cells_closest(cells, index_min) == DBL_MAX) {
+            eval_closest(pool, &store, index_min);
+        }
 
         // the variance should be between 0.9 and 0
 //        variance = 0.9 * (1 - exp(-0.5 * temperature));
-        variance = 0.01;
+        variance = T_APART;
+        if (adapt != NULL) {
+            variance = adapt_scale(adapt, index_min[0], variance);
+        }
+        accepted_level = 0;
 
 
         for (k = 0; k < globalArgs->iter; k++) {
-            vector_arrayCopy(
-                &new_points[0],
-                &points[0],
-                (int) globalArgs->n);
+            PERF_BEGIN(PERF_PROPOSE);
+            vector_copy(&v_old[0], &points[index_min[0]]);
+            vector_copy(&v_old[1], &points[index_min[1]]);
+            vector_copy(&v_new[0], &v_old[0]);
+            vector_copy(&v_new[1], &v_old[1]);
 
             /* perform the random walk */
-            sphere_moveApart(&new_points[index_min[0]], &new_points[index_min[1]], variance);
+            sphere_moveApart(&v_new[0], &v_new[1], variance);
+            PERF_END(PERF_PROPOSE);
 
-            /* calcuate the old and the new distance */
-            distance_old = sphere_distance(&points[0], globalArgs->n);
-            distance_new = sphere_distance(&new_points[0], globalArgs->n);
-            distance_delta = distance_new - distance_old;
+            /* sum up the contributions of both walkers */
+            PERF_BEGIN(PERF_EVALUATE);
+            distance_delta = pairDelta(&store, index_min, v_old, v_new);
+            distance_old = distance_cur;
+            distance_new = distance_cur + distance_delta;
             accepted = 0;
 
-            expo = exp(-abs(distance_delta) /
+            expo = exp(-fabs(distance_delta) /
                     ((double) BOLTZMANN_CONSTANT * temperature));
+            PERF_END(PERF_EVALUATE);
+            PERF_COUNT(PERF_PROPOSALS, 1);
 
             if (distance_new > distance_old) {
                 /* accept the new distance, because it is bigger */
+                PERF_BEGIN(PERF_COMMIT);
+                best_moved(best, index_min[0]);
+                best_moved(best, index_min[1]);
                 vector_copy(&points[index_min[0]], &v_new[0]);
                 vector_copy(&points[index_min[1]], &v_new[1]);
+                points_set(&store, index_min[0], &v_new[0]);
+                points_set(&store, index_min[1], &v_new[1]);
+                moved(cells, index_min);
                 distance_cur = distance_new;
                 accepted = 1;
+                PERF_END(PERF_COMMIT);
 
                 /*
                  * if the new distance is higher than the best distance,
                  * then keep the best configuration.
                  */
                 if (distance_best < distance_new) {
-                    vector_arrayCopy(
-                            &best_points[0],
-                            &points[0],
-                            (int) globalArgs->n);
+                    PERF_BEGIN(PERF_BEST);
+                    best_improved(best);
+                    PERF_END(PERF_BEST);
 
                     distance_best = distance_new;
                     distance_cur = distance_best;
                   }
-            } else if (drand48() < expo) {
+            } else if (rng_uniform(rng) < expo) {
                 /*
                  * if the new distance is not higher than the old one
                  * then accept with a given probability anyway to be able to escape
                  * local minima.
                  */
+                PERF_BEGIN(PERF_COMMIT);
+                best_moved(best, index_min[0]);
+                best_moved(best, index_min[1]);
                 vector_copy(&points[index_min[0]], &v_new[0]);
                 vector_copy(&points[index_min[1]], &v_new[1]);
-                distance_cur = distance_old;
+                points_set(&store, index_min[0], &v_new[0]);
+                points_set(&store, index_min[1], &v_new[1]);
+                moved(cells, index_min);
+                distance_cur = distance_new;
                 accepted = 1;
+                PERF_END(PERF_COMMIT);
             }
 
-            logging_logSim(iteration, distance_cur, distance_delta, temperature, variance, accepted);
+            accepted_level += accepted;
+            schedule_observe(&schedule, distance_cur);
+            PERF_COUNT(PERF_ACCEPTED, accepted);
+            PERF_BEGIN(PERF_LOGGING);
+            if (output->progress != NULL) {
+                output->progress(output->arg, iteration, distance_cur, distance_delta, temperature,
+                                 variance, accepted);
+            }
+            PERF_END(PERF_LOGGING);
             iteration++;
+
+            /* recompute the distance from scratch to bound the drift of the running sum */
+            if (iteration % T_RESYNC == 0) {
+                PERF_BEGIN(PERF_RESYNC);
+                distance_cur = eval_distance(pool, &store);
+                PERF_END(PERF_RESYNC);
+            }
+        }
+
+        if (adapt != NULL) {
+            adapt_update(adapt, index_min[0], variance, accepted_level, globalArgs->iter);
         }
 
-        anneal(&temperature, globalArgs->damping);
+        temperature = schedule_next(&schedule, globalArgs, temperature, distance_best);
+        PERF_COUNT(PERF_LEVELS, 1);
+        PERF_BEGIN(PERF_CHECKPOINT);
+        best_materialise(best);
+        checkpoint(output, &due, globalArgs, rng, temperature, iteration, distance_cur,
+                   distance_best, theta, points, best_points, adapt, &schedule);
+        PERF_END(PERF_CHECKPOINT);
     } while (temperature > T_MIN);
 
-    for (k = 0; k < globalArgs->n; k++) {
-        logging_logBest((best_points + k)->x, (best_points + k)->y, (best_points + k)->z);
+    best_materialise(best);
+    sa_polish(pool, best_points, globalArgs);
+
+    /* the points return the best configuration */
+    vector_arrayCopy(&points[0], &best_points[0], globalArgs->n);
+    reportDistance(pool, &store, globalArgs, theta);
+
+    cells_destroy(cells);
+    adapt_destroy(adapt);
+    pool_destroy(pool);
+    points_free(&store);
+
+    return SUCCESS;
+}
+
+/**
+ * The energy of the configuration. It is approximated with the cutoff neighbour lists, if there
+ * are any, and evaluated exactly otherwise, just like the energy differences of the moves.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param const struct points_t *const the point store
+ * @param const struct verlet_t *const the neighbour lists (may be NULL)
+ * @return the energy of the configuration
+ */
+static double energy(struct pool_t *const pool, const struct points_t *const store,
+                     const struct verlet_t *const verlet)
+{
+    if (verlet != NULL) {
+        return verlet_energy(verlet);
+    }
+
+    return eval_energy(pool, store);
+}
+
+/**
+ * The energy contribution of a single point at the given position, approximated with the cutoff
+ * neighbour lists, if there are any.
+ *
+ * @param const struct points_t *const the point store
+ * @param const struct verlet_t *const the neighbour lists (may be NULL)
+ * @param const int the index of the point
+ * @param const struct vector_t *const the position of the point
+ * @return the energy contribution of the point
+ */
+static double energyTo(const struct points_t *const store, const struct verlet_t *const verlet,
+                       const int index, const struct vector_t *const point)
+{
+    if (verlet != NULL) {
+        return verlet_energyTo(verlet, index, point);
     }
+
+    return kernel_energyTo(store, index, point);
 }
 
 /**
  * This is the heart of the simulation using simulated annealing.
  *
- * @param struct vector* the points to be distributed across a sphere
+ * @param struct vector* the points to be distributed across a sphere, which return the best
+ *        configuration
+ * @param const struct globalArgs_t* the parameters of the simulation
+ * @param struct rng_t *const the random number generator
+ * @param const struct checkpoint_t *const the checkpoint to resume from (NULL for a new run)
+ * @param struct workspace_t *const the workspace the configurations are allocated from
+ * @param const struct output_t *const where the run reports to
+ * @return int SUCCESS, or FAIL if the memory could not be allocated
  */
-void sa_energy(struct vector_t *points, const struct globalArgs_t const* globalArgs)
+int sa_energy(struct vector_t *points, const struct globalArgs_t const* globalArgs,
+              struct rng_t *const rng, const struct checkpoint_t *const resume,
+              struct workspace_t *const workspace, const struct output_t *const output)
 {
     double temperature = globalArgs->temp;
     double energy_old, energy_new, energy_best, energy_cur, energy_delta, expo, variance;
-    struct vector_t new_points[globalArgs->n];
-    struct vector_t best_points[globalArgs->n];
+    struct vector_t *best_points;
+    struct best_t *best;
     struct vector_t v_new;
+    struct points_t store;
+    struct pool_t *pool;
+    struct verlet_t *verlet = NULL;
+    double theta;
     int index = 0;
     int k = 0;
     int accepted = 0;
+    int accepted_level = 0;
     long iteration = 0;
+    struct timespec due = {0, 0};
+    struct adapt_t *adapt;
+    struct schedule_t schedule;
+    struct batch_t batch;
+    struct mtm_t *mtm;
+    struct spec_t *spec;
+
+    /* the best configuration is too large for the stack */
+    best_points = (struct vector_t *) workspace_alloc(workspace,
+                                                      globalArgs->n * sizeof(struct vector_t));
+    best = (best_points == NULL) ? NULL
+        : best_create(workspace, best_points, points, globalArgs->n);
+    if (best == NULL) {
+        fprintf(stderr, "Could not allocate the best configuration of %d points\n", globalArgs->n);
+        return FAIL;
+    }
 
-    vector_arrayCopy(&new_points[0], &points[0], globalArgs->n);
+    /* the pair kernels operate on a structure-of-arrays copy of the points */
+    if (points_alloc(&store, globalArgs->n) == FAIL) {
+        fprintf(stderr, "Could not allocate the point store for %d points\n", globalArgs->n);
+        return FAIL;
+    }
+    points_fromVectors(&store, &points[0]);
+
+    /* the whole configuration is evaluated in parallel */
+    pool = pool_create(globalArgs->threads);
+
+    /* approximate the energy with cutoff neighbour lists, if requested */
+    if (globalArgs->cutoff > 0.0) {
+        verlet = verlet_create(&store,
+                               globalArgs->cutoff * sqrt(4.0 * M_PI / globalArgs->n));
+
+        if (verlet == NULL) {
+            fprintf(stderr, "Could not allocate the neighbour lists, using the exact energy\n");
+        }
+    }
+
+    theta = sa_openingAngle(pool, &store, globalArgs);
+    adapt = adaptive(globalArgs, resume);
+    batch.store = &store;
+    batch.verlet = verlet;
+    mtm = multipleTry(globalArgs, -1, batchEnergy, &batch);
+    spec = speculative(globalArgs, mtm, verlet);
+    vector_arrayCopy(&best_points[0], &points[0], globalArgs->n);
 
     energy_best = DBL_MAX;
 
+    if (resume != NULL) {
+        /* continue from the end of the checkpointed level */
+        temperature = resume->temperature;
+        iteration = resume->iteration;
+        energy_cur = resume->current;
+        energy_best = resume->best;
+        vector_arrayCopy(&best_points[0], &resume->best_points[0], globalArgs->n);
+    } else {
+        energy_cur = energy(pool, &store, verlet);
+    }
+
+    /* the schedule of a resumed run continues where it was checkpointed */
+    schedule_init(&schedule, -1, energy_best);
+    if (resume != NULL) {
+        schedule = resume->schedule;
+    }
+
     do {
         /* select a random walker */
-        index = selectPoint(globalArgs->n);
+        index = selectPoint(rng, globalArgs->n);
         variance = 1 - exp(-0.5 * temperature);
+        if (adapt != NULL) {
+            /* the proposals of a speculative round share the step size of the first point */
+            variance = adapt_scale(adapt, (spec != NULL) ? 0 : index, variance);
+        }
+        accepted_level = 0;
 
         for (k = 0; k < globalArgs->iter; k++) {
-            /* perform the random walk */
-            v_new = sphere_walk(&points[index], variance);
+            energy_old = energy_cur;
 
-            /* copy the new location of the walker */
-            vector_copy(&new_points[index], &v_new);
+            if (spec != NULL) {
+                /* the proposals of a round of distinct points are scored in parallel */
+                PERF_BEGIN(PERF_EVALUATE);
+                if (k % spec_size(spec) == 0) {
+                    spec_round(spec, pool, &store, points, variance, rng, globalArgs->iter - k);
+                }
+                energy_delta = spec_next(spec, &index, &v_new);
+                energy_new = energy_cur + energy_delta;
 
-            /* calcuate the old and the new energy */
-            energy_old = sphere_rieszEnergy(&points[0], globalArgs->n);
-            energy_new = sphere_rieszEnergy(&new_points[0], globalArgs->n);
-            energy_delta = energy_new - energy_old;
-            accepted = 0;
+                expo = exp(-fabs(energy_delta) /
+                        ((double) BOLTZMANN_CONSTANT * temperature));
+                PERF_END(PERF_EVALUATE);
 
-            expo = exp(-abs(energy_delta) /
-                    ((double) BOLTZMANN_CONSTANT * temperature));
+                accepted = (energy_new < energy_old) || (rng_uniform(rng) < expo);
+            } else if (mtm != NULL) {
+                /* draw a batch of candidates and select one of them */
+                PERF_BEGIN(PERF_EVALUATE);
+                accepted = mtm_propose(mtm, index, &points[index], variance, temperature, rng,
+                                       &v_new, &energy_delta);
+                energy_new = energy_cur + energy_delta;
+                PERF_END(PERF_EVALUATE);
+            } else {
+                /* perform the random walk */
+                PERF_BEGIN(PERF_PROPOSE);
+                v_new = sphere_walk(&points[index], variance, rng);
+                PERF_END(PERF_PROPOSE);
+
+                /*
+                 * only the pair energies of the moved walker change, so the new energy is
+                 * the current one plus the difference of the walker's contributions.
+                 */
+                PERF_BEGIN(PERF_EVALUATE);
+                energy_delta = energyTo(&store, verlet, index, &v_new)
+                    - energyTo(&store, verlet, index, &points[index]);
+                energy_new = energy_cur + energy_delta;
 
-            if (energy_new < energy_old) {
-                /* accept the new energy, because it is bigger */
+                expo = exp(-fabs(energy_delta) /
+                        ((double) BOLTZMANN_CONSTANT * temperature));
+                PERF_END(PERF_EVALUATE);
+
+                /*
+                 * accept the new energy, if it is lower. Otherwise, accept it with a given
+                 * probability anyway to be able to escape local minima.
+                 */
+                accepted = (energy_new < energy_old) || (rng_uniform(rng) < expo);
+            }
+            PERF_COUNT(PERF_PROPOSALS, 1);
+
+            if (accepted) {
+                PERF_BEGIN(PERF_COMMIT);
+                if (spec != NULL) {
+                    spec_commit(spec);
+                }
+                best_moved(best, index);
                 vector_copy(&points[index], &v_new);
+                points_set(&store, index, &v_new);
+                if (verlet != NULL) {
+                    verlet_move(verlet, index);
+                }
                 energy_cur = energy_new;
-                accepted = 1;
+                PERF_END(PERF_COMMIT);
 
                 /*
-                 * if the new energy is higher than the best energy,
+                 * if the new energy is lower than the best energy,
                  * then keep the best configuration.
                  */
-                if (energy_best > energy_new) {
-                    vector_arrayCopy(
-                            &best_points[0],
-                            &points[0],
-                            (int) globalArgs->n);
+                if (energy_new < energy_old && energy_best > energy_new) {
+                    PERF_BEGIN(PERF_BEST);
+                    best_improved(best);
+                    PERF_END(PERF_BEST);
 
                     energy_best = energy_new;
                     energy_cur = energy_best;
-                  }
-            } else if (drand48() < expo) {
-                /*
-                 * if the new energy is not higher than the old one
-                 * then accept with a given probability anyway to be able to escape
-                 * local minima.
-                 */
-                vector_copy(&points[index], &v_new);
-                energy_cur = energy_old;
-                accepted = 1;
+                }
             }
 
-            logging_logSim(iteration, energy_cur, energy_delta, temperature, variance, accepted);
+            accepted_level += accepted;
+            schedule_observe(&schedule, energy_cur);
+            PERF_COUNT(PERF_ACCEPTED, accepted);
+            PERF_BEGIN(PERF_LOGGING);
+            if (output->progress != NULL) {
+                output->progress(output->arg, iteration, energy_cur, energy_delta, temperature,
+                                 variance, accepted);
+            }
+            PERF_END(PERF_LOGGING);
             iteration++;
+
+            /* recompute the energy from scratch to bound the drift of the running sum */
+            if (iteration % T_RESYNC == 0) {
+                PERF_BEGIN(PERF_RESYNC);
+                energy_cur = energy(pool, &store, verlet);
+                PERF_END(PERF_RESYNC);
+            }
         }
 
-        anneal(&temperature, globalArgs->damping);
+        if (adapt != NULL) {
+            adapt_update(adapt, (spec != NULL) ? 0 : index, variance, accepted_level,
+                         globalArgs->iter);
+        }
+
+        temperature = schedule_next(&schedule, globalArgs, temperature, energy_best);
+        PERF_COUNT(PERF_LEVELS, 1);
+        PERF_BEGIN(PERF_CHECKPOINT);
+        best_materialise(best);
+        checkpoint(output, &due, globalArgs, rng, temperature, iteration, energy_cur,
+                   energy_best, theta, points, best_points, adapt, &schedule);
+        PERF_END(PERF_CHECKPOINT);
     } while (temperature > T_MIN);
 
-    for (k = 0; k < globalArgs->n; k++) {
-        logging_logBest((best_points + k)->x, (best_points + k)->y, (best_points + k)->z);
+    best_materialise(best);
+    sa_polish(pool, best_points, globalArgs);
+
+    /* the points return the best configuration */
+    vector_arrayCopy(&points[0], &best_points[0], globalArgs->n);
+
+    /* compare the approximate energy of the final configuration with the exact one */
+    if ((verlet != NULL || theta > 0.0) && globalArgs->reportError) {
+        energy_cur = (verlet != NULL) ? energy(pool, &store, verlet)
+            : tree_energy(pool, &store, theta);
+        energy_old = eval_energy(pool, &store);
+        fprintf(stderr, "Approximate energy %f, exact energy %f, relative error %e\n",
+                energy_cur, energy_old, fabs(energy_cur - energy_old) / fabs(energy_old));
+
+        if (verlet != NULL) {
+            fprintf(stderr, "%ld neighbour list rebuilds\n", verlet_rebuilds(verlet));
+        }
     }
+
+    verlet_destroy(verlet);
+    spec_destroy(spec);
+    mtm_destroy(mtm);
+    adapt_destroy(adapt);
+    pool_destroy(pool);
+    points_free(&store);
+
+    return SUCCESS;
 }
@@ -0,0 +1,251 @@
+/**
+ * This module is the entry point of the libsasphere library. A context holds everything a run
+ * needs besides its parameters: the random number generator, the workspace the configurations
+ * are allocated from, and the callbacks the progress is reported to. A run sets up the initial
+ * configuration in the points it is given, anneals them, and returns the best configuration in
+ * them, so that an application embedding the library does not go through any files. The initial
+ * configuration is random, or fitted from a configuration the context is given to start from.
+ *
+ * @author Dominik Dahlem
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "checkpoint.h"
+#include "global.h"
+#include "logging.h"
+#include "output.h"
+#include "perf.h"
+#include "pt.h"
+#include "rng.h"
+#include "sa.h"
+#include "sasphere.h"
+#include "sphere.h"
+#include "vector.h"
+#include "warm.h"
+#include "workspace.h"
+
+
+/**
+ * The context of the runs.
+ */
+struct sasphere_t {
+    struct globalArgs_t args; /** the parameters of the runs */
+    struct rng_t rng; /** the random number generator */
+    struct workspace_t *workspace; /** the workspace the configurations are allocated from */
+    struct output_t output; /** where the runs report to */
+    const struct warm_t *warm; /** the configuration the runs start from (NULL for a random one) */
+};
+
+
+/**
+ * Initialise the parameters with the defaults.
+ *
+ * @param struct globalArgs_t *const the parameters
+ */
+void sasphere_defaults(struct globalArgs_t *const args)
+{
+    args->seed = (long) SASPHERE_SEED;
+    args->uniform = 0;
+    args->temp = T_INITIAL;
+    args->initialAcceptance = T_INITIAL_ACCEPTANCE;
+    args->iter = T_ITERATION;
+    args->damping = T_DAMPING;
+    args->n = SASPHERE_POINTS;
+    args->threads = T_THREADS;
+    args->replicas = T_REPLICAS;
+    args->objective = OBJECTIVE_DISTANCE;
+    args->cutoff = T_CUTOFF;
+    args->reportError = 0;
+    args->theta = T_THETA;
+    args->accuracy = T_ACCURACY;
+    args->sampling = T_SAMPLING;
+    args->block = 0;
+    args->checkpoint = T_CHECKPOINT;
+    args->acceptance = T_ACCEPTANCE;
+    args->perPoint = 0;
+    args->schedule = SCHEDULE_GEOMETRIC;
+    args->patience = T_PATIENCE;
+    args->plateau = T_PLATEAU;
+    args->tries = T_TRIES;
+    args->speculative = T_SPECULATIVE;
+    args->polish = T_POLISH;
+}
+
+/**
+ * Create a context. The random number generator is seeded with the seed of the parameters.
+ *
+ * @param const struct globalArgs_t *const the parameters of the runs
+ * @param const struct output_t *const where the runs report to (NULL for nowhere)
+ * @return struct sasphere_t* the context or NULL, if the memory could not be allocated
+ */
+struct sasphere_t *sasphere_create(const struct globalArgs_t *const args,
+                                   const struct output_t *const output)
+{
+    struct sasphere_t *sasphere = (struct sasphere_t *) calloc(1, sizeof(struct sasphere_t));
+
+    if (sasphere == NULL) {
+        return NULL;
+    }
+
+    sasphere->workspace = workspace_create();
+
+    if (sasphere->workspace == NULL) {
+        free(sasphere);
+        return NULL;
+    }
+
+    sasphere->args = *args;
+
+    if (output != NULL) {
+        sasphere->output = *output;
+    }
+
+    rng_seed(&sasphere->rng, args->seed);
+
+    return sasphere;
+}
+
+/**
+ * Destroy a context.
+ *
+ * @param struct sasphere_t* the context (may be NULL)
+ */
+void sasphere_destroy(struct sasphere_t *sasphere)
+{
+    if (sasphere != NULL) {
+        workspace_destroy(sasphere->workspace);
+        free(sasphere);
+    }
+}
+
+/**
+ * Replace the random number generator of the context, e.g. by a stream of its own.
+ *
+ * @param struct sasphere_t *const the context
+ * @param const struct rng_t *const the random number generator
+ */
+void sasphere_seed(struct sasphere_t *const sasphere, const struct rng_t *const rng)
+{
+    sasphere->rng = *rng;
+}
+
+/**
+ * Start the runs of the context from the given configuration instead of a random one. The
+ * configuration is not copied and has to outlive the runs.
+ *
+ * @param struct sasphere_t *const the context
+ * @param const struct warm_t *const the configuration (NULL for a random one)
+ */
+void sasphere_warm(struct sasphere_t *const sasphere, const struct warm_t *const warm)
+{
+    sasphere->warm = warm;
+}
+
+/**
+ * @param const struct sasphere_t *const the context
+ * @return const struct workspace_t* the workspace the configurations of the runs are allocated
+ *         from
+ */
+const struct workspace_t *sasphere_workspace(const struct sasphere_t *const sasphere)
+{
+    return sasphere->workspace;
+}
+
+/**
+ * Set up the initial configuration and anneal it.
+ *
+ * @param struct sasphere_t *const the context
+ * @param const struct checkpoint_t *const the checkpoint to resume from (NULL for a new run)
+ * @param struct vector_t *const room for the points of the run, which return the best
+ *        configuration
+ * @return int SUCCESS, or FAIL if the memory could not be allocated or the closeness is to be
+ *         optimised by parallel tempering
+ */
+static int run(struct sasphere_t *const sasphere, const struct checkpoint_t *const resume,
+               struct vector_t *const points)
+{
+    struct globalArgs_t args = sasphere->args;
+    struct rng_t *const rng = &sasphere->rng;
+    const struct output_t *const output = &sasphere->output;
+
+    /* the configurations of the previous run are released */
+    workspace_reset(sasphere->workspace);
+
+    if (resume != NULL) {
+        args = resume->args;
+        args.threads = sasphere->args.threads;
+        args.sampling = sasphere->args.sampling;
+        args.block = sasphere->args.block;
+        args.checkpoint = sasphere->args.checkpoint;
+        args.reportError = sasphere->args.reportError;
+    }
+
+    /* the parallel tempering has no move for the closeness */
+    if (args.replicas > 1 && args.objective == OBJECTIVE_CLOSENESS) {
+        fprintf(stderr, "Parallel tempering optimises the distance or the energy, not the "
+                "closeness\n");
+        return FAIL;
+    }
+
+    /* select the method to set up the initial configuration */
+    if (resume != NULL) {
+        vector_arrayCopy(&points[0], &resume->points[0], args.n);
+        *rng = resume->rng;
+    } else if (sasphere->warm != NULL) {
+        if (warm_fit(&points[0], args.n, sasphere->warm, rng) == FAIL) {
+            return FAIL;
+        }
+    } else if (args.uniform) {
+        sphere_initialiseUniformPoints(&points[0], args.n, rng);
+    } else {
+        sphere_initialiseCluster(&points[0], args.n, rng);
+    }
+
+    /* estimate the initial temperature, which a resumed run has taken from the checkpoint */
+    if (resume == NULL && args.initialAcceptance > 0.0) {
+        args.temp = sa_initialTemperature(&points[0], &args, rng);
+        fprintf(stderr, "Initial temperature %f for an initial acceptance ratio of %f\n",
+                args.temp, args.initialAcceptance);
+    }
+
+    if (output->start != NULL) {
+        output->start(output->arg, &args, &points[0]);
+    }
+
+    if (args.replicas > 1) {
+        return pt_run(&points[0], &args, rng, sasphere->workspace, output);
+    } else if (args.objective == OBJECTIVE_ENERGY) {
+        return sa_energy(&points[0], &args, rng, resume, sasphere->workspace, output);
+    } else if (args.objective == OBJECTIVE_CLOSENESS) {
+        return sa_closeness(&points[0], &args, rng, resume, sasphere->workspace, output);
+    }
+
+    return sa_distance(&points[0], &args, rng, resume, sasphere->workspace, output);
+}
+
+/**
+ * Anneal a configuration. A new run starts from a configuration set up with the random number
+ * generator of the context, or fitted from the configuration given with sasphere_warm. A resumed
+ * run takes its parameters from the checkpoint, except for the ones that do not change the
+ * results, and continues with the configurations and the random number generator of the
+ * checkpoint. The run is counted into the accumulators of the output, if there are any.
+ *
+ * @param struct sasphere_t *const the context
+ * @param const struct checkpoint_t *const the checkpoint to resume from (NULL for a new run)
+ * @param struct vector_t *const room for the points of the run, which return the best
+ *        configuration
+ * @return int SUCCESS, or FAIL if the memory could not be allocated or the closeness is to be
+ *         optimised by parallel tempering
+ */
+int sasphere_run(struct sasphere_t *const sasphere, const struct checkpoint_t *const resume,
+                 struct vector_t *const points)
+{
+    int status;
+
+    PERF_ATTACH(sasphere->output.perf);
+    status = run(sasphere, resume, points);
+    PERF_DETACH();
+
+    return status;
+}
@@ -0,0 +1,135 @@
+/**
+ * This module contains the cooling schedules of the simulated annealing and the termination on
+ * stagnation. The schedule is asked for the temperature of the next level at the end of every
+ * level, and it returns 0 to stop the annealing early.
+ *
+ * - geometric: \f$ T_{k+1} = d T_k \f$
+ * - logarithmic: \f$ T_k = T_0 / (1 + a \log(1 + k)) \f$, where a is chosen such that the
+ *   minimum temperature is reached after as many levels as with the geometric schedule. It cools
+ *   quickly at first and spends most levels at low temperatures.
+ * - adaptive: \f$ T_{k+1} = d^{T_k / \sigma_k} T_k \f$ after Huang et al., where \f$ \sigma_k \f$
+ *   is the standard deviation of the objective during level k. The schedule slows down where the
+ *   objective fluctuates strongly compared to the temperature, i.e. around phase transitions.
+ * - reheating: geometric, but after SCHEDULE_STAGNATION levels without improvement the
+ *   temperature is raised to a multiple of the temperature of the last improvement.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include "global.h"
+#include "sa.h"
+#include "schedule.h"
+
+
+/**
+ * Initialise a schedule.
+ *
+ * @param struct schedule_t *const the schedule
+ * @param const int 1, if the objective is maximised, -1 if it is minimised
+ * @param const double the best objective so far
+ */
+void schedule_init(struct schedule_t *const schedule, const int sense, const double best)
+{
+    schedule->level = 0;
+    schedule->stagnant = 0;
+    schedule->reheats = 0;
+    schedule->sense = sense;
+    schedule->best = best;
+    schedule->improved = 0.0;
+    schedule->n = 0;
+    schedule->mean = 0.0;
+    schedule->m2 = 0.0;
+}
+
+/**
+ * Record the objective after a proposal.
+ *
+ * @param struct schedule_t *const the schedule
+ * @param const double the objective
+ */
+void schedule_observe(struct schedule_t *const schedule, const double objective)
+{
+    double d;
+
+    /* Welford's update of the mean and the squared deviations */
+    schedule->n++;
+    d = objective - schedule->mean;
+    schedule->mean += d / (double) schedule->n;
+    schedule->m2 += d * (objective - schedule->mean);
+}
+
+/**
+ * The temperature of the next level.
+ *
+ * @param struct schedule_t *const the schedule
+ * @param const struct globalArgs_t *const the parameters of the simulation
+ * @param const double the temperature of the completed level
+ * @param const double the best objective so far
+ * @return the temperature of the next level, or 0 to stop
+ */
+double schedule_next(struct schedule_t *const schedule, const struct globalArgs_t *const globalArgs,
+                     const double temperature, const double best)
+{
+    double next = globalArgs->damping * temperature;
+    double levels, a, exponent;
+
+    schedule->level++;
+
+    if (schedule->sense * (best - schedule->best) > globalArgs->plateau * fabs(schedule->best)) {
+        schedule->best = best;
+        schedule->improved = temperature;
+        schedule->stagnant = 0;
+    } else {
+        schedule->stagnant++;
+    }
+
+    if (globalArgs->patience > 0 && schedule->stagnant >= globalArgs->patience) {
+        fprintf(stderr, "Stopped after %ld levels, the best objective did not improve for %ld "
+                "levels\n", schedule->level, schedule->stagnant);
+        return 0.0;
+    }
+
+    switch (globalArgs->schedule) {
+        case SCHEDULE_LOGARITHMIC:
+            levels = ceil(log(T_MIN / globalArgs->temp) / log(globalArgs->damping));
+
+            if (levels >= 1.0) {
+                a = (globalArgs->temp / T_MIN - 1.0) / log(1.0 + levels);
+                next = globalArgs->temp / (1.0 + a * log(1.0 + (double) schedule->level));
+            }
+            break;
+        case SCHEDULE_ADAPTIVE:
+            exponent = SCHEDULE_EXPONENT_MAX;
+
+            if (schedule->n > 1 && schedule->m2 > 0.0) {
+                exponent = temperature / sqrt(schedule->m2 / (double) (schedule->n - 1));
+            }
+
+            exponent = (exponent < SCHEDULE_EXPONENT_MIN) ? SCHEDULE_EXPONENT_MIN : exponent;
+            exponent = (exponent > SCHEDULE_EXPONENT_MAX) ? SCHEDULE_EXPONENT_MAX : exponent;
+            next = pow(globalArgs->damping, exponent) * temperature;
+            break;
+        case SCHEDULE_REHEAT:
+            if (schedule->stagnant >= SCHEDULE_STAGNATION && schedule->reheats < SCHEDULE_REHEATS
+                && schedule->improved > 0.0) {
+                a = SCHEDULE_REHEAT_FACTOR * schedule->improved;
+                a = (a > globalArgs->temp) ? globalArgs->temp : a;
+                next = (a > next) ? a : next;
+                schedule->reheats++;
+                schedule->stagnant = 0;
+                fprintf(stderr, "Reheating to %f after level %ld\n", next, schedule->level);
+            }
+            break;
+        case SCHEDULE_GEOMETRIC:
+        default:
+            break;
+    }
+
+    schedule->n = 0;
+    schedule->mean = 0.0;
+    schedule->m2 = 0.0;
+
+    return next;
+}
@@ -0,0 +1,235 @@
+/**
+ * This module runs the Metropolis proposals of several points at the same time. A round draws B
+ * distinct points and one random walk for each of them, and the threads of the pool score all
+ * walks in parallel against the configuration at the start of the round. The proposals are then
+ * committed one after the other by the annealer.
+ *
+ * The score of a proposal ignores the moves committed before it in the same round. As the
+ * points of a round are distinct, only the pair terms between the proposal and those moved
+ * points are off, and the difference of the proposal is corrected exactly by
+ * \f$ \sum_j \phi(x'_i, x'_j) - \phi(x'_i, x_j) - \phi(x_i, x'_j) + \phi(x_i, x_j) \f$ over the
+ * committed moves j of the round, at O(B) cost. Every proposal is therefore accepted with the
+ * exact Metropolis probability of the configuration it is applied to, i.e. the chain is the one
+ * of a sequential annealer that visits the points of a round in order. The only difference is
+ * the selection of the points, which are drawn without replacement within a round. The
+ * selection does not depend on the configuration, so the detailed balance of every step holds.
+ *
+ * All random numbers are drawn by the calling thread, so the results do not depend on the
+ * number of threads.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdlib.h>
+
+#include "global.h"
+#include "kernel.h"
+#include "points.h"
+#include "pool.h"
+#include "rng.h"
+#include "spec.h"
+#include "sphere.h"
+#include "vector.h"
+
+
+/**
+ * The state of the speculative proposals.
+ */
+struct spec_t {
+    int size; /** number of proposals per round B */
+    int count; /** number of proposals of the current round */
+    int next; /** the next proposal to be committed */
+    int energy; /** 1 for the pair energies, 0 for the distances */
+    const struct points_t *store; /** the configuration of the current round */
+    int *index; /** the points of the proposals */
+    struct vector_t *old; /** the positions of the points at the start of the round */
+    struct vector_t *proposed; /** the proposed positions */
+    double *delta; /** the change of the objective against the start of the round */
+    int *committed; /** flags the committed proposals */
+    char *taken; /** flags the points drawn in the current round */
+};
+
+
+/**
+ * Create the state of the speculative proposals.
+ *
+ * @param const int number of proposals per round (at most the number of points)
+ * @param const int number of points
+ * @param const enum objective_t the objective (distance or energy)
+ * @return struct spec_t* the state or NULL, if the memory could not be allocated
+ */
+struct spec_t *spec_create(const int size, const int n, const enum objective_t objective)
+{
+    struct spec_t *spec = (struct spec_t *) calloc(1, sizeof(struct spec_t));
+
+    if (spec == NULL) {
+        return NULL;
+    }
+
+    spec->size = (size < n) ? size : n;
+    spec->energy = (objective == OBJECTIVE_ENERGY);
+    spec->index = (int *) malloc(spec->size * sizeof(int));
+    spec->old = (struct vector_t *) malloc(spec->size * sizeof(struct vector_t));
+    spec->proposed = (struct vector_t *) malloc(spec->size * sizeof(struct vector_t));
+    spec->delta = (double *) malloc(spec->size * sizeof(double));
+    spec->committed = (int *) malloc(spec->size * sizeof(int));
+    spec->taken = (char *) calloc((size_t) n, sizeof(char));
+
+    if (spec->index == NULL || spec->old == NULL || spec->proposed == NULL
+        || spec->delta == NULL || spec->committed == NULL || spec->taken == NULL) {
+        spec_destroy(spec);
+        return NULL;
+    }
+
+    return spec;
+}
+
+/**
+ * Destroy the state of the speculative proposals.
+ *
+ * @param struct spec_t* the state (may be NULL)
+ */
+void spec_destroy(struct spec_t *spec)
+{
+    if (spec != NULL) {
+        free(spec->index);
+        free(spec->old);
+        free(spec->proposed);
+        free(spec->delta);
+        free(spec->committed);
+        free(spec->taken);
+        free(spec);
+    }
+}
+
+/**
+ * @param const struct spec_t *const the state
+ * @return int number of proposals per round
+ */
+int spec_size(const struct spec_t *const spec)
+{
+    return spec->size;
+}
+
+/**
+ * The pair term of the objective.
+ *
+ * @param const struct spec_t *const the state
+ * @param const struct vector_t *const the first point
+ * @param const struct vector_t *const the second point
+ * @return the distance or the pair energy of the points
+ */
+static double pair(const struct spec_t *const spec, const struct vector_t *const a,
+                   const struct vector_t *const b)
+{
+    double dx = a->x - b->x;
+    double dy = a->y - b->y;
+    double dz = a->z - b->z;
+    double d2 = dx * dx + dy * dy + dz * dz;
+
+    return spec->energy ? -log(d2) : sqrt(d2);
+}
+
+/**
+ * Score one proposal against the configuration at the start of the round.
+ *
+ * @param void* the state
+ * @param int the proposal
+ */
+static void scoreTask(void *arg, int task)
+{
+    struct spec_t *spec = (struct spec_t *) arg;
+    int index = spec->index[task];
+
+    if (spec->energy) {
+        spec->delta[task] = kernel_energyTo(spec->store, index, &spec->proposed[task])
+            - kernel_energyTo(spec->store, index, &spec->old[task]);
+    } else {
+        spec->delta[task] = kernel_distanceTo(spec->store, index, &spec->proposed[task])
+            - kernel_distanceTo(spec->store, index, &spec->old[task]);
+    }
+}
+
+/**
+ * Draw the proposals of a round and score them in parallel.
+ *
+ * @param struct spec_t *const the state
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @param const struct vector_t *const the configuration
+ * @param const double the variance of the random walk
+ * @param struct rng_t *const the random number generator
+ * @param const int number of proposals (at most the size of a round)
+ */
+void spec_round(struct spec_t *const spec, struct pool_t *const pool,
+                const struct points_t *const store, const struct vector_t *const points,
+                const double variance, struct rng_t *const rng, const int count)
+{
+    int index, r;
+
+    spec->count = (count < spec->size) ? count : spec->size;
+    spec->next = 0;
+    spec->store = store;
+
+    for (r = 0; r < spec->count; r++) {
+        do {
+            index = rng_index(rng, store->n);
+        } while (spec->taken[index]);
+
+        spec->taken[index] = 1;
+        spec->index[r] = index;
+        spec->old[r] = points[index];
+        spec->proposed[r] = sphere_walk(&points[index], variance, rng);
+        spec->committed[r] = 0;
+    }
+
+    for (r = 0; r < spec->count; r++) {
+        spec->taken[spec->index[r]] = 0;
+    }
+
+    /* make sure the kernels are selected before any of the workers may race to do so */
+    (void) kernel_name();
+
+    pool_run(pool, spec->count, scoreTask, spec);
+}
+
+/**
+ * The next proposal of the round with the change of the objective it causes in the current
+ * configuration.
+ *
+ * @param struct spec_t *const the state
+ * @param int* the point of the proposal
+ * @param struct vector_t *const the proposed position
+ * @return the change of the objective, corrected for the moves committed before in the round
+ */
+double spec_next(struct spec_t *const spec, int *index, struct vector_t *const proposal)
+{
+    int r = spec->next;
+    double delta = spec->delta[r];
+    int s;
+
+    for (s = 0; s < r; s++) {
+        if (spec->committed[s]) {
+            delta += pair(spec, &spec->proposed[r], &spec->proposed[s])
+                - pair(spec, &spec->proposed[r], &spec->old[s])
+                - pair(spec, &spec->old[r], &spec->proposed[s])
+                + pair(spec, &spec->old[r], &spec->old[s]);
+        }
+    }
+
+    *index = spec->index[r];
+    *proposal = spec->proposed[r];
+    spec->next++;
+
+    return delta;
+}
+
+/**
+ * Mark the proposal last returned by spec_next as committed.
+ *
+ * @param struct spec_t *const the state
+ */
+void spec_commit(struct spec_t *const spec)
+{
+    spec->committed[spec->next - 1] = 1;
+}
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "rng.h"
 #include "sphere.h"
 #include "vector.h"
 
@@ -16,11 +17,12 @@
 /**
  * Returns a uniform random number in the range of (-1, 1).
  *
+ * @param struct rng_t *const the random number generator
  * @return double the uniform random number
  */
-double getCoordinate()
+double getCoordinate(struct rng_t *const rng)
 {
-    return 2.0 * drand48() - 1.0;
+    return 2.0 * rng_uniform(rng) - 1.0;
 }
 
 /**
@@ -28,32 +30,30 @@ double getCoordinate()
  * - Step 1: generate 2 uniform variate random numbers, u and v;
  * - Step 2: \f$ y = \sqrt{-2 * \ln{u}} * \cos{2 * \pi (v - 0.5)} \f$
  *
+ * @param struct rng_t *const the random number generator
  * @return double the normally distributed variable \f$ \in [0, 1) \f$
  */
-double normalRV1()
+double normalRV1(struct rng_t *const rng)
 {
     double u = 0.0;
     double v = 0.0;
 
-    u = drand48();
-    v = drand48();
+    u = 1.0 - rng_uniform(rng);
+    v = rng_uniform(rng);
 
     return (sqrt(-2 * log(u)) * cos(2 * M_PI * v));
 }
 
-double normalRV()
+/**
+ * returns a normally distributed variable using the polar method. The variates are generated
+ * in batches by the random number generator, which keeps both variates of the polar method.
+ *
+ * @param struct rng_t *const the random number generator
+ * @return double the normally distributed variable
+ */
+double normalRV(struct rng_t *const rng)
 {
-    double u = 0.0;
-    double v = 0.0;
-    double w;
-
-    do {
-        u = getCoordinate();
-        v = getCoordinate();
-        w = u * u + v * v;
-    } while (w >= 1.0);
-
-    return u * sqrt((-2 * log(w)) / w);
+    return rng_normal(rng);
 }
 
 /**
@@ -122,9 +122,10 @@ double distance(const struct vector_t *const pointA, const struct vector_t *cons
  *     z &=& 1 - 2 * (u^2 + v^2)
  *   \f}
  *
+ * @param struct rng_t *const the random number generator
  * @return struct vector_t a point on the sphere given the algoritm described above.
  */
-struct vector_t sphere_getPoint()
+struct vector_t sphere_getPoint(struct rng_t *const rng)
 {
     struct vector_t vector;
     double x, y, x_squared, root;
@@ -134,8 +135,8 @@ struct vector_t sphere_getPoint()
     /* use the rejection method from Marsaglia (1972) to generate */
     /* uniformly distributed points on a sphere */
     do {
-        x = getCoordinate();
-        y = getCoordinate();
+        x = getCoordinate(rng);
+        y = getCoordinate(rng);
         x_squared = (x * x) + (y * y);
     } while (x_squared >= 1);
 
@@ -158,7 +159,8 @@ void sphere_selectClosest(struct vector_t *const points, const int numberTrans,
 {
     double dist_min = DBL_MAX;
     double dist;
-    int index_min_1, index_min_2;
+    int index_min_1 = 0;
+    int index_min_2 = 0;
     int i = 0;
     int j = 0;
 
@@ -194,18 +196,20 @@ void sphere_selectClosest(struct vector_t *const points, const int numberTrans,
  *
  * @param const struct vector_t *const the random walker
  * @param const double the variance
+ * @param struct rng_t *const the random number generator
  * @return struct vector_t the new location of the random walker
  */
-struct vector_t sphere_walk(const struct vector_t *const point, const double variance)
+struct vector_t sphere_walk(const struct vector_t *const point, const double variance,
+                            struct rng_t *const rng)
 {
     struct vector_t vector;
     double standardDeviation;
 
     standardDeviation = sqrt(variance);
 
-    vector.x = point->x + (normalRV() * standardDeviation);
-    vector.y = point->y + (normalRV() * standardDeviation);
-    vector.z = point->z + (normalRV() * standardDeviation);
+    vector.x = point->x + (normalRV(rng) * standardDeviation);
+    vector.y = point->y + (normalRV(rng) * standardDeviation);
+    vector.z = point->z + (normalRV(rng) * standardDeviation);
 
     vector_normalise(&vector);
 
@@ -243,7 +247,8 @@ void sphere_moveApart(struct vector_t *const pointA, struct vector_t *const poin
     vector_normalise(pointB);
 }
 
-struct vector_t sphere_walk2(const struct vector_t *const point, const double variance)
+struct vector_t sphere_walk2(const struct vector_t *const point, const double variance,
+                             struct rng_t *const rng)
 {
     struct vector_t vector_ret, vector_temp;
     double c, s2, cdist, sdist;
@@ -252,7 +257,7 @@ struct vector_t sphere_walk2(const struct vector_t *const point, const double va
     sdist = sin(variance);
 
     do {
-        vector_temp = sphere_getPoint();
+        vector_temp = sphere_getPoint(rng);
         c = vector_dotProduct(&vector_temp, point);
         s2 = 1.0 - c * c;
     } while (s2 < 0.01);
@@ -272,19 +277,21 @@ struct vector_t sphere_walk2(const struct vector_t *const point, const double va
  *
  * @param struct vector_t *const the allocated points
  * @param const int the number of points
+ * @param struct rng_t *const the random number generator
  */
-void sphere_initialiseCluster(struct vector_t *const points, const int numberTrans)
+void sphere_initialiseCluster(struct vector_t *const points, const int numberTrans,
+                              struct rng_t *const rng)
 {
     int i = 0;
     struct vector_t vector;
 
-    vector = sphere_getPoint();
+    vector = sphere_getPoint(rng);
     (points + 0)->x = vector.x;
     (points + 0)->y = vector.y;
     (points + 0)->z = vector.z;
 
     for (i = 1; i < numberTrans; i++) {
-        vector = sphere_walk(points, 1.0);
+        vector = sphere_walk(points, 1.0, rng);
         (points + i)->x = vector.x;
         (points + i)->y = vector.y;
         (points + i)->z = vector.z;
@@ -296,14 +303,16 @@ void sphere_initialiseCluster(struct vector_t *const points, const int numberTra
  *
  * @param struct vector_t *const the allocated point array
  * @param const in the number of points
+ * @param struct rng_t *const the random number generator
  */
-void sphere_initialiseUniformPoints(struct vector_t *const points, const int numberTrans)
+void sphere_initialiseUniformPoints(struct vector_t *const points, const int numberTrans,
+                                    struct rng_t *const rng)
 {
     int i = 0;
     struct vector_t vector;
 
     for (i = 0; i < numberTrans; i++) {
-        vector = sphere_getPoint();
+        vector = sphere_getPoint(rng);
 
         (points + i)->x = vector.x;
         (points + i)->y = vector.y;
@@ -311,6 +320,14 @@ void sphere_initialiseUniformPoints(struct vector_t *const points, const int num
     }
 }
 
+/**
+ * Calculates the logarithmic Riesz energy \f$ \sum_{i < j} \log{1 / \mid x_i - x_j \mid^2} \f$
+ * of the configuration.
+ *
+ * @param const struct vector_t *const the allocated point array
+ * @param const int the number of points
+ * @return the energy of the configuration
+ */
 double sphere_rieszEnergy(const struct vector_t *const points, const int numberTrans)
 {
     struct vector_t vector;
@@ -352,3 +369,56 @@ double sphere_distance(const struct vector_t *const points, const int numberTran
 
     return dist;
 }
+
+/**
+ * Calculates the energy contribution of a single point, i.e., the sum of the pair energies
+ * between the point at the given index and all other points. Moving a single point only changes
+ * these N-1 terms of sphere_rieszEnergy, so the energy difference of a move can be obtained in
+ * O(N) rather than O(N^2).
+ *
+ * @param const struct vector_t *const the allocated point array
+ * @param const int the number of points
+ * @param const int the index of the point
+ * @return the energy between the indexed point and all other points
+ */
+double sphere_rieszEnergy2(const struct vector_t *const points, const int numberTrans, const int index)
+{
+    struct vector_t vector;
+    double energy = 0.0;
+    int j = 0;
+
+    for (j = 0; j < numberTrans; j++) {
+        if (j != index) {
+            vector.x = (points + index)->x - (points + j)->x;
+            vector.y = (points + index)->y - (points + j)->y;
+            vector.z = (points + index)->z - (points + j)->z;
+            energy += log(1/(vector_dotProduct(&vector, &vector)));
+        }
+    }
+
+    return energy;
+}
+
+/**
+ * Calculates the distance contribution of a single point, i.e., the sum of the distances
+ * between the point at the given index and all other points. This is the O(N) counterpart of
+ * sphere_distance for a configuration in which only one point has moved.
+ *
+ * @param const struct vector_t *const the allocated point array
+ * @param const int the number of points
+ * @param const int the index of the point
+ * @return the distance between the indexed point and all other points
+ */
+double sphere_distance2(const struct vector_t *const points, const int numberTrans, const int index)
+{
+    double dist = 0.0;
+    int j = 0;
+
+    for (j = 0; j < numberTrans; j++) {
+        if (j != index) {
+            dist += distance((points + index), (points + j));
+        }
+    }
+
+    return dist;
+}
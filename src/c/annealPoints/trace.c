@@ -0,0 +1,295 @@
+/**
+ * This module writes the trace of the simulation. Instead of formatting a line of text for every
+ * proposal, the trace either keeps every k-th proposal or aggregates all proposals of a
+ * temperature level into one record. The records are buffered in columns and written as binary
+ * blocks, which the traceconv tool converts back into CSV.
+ *
+ * The levels are aggregated by the annealing thread (trace_aggregate), which hands only the
+ * completed levels to the thread writing the trace. A temperature level ends whenever the
+ * temperature of a proposal differs from the one before, so the annealers do not have to
+ * announce the levels.
+ *
+ * @author Dominik Dahlem
+ */
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "trace.h"
+
+
+/**
+ * The state of a trace.
+ */
+struct trace_t {
+    FILE *file; /** the trace file */
+    int sampling; /** record every sampling-th proposal, or aggregate the levels, if 0 */
+    uint32_t count; /** number of records in the current block */
+
+    /* the columns of a block of samples */
+    int64_t iteration[TRACE_BLOCK];
+    double objective[TRACE_BLOCK];
+    double delta[TRACE_BLOCK];
+    double temperature[TRACE_BLOCK];
+    double variance[TRACE_BLOCK];
+    uint8_t accepted[TRACE_BLOCK];
+
+    /* the additional columns of a block of levels */
+    int64_t level[TRACE_BLOCK];
+    double mean[TRACE_BLOCK];
+    double min[TRACE_BLOCK];
+    double max[TRACE_BLOCK];
+    double std[TRACE_BLOCK];
+    double acceptance[TRACE_BLOCK];
+    double seconds[TRACE_BLOCK];
+};
+
+
+/**
+ * @return the seconds elapsed since the given time
+ */
+static double elapsed(const struct timespec *const start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) (now.tv_sec - start->tv_sec) + 1e-9 * (double) (now.tv_nsec - start->tv_nsec);
+}
+
+/**
+ * Write the buffered block.
+ */
+static void flush(struct trace_t *const trace)
+{
+    uint32_t c = trace->count;
+
+    if (c == 0) {
+        return;
+    }
+
+    fwrite(&c, sizeof(uint32_t), 1, trace->file);
+
+    if (trace->sampling > 0) {
+        fwrite(trace->iteration, sizeof(int64_t), c, trace->file);
+        fwrite(trace->objective, sizeof(double), c, trace->file);
+        fwrite(trace->delta, sizeof(double), c, trace->file);
+        fwrite(trace->temperature, sizeof(double), c, trace->file);
+        fwrite(trace->variance, sizeof(double), c, trace->file);
+        fwrite(trace->accepted, sizeof(uint8_t), c, trace->file);
+    } else {
+        fwrite(trace->level, sizeof(int64_t), c, trace->file);
+        fwrite(trace->iteration, sizeof(int64_t), c, trace->file);
+        fwrite(trace->temperature, sizeof(double), c, trace->file);
+        fwrite(trace->variance, sizeof(double), c, trace->file);
+        fwrite(trace->mean, sizeof(double), c, trace->file);
+        fwrite(trace->min, sizeof(double), c, trace->file);
+        fwrite(trace->max, sizeof(double), c, trace->file);
+        fwrite(trace->std, sizeof(double), c, trace->file);
+        fwrite(trace->acceptance, sizeof(double), c, trace->file);
+        fwrite(trace->seconds, sizeof(double), c, trace->file);
+    }
+
+    trace->count = 0;
+}
+
+/**
+ * Complete the current level of an aggregate and start a new one.
+ *
+ * @param struct trace_aggregate_t *const the aggregate
+ * @param struct trace_level_t *const the completed level
+ */
+static void closeLevel(struct trace_aggregate_t *const aggregate,
+                       struct trace_level_t *const level)
+{
+    level->level = aggregate->levels++;
+    level->iteration = aggregate->last;
+    level->temperature = aggregate->t;
+    level->variance = aggregate->v;
+    level->mean = aggregate->m;
+    level->min = aggregate->lo;
+    level->max = aggregate->hi;
+    level->std = (aggregate->n > 1) ? sqrt(aggregate->m2 / (double) (aggregate->n - 1)) : 0.0;
+    level->acceptance = (double) aggregate->a / (double) aggregate->n;
+    level->seconds = elapsed(&aggregate->start);
+
+    aggregate->n = 0;
+}
+
+/**
+ * Open a trace file.
+ *
+ * @param const char *const the name of the trace file
+ * @param const int record every sampling-th proposal, or aggregate the temperature levels, if 0
+ * @return struct trace_t* the trace or NULL, if the file could not be opened
+ */
+struct trace_t *trace_open(const char *const file, const int sampling)
+{
+    struct trace_header_t header;
+    struct trace_t *trace;
+
+    trace = (struct trace_t *) calloc(1, sizeof(struct trace_t));
+
+    if (trace == NULL) {
+        return NULL;
+    }
+
+    trace->file = fopen(file, "wb");
+
+    if (trace->file == NULL) {
+        free(trace);
+        return NULL;
+    }
+
+    trace->sampling = (sampling > 0) ? sampling : 0;
+
+    memset(&header, 0, sizeof(struct trace_header_t));
+    strncpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.kind = (trace->sampling > 0) ? TRACE_SAMPLES : TRACE_LEVELS;
+    header.sampling = (uint32_t) trace->sampling;
+    fwrite(&header, sizeof(struct trace_header_t), 1, trace->file);
+
+    return trace;
+}
+
+/**
+ * Write the outstanding records and close the trace.
+ *
+ * @param struct trace_t* the trace
+ */
+void trace_close(struct trace_t *trace)
+{
+    if (trace == NULL) {
+        return;
+    }
+
+    flush(trace);
+    fclose(trace->file);
+    free(trace);
+}
+
+/**
+ * Append a sampled proposal to a trace of samples.
+ *
+ * @param struct trace_t *const the trace
+ * @param const long the iteration
+ * @param const double the current objective
+ * @param const double the change of the objective by the proposal
+ * @param const double the temperature
+ * @param const double the variance of the random walk
+ * @param const int flag indicating whether the proposal was accepted
+ */
+void trace_sample(struct trace_t *const trace, const long iteration, const double objective,
+                  const double delta, const double temperature, const double variance,
+                  const int accepted)
+{
+    uint32_t c = trace->count;
+
+    trace->iteration[c] = iteration;
+    trace->objective[c] = objective;
+    trace->delta[c] = delta;
+    trace->temperature[c] = temperature;
+    trace->variance[c] = variance;
+    trace->accepted[c] = (uint8_t) accepted;
+
+    if (++trace->count == TRACE_BLOCK) {
+        flush(trace);
+    }
+}
+
+/**
+ * Append a completed level to a trace of levels.
+ *
+ * @param struct trace_t *const the trace
+ * @param const struct trace_level_t *const the level
+ */
+void trace_level(struct trace_t *const trace, const struct trace_level_t *const level)
+{
+    uint32_t c = trace->count;
+
+    trace->level[c] = level->level;
+    trace->iteration[c] = level->iteration;
+    trace->temperature[c] = level->temperature;
+    trace->variance[c] = level->variance;
+    trace->mean[c] = level->mean;
+    trace->min[c] = level->min;
+    trace->max[c] = level->max;
+    trace->std[c] = level->std;
+    trace->acceptance[c] = level->acceptance;
+    trace->seconds[c] = level->seconds;
+
+    if (++trace->count == TRACE_BLOCK) {
+        flush(trace);
+    }
+}
+
+/**
+ * Add a proposal to the aggregate of its temperature level. The aggregate has to be zeroed
+ * before the first proposal.
+ *
+ * @param struct trace_aggregate_t *const the aggregate
+ * @param const long the iteration
+ * @param const double the current objective
+ * @param const double the temperature
+ * @param const double the variance of the random walk
+ * @param const int flag indicating whether the proposal was accepted
+ * @param struct trace_level_t *const the level completed by the proposal
+ * @return int 1, if the proposal completed the previous level
+ */
+int trace_aggregate(struct trace_aggregate_t *const aggregate, const long iteration,
+                    const double objective, const double temperature, const double variance,
+                    const int accepted, struct trace_level_t *const level)
+{
+    int closed = 0;
+    double d;
+
+    if (aggregate->n > 0 && temperature != aggregate->t) {
+        closeLevel(aggregate, level);
+        closed = 1;
+    }
+
+    if (aggregate->n == 0) {
+        aggregate->t = temperature;
+        aggregate->m = aggregate->m2 = 0.0;
+        aggregate->lo = DBL_MAX;
+        aggregate->hi = -DBL_MAX;
+        aggregate->a = 0;
+        clock_gettime(CLOCK_MONOTONIC, &aggregate->start);
+    }
+
+    /* Welford's update of the mean and the squared deviations */
+    aggregate->n++;
+    d = objective - aggregate->m;
+    aggregate->m += d / (double) aggregate->n;
+    aggregate->m2 += d * (objective - aggregate->m);
+    aggregate->lo = (objective < aggregate->lo) ? objective : aggregate->lo;
+    aggregate->hi = (objective > aggregate->hi) ? objective : aggregate->hi;
+    aggregate->a += (accepted != 0);
+    aggregate->v = variance;
+    aggregate->last = iteration;
+
+    return closed;
+}
+
+/**
+ * Complete the last level of an aggregate.
+ *
+ * @param struct trace_aggregate_t *const the aggregate
+ * @param struct trace_level_t *const the completed level
+ * @return int 1, if there was a level to complete
+ */
+int trace_finish(struct trace_aggregate_t *const aggregate, struct trace_level_t *const level)
+{
+    if (aggregate->n == 0) {
+        return 0;
+    }
+
+    closeLevel(aggregate, level);
+
+    return 1;
+}
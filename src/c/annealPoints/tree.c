@@ -0,0 +1,787 @@
+/**
+ * This module evaluates the objectives over the whole configuration with a Barnes-Hut octree.
+ * The points are sorted along a Morton curve, so that every node of the octree covers a
+ * contiguous range of the sorted points. Every node stores the centre of mass of its points,
+ * their second moments around it, and the radius of the ball around the centre holding them.
+ *
+ * The contribution of a point is the sum over the nodes of the tree: a node whose radius is
+ * smaller than theta times its distance from the point is replaced by its quadrupole expansion,
+ * the points of a leaf are summed exactly with the pair kernels, and all other nodes are opened.
+ * For a radial pair function f and a node with m points, centre c, and second moments Q, the
+ * expansion at distance vector d = x - c, R = |d|, is
+ * \f$ m f(R) + \frac{1}{2} \left( f''(R) \hat{d}^T Q \hat{d} + f'(R) / R (\mathrm{tr} Q -
+ *     \hat{d}^T Q \hat{d}) \right) \f$,
+ * as the dipole term vanishes around the centre of mass. The error of a node is of the order
+ * of theta^3 relative to its contribution.
+ *
+ * The construction of the subtrees and the traversal both run on the thread pool. The subtrees
+ * and the tiles of the traversal are determined by the points only, so the results are
+ * bit-identical for any number of threads.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "global.h"
+#include "kernel.h"
+#include "logging.h"
+#include "points.h"
+#include "pool.h"
+#include "tree.h"
+
+
+/**
+ * Number of bits of every coordinate in the Morton keys.
+ */
+#define TREE_BITS 21
+
+/**
+ * Size of the traversal stack. Every level of the tree adds at most seven pending siblings.
+ */
+#define TREE_STACK (8 * (TREE_BITS + 1))
+
+
+/**
+ * Identifies the pair function of a traversal.
+ */
+enum pairs_t {
+    PAIRS_DISTANCE,
+    PAIRS_ENERGY
+};
+
+/**
+ * A node of the octree.
+ */
+struct node_t {
+    double x, y, z; /** the centre of mass */
+    double q[6]; /** the second moments around the centre (xx, yy, zz, xy, xz, yz) */
+    double radius; /** the radius of the ball around the centre holding all points */
+    int first; /** the first sorted point */
+    int count; /** number of points */
+    int child; /** the first child, or -1 for a leaf */
+    int children; /** number of children */
+};
+
+/**
+ * A subtree built by one task of the thread pool.
+ */
+struct subtree_t {
+    int first; /** the first sorted point */
+    int last; /** one past the last sorted point */
+    int level; /** the level of the root */
+    int root; /** the node of the root, reserved by its parent */
+    int nodes; /** number of nodes below the root */
+    int cursor; /** the first node of the subtree below the root */
+};
+
+/**
+ * The octree and the state of its construction and traversal.
+ */
+struct tree_t {
+    const struct points_t *points; /** the points */
+    struct points_t sorted; /** the points in Morton order */
+    uint64_t *keys; /** the sorted Morton keys */
+    int *order; /** the point at every sorted position */
+    struct node_t *nodes; /** the nodes, the root first */
+    int used; /** number of nodes */
+    int capacity; /** capacity of the node array */
+    int grain; /** maximum number of points of a subtree */
+    struct subtree_t *subtrees; /** the subtrees built in parallel */
+    int tasks; /** number of subtrees */
+    int *top; /** the nodes above the subtrees in post-order */
+    int tops; /** number of nodes above the subtrees */
+    double theta2; /** the squared opening angle of the traversal */
+    enum pairs_t pairs; /** the pair function of the traversal */
+    int tiles; /** number of tiles of the traversal */
+    double partial[TREE_TILES]; /** the partial result of every tile */
+};
+
+
+/**
+ * Spread the lower 21 bits of a value over every third bit.
+ */
+static uint64_t spread(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+
+    return v;
+}
+
+/**
+ * @return the Morton key of a position in [-1, 1]^3
+ */
+static uint64_t morton(const double x, const double y, const double z)
+{
+    double scale = (double) ((1 << TREE_BITS) - 1) / 2.0;
+
+    return spread((uint64_t) ((x + 1.0) * scale)) << 2
+        | spread((uint64_t) ((y + 1.0) * scale)) << 1
+        | spread((uint64_t) ((z + 1.0) * scale));
+}
+
+/**
+ * Compare two (key, point) pairs. Equal keys are ordered by the point, so the order is unique.
+ */
+static int compareKeys(const void *a, const void *b)
+{
+    const uint64_t *ka = (const uint64_t *) a;
+    const uint64_t *kb = (const uint64_t *) b;
+
+    if (ka[0] != kb[0]) {
+        return (ka[0] < kb[0]) ? -1 : 1;
+    }
+
+    return (ka[1] < kb[1]) ? -1 : (ka[1] > kb[1]);
+}
+
+/**
+ * Compute the Morton keys of one tile of the points.
+ *
+ * @param void* the tree
+ * @param int the tile
+ */
+static void keyTile(void *arg, int tile)
+{
+    struct tree_t *tree = (struct tree_t *) arg;
+    const struct points_t *points = tree->points;
+    int last = (int) ((long) points->n * (tile + 1) / tree->tiles);
+    int i = 0;
+
+    for (i = (int) ((long) points->n * tile / tree->tiles); i < last; i++) {
+        tree->keys[2 * i] = morton(points->x[i], points->y[i], points->z[i]);
+        tree->keys[2 * i + 1] = (uint64_t) i;
+    }
+}
+
+/**
+ * Split a range of sorted points into the octants of a level. Levels on which all points fall
+ * into the same octant are skipped.
+ *
+ * @param const struct tree_t *const the tree
+ * @param const int the first sorted point
+ * @param const int one past the last sorted point
+ * @param int* the level, advanced to the level of the split
+ * @param int* the boundaries of the children (up to nine)
+ * @return int the number of children, or 0 if the points cannot be split
+ */
+static int octants(const struct tree_t *const tree, const int first, const int last, int *level,
+                   int *bounds)
+{
+    int shift, children, octant, lo, hi, mid;
+
+    for (; *level < TREE_BITS; (*level)++) {
+        shift = 3 * (TREE_BITS - 1 - *level);
+        bounds[0] = first;
+        children = 0;
+
+        /* the keys share all higher bits, so the octants are sorted within the range */
+        for (octant = 0; octant < 8; octant++) {
+            lo = bounds[children];
+            hi = last;
+
+            while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+
+                if ((int) ((tree->keys[mid] >> shift) & 7) <= octant) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+
+            if (lo > bounds[children]) {
+                bounds[++children] = lo;
+            }
+        }
+
+        if (children > 1) {
+            return children;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Compute the moments of a leaf from its points.
+ */
+static void leafMoments(const struct tree_t *const tree, struct node_t *const node)
+{
+    const struct points_t *sorted = &tree->sorted;
+    double dx, dy, dz, r2, r2_max = 0.0;
+    int i = 0;
+
+    node->x = node->y = node->z = 0.0;
+
+    for (i = node->first; i < node->first + node->count; i++) {
+        node->x += sorted->x[i];
+        node->y += sorted->y[i];
+        node->z += sorted->z[i];
+    }
+
+    node->x /= node->count;
+    node->y /= node->count;
+    node->z /= node->count;
+
+    for (i = 0; i < 6; i++) {
+        node->q[i] = 0.0;
+    }
+
+    for (i = node->first; i < node->first + node->count; i++) {
+        dx = sorted->x[i] - node->x;
+        dy = sorted->y[i] - node->y;
+        dz = sorted->z[i] - node->z;
+        r2 = dx * dx + dy * dy + dz * dz;
+        r2_max = (r2 > r2_max) ? r2 : r2_max;
+
+        node->q[0] += dx * dx;
+        node->q[1] += dy * dy;
+        node->q[2] += dz * dz;
+        node->q[3] += dx * dy;
+        node->q[4] += dx * dz;
+        node->q[5] += dy * dz;
+    }
+
+    node->radius = sqrt(r2_max);
+}
+
+/**
+ * Combine the moments of the children of a node. The second moments of the children are shifted
+ * to the centre of the parent by the parallel axis theorem.
+ */
+static void nodeMoments(const struct tree_t *const tree, struct node_t *const node)
+{
+    const struct node_t *child;
+    double dx, dy, dz, m, r;
+    int c = 0;
+    int i = 0;
+
+    node->x = node->y = node->z = 0.0;
+
+    for (c = 0; c < node->children; c++) {
+        child = &tree->nodes[node->child + c];
+        node->x += child->count * child->x;
+        node->y += child->count * child->y;
+        node->z += child->count * child->z;
+    }
+
+    node->x /= node->count;
+    node->y /= node->count;
+    node->z /= node->count;
+    node->radius = 0.0;
+
+    for (i = 0; i < 6; i++) {
+        node->q[i] = 0.0;
+    }
+
+    for (c = 0; c < node->children; c++) {
+        child = &tree->nodes[node->child + c];
+        m = (double) child->count;
+        dx = child->x - node->x;
+        dy = child->y - node->y;
+        dz = child->z - node->z;
+        r = sqrt(dx * dx + dy * dy + dz * dz) + child->radius;
+        node->radius = (r > node->radius) ? r : node->radius;
+
+        node->q[0] += child->q[0] + m * dx * dx;
+        node->q[1] += child->q[1] + m * dy * dy;
+        node->q[2] += child->q[2] + m * dz * dz;
+        node->q[3] += child->q[3] + m * dx * dy;
+        node->q[4] += child->q[4] + m * dx * dz;
+        node->q[5] += child->q[5] + m * dy * dz;
+    }
+}
+
+/**
+ * Count the nodes of a subtree below its root.
+ */
+static int countNodes(const struct tree_t *const tree, const int first, const int last, int level)
+{
+    int bounds[9];
+    int children, c;
+    int nodes = 0;
+
+    if (last - first <= TREE_LEAF) {
+        return 0;
+    }
+
+    children = octants(tree, first, last, &level, bounds);
+    nodes = children;
+
+    for (c = 0; c < children; c++) {
+        nodes += countNodes(tree, bounds[c], bounds[c + 1], level + 1);
+    }
+
+    return nodes;
+}
+
+/**
+ * Build a subtree into a node reserved by its parent. The children of every node are stored
+ * next to each other from the cursor on.
+ */
+static void buildNode(struct tree_t *const tree, const int first, const int last, int level,
+                      const int index, int *cursor)
+{
+    struct node_t *node = &tree->nodes[index];
+    int bounds[9];
+    int c = 0;
+
+    node->first = first;
+    node->count = last - first;
+    node->child = -1;
+    node->children = 0;
+
+    if (last - first > TREE_LEAF) {
+        node->children = octants(tree, first, last, &level, bounds);
+    }
+
+    if (node->children == 0) {
+        leafMoments(tree, node);
+        return;
+    }
+
+    node->child = *cursor;
+    *cursor += node->children;
+
+    for (c = 0; c < node->children; c++) {
+        buildNode(tree, bounds[c], bounds[c + 1], level + 1, node->child + c, cursor);
+    }
+
+    nodeMoments(tree, node);
+}
+
+/**
+ * Count the nodes of one subtree.
+ *
+ * @param void* the tree
+ * @param int the subtree
+ */
+static void countTask(void *arg, int task)
+{
+    struct tree_t *tree = (struct tree_t *) arg;
+    struct subtree_t *subtree = &tree->subtrees[task];
+
+    subtree->nodes = countNodes(tree, subtree->first, subtree->last, subtree->level);
+}
+
+/**
+ * Build one subtree.
+ *
+ * @param void* the tree
+ * @param int the subtree
+ */
+static void buildTask(void *arg, int task)
+{
+    struct tree_t *tree = (struct tree_t *) arg;
+    struct subtree_t *subtree = &tree->subtrees[task];
+    int cursor = subtree->cursor;
+
+    buildNode(tree, subtree->first, subtree->last, subtree->level, subtree->root, &cursor);
+}
+
+/**
+ * Reserve nodes at the end of the node array.
+ *
+ * @return int the first reserved node, or -1 if the memory could not be allocated
+ */
+static int reserve(struct tree_t *const tree, const int nodes)
+{
+    struct node_t *grown;
+    int capacity = tree->capacity;
+
+    while (tree->used + nodes > capacity) {
+        capacity = 2 * capacity + 8;
+    }
+
+    if (capacity > tree->capacity) {
+        grown = (struct node_t *) realloc(tree->nodes, capacity * sizeof(struct node_t));
+
+        if (grown == NULL) {
+            return -1;
+        }
+
+        tree->nodes = grown;
+        tree->capacity = capacity;
+    }
+
+    tree->used += nodes;
+
+    return tree->used - nodes;
+}
+
+/**
+ * Lay out the nodes above the subtrees. Ranges of at most grain points become subtrees built in
+ * parallel later, the nodes above them are recorded in post-order.
+ *
+ * @return int SUCCESS or FAIL, if the memory could not be allocated
+ */
+static int plan(struct tree_t *const tree, const int first, const int last, int level,
+                const int index)
+{
+    struct subtree_t *subtree;
+    int bounds[9];
+    int *top;
+    int children, child, c;
+
+    tree->nodes[index].first = first;
+    tree->nodes[index].count = last - first;
+    children = (last - first > tree->grain) ? octants(tree, first, last, &level, bounds) : 0;
+
+    if (children == 0) {
+        subtree = (struct subtree_t *) realloc(tree->subtrees,
+                                               (tree->tasks + 1) * sizeof(struct subtree_t));
+
+        if (subtree == NULL) {
+            return FAIL;
+        }
+
+        tree->subtrees = subtree;
+        subtree = &tree->subtrees[tree->tasks++];
+        subtree->first = first;
+        subtree->last = last;
+        subtree->level = level;
+        subtree->root = index;
+
+        return SUCCESS;
+    }
+
+    child = reserve(tree, children);
+
+    if (child < 0) {
+        return FAIL;
+    }
+
+    tree->nodes[index].child = child;
+    tree->nodes[index].children = children;
+
+    for (c = 0; c < children; c++) {
+        if (plan(tree, bounds[c], bounds[c + 1], level + 1, child + c) == FAIL) {
+            return FAIL;
+        }
+    }
+
+    top = (int *) realloc(tree->top, (tree->tops + 1) * sizeof(int));
+
+    if (top == NULL) {
+        return FAIL;
+    }
+
+    tree->top = top;
+    tree->top[tree->tops++] = index;
+
+    return SUCCESS;
+}
+
+/**
+ * Free the octree.
+ */
+static void destroy(struct tree_t *const tree)
+{
+    points_free(&tree->sorted);
+    free(tree->keys);
+    free(tree->order);
+    free(tree->nodes);
+    free(tree->subtrees);
+    free(tree->top);
+}
+
+/**
+ * Build the octree over the given points.
+ *
+ * @param struct pool_t *const the thread pool
+ * @param const struct points_t *const the points
+ * @param struct tree_t *const the tree to be built
+ * @return int SUCCESS or FAIL, if the memory could not be allocated
+ */
+static int create(struct pool_t *const pool, const struct points_t *const points,
+                  struct tree_t *const tree)
+{
+    int n = points->n;
+    int cursor = 0;
+    int i = 0;
+    int t = 0;
+
+    tree->points = points;
+    tree->keys = (uint64_t *) malloc(2 * (size_t) n * sizeof(uint64_t));
+    tree->order = (int *) malloc(n * sizeof(int));
+    tree->nodes = NULL;
+    tree->used = tree->capacity = 0;
+    tree->subtrees = NULL;
+    tree->tasks = 0;
+    tree->top = NULL;
+    tree->tops = 0;
+    tree->tiles = (n < TREE_TILES) ? n : TREE_TILES;
+
+    if (points_alloc(&tree->sorted, n) == FAIL || tree->keys == NULL || tree->order == NULL) {
+        destroy(tree);
+        return FAIL;
+    }
+
+    /* sort the points along the Morton curve */
+    pool_run(pool, tree->tiles, keyTile, tree);
+    qsort(tree->keys, n, 2 * sizeof(uint64_t), compareKeys);
+
+    for (i = 0; i < n; i++) {
+        tree->order[i] = (int) tree->keys[2 * i + 1];
+        tree->keys[i] = tree->keys[2 * i];
+        tree->sorted.x[i] = points->x[tree->order[i]];
+        tree->sorted.y[i] = points->y[tree->order[i]];
+        tree->sorted.z[i] = points->z[tree->order[i]];
+    }
+
+    /* lay out the top of the tree, count the nodes of the subtrees, and build them in parallel */
+    tree->grain = n / TREE_TASKS;
+    tree->grain = (tree->grain < TREE_LEAF) ? TREE_LEAF : tree->grain;
+
+    if (reserve(tree, 1) < 0 || plan(tree, 0, n, 0, 0) == FAIL) {
+        destroy(tree);
+        return FAIL;
+    }
+
+    pool_run(pool, tree->tasks, countTask, tree);
+
+    cursor = tree->used;
+
+    for (t = 0; t < tree->tasks; t++) {
+        tree->subtrees[t].cursor = cursor;
+        cursor += tree->subtrees[t].nodes;
+    }
+
+    if (reserve(tree, cursor - tree->used) < 0) {
+        destroy(tree);
+        return FAIL;
+    }
+
+    pool_run(pool, tree->tasks, buildTask, tree);
+
+    for (t = 0; t < tree->tops; t++) {
+        nodeMoments(tree, &tree->nodes[tree->top[t]]);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Sum the pair function between a point and the points of a leaf exactly, leaving out the point
+ * itself.
+ */
+static double leafSum(const struct tree_t *const tree, const struct node_t *const node,
+                      const int position, const struct vector_t *const point)
+{
+    double (*row)(const struct points_t *const, const int, const int,
+                  const struct vector_t *const);
+    int end = node->first + node->count;
+
+    row = (tree->pairs == PAIRS_DISTANCE) ? kernel_distanceRow : kernel_energyRow;
+
+    if (position < node->first || position >= end) {
+        return row(&tree->sorted, node->first, end, point);
+    }
+
+    return row(&tree->sorted, node->first, position, point)
+        + row(&tree->sorted, position + 1, end, point);
+}
+
+/**
+ * The contribution of the point at a sorted position, i.e., the sum of the pair function with
+ * all other points.
+ *
+ * @param const struct tree_t *const the tree
+ * @param const int the sorted position of the point
+ * @return the contribution of the point
+ */
+static double contribution(const struct tree_t *const tree, const int position)
+{
+    const struct node_t *node;
+    struct vector_t point = points_get(&tree->sorted, position);
+    int stack[TREE_STACK];
+    int top = 0;
+    int c = 0;
+    double dx, dy, dz, r2, dqd, trace;
+    double result = 0.0;
+
+    stack[top++] = 0;
+
+    while (top > 0) {
+        node = &tree->nodes[stack[--top]];
+        dx = point.x - node->x;
+        dy = point.y - node->y;
+        dz = point.z - node->z;
+        r2 = dx * dx + dy * dy + dz * dz;
+
+        if (node->radius * node->radius < tree->theta2 * r2) {
+            /* the node is far enough away for its quadrupole expansion */
+            dqd = node->q[0] * dx * dx + node->q[1] * dy * dy + node->q[2] * dz * dz
+                + 2.0 * (node->q[3] * dx * dy + node->q[4] * dx * dz + node->q[5] * dy * dz);
+            trace = node->q[0] + node->q[1] + node->q[2];
+
+            if (tree->pairs == PAIRS_DISTANCE) {
+                result += node->count * sqrt(r2) + 0.5 * (trace - dqd / r2) / sqrt(r2);
+            } else {
+                result += -node->count * log(r2) + (2.0 * dqd / r2 - trace) / r2;
+            }
+        } else if (node->children == 0) {
+            result += leafSum(tree, node, position, &point);
+        } else {
+            for (c = node->children - 1; c >= 0; c--) {
+                stack[top++] = node->child + c;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Sum the contributions of one tile of the sorted points.
+ *
+ * @param void* the tree
+ * @param int the tile
+ */
+static void traverseTile(void *arg, int tile)
+{
+    struct tree_t *tree = (struct tree_t *) arg;
+    int n = tree->sorted.n;
+    int last = (int) ((long) n * (tile + 1) / tree->tiles);
+    double result = 0.0;
+    int i = 0;
+
+    for (i = (int) ((long) n * tile / tree->tiles); i < last; i++) {
+        result += contribution(tree, i);
+    }
+
+    tree->partial[tile] = result;
+}
+
+/**
+ * Evaluate the objective over the whole configuration. Every pair is visited from both of its
+ * points, so the sum of the contributions is halved.
+ *
+ * @return the objective, or NAN if the memory could not be allocated
+ */
+static double evaluate(struct pool_t *const pool, const struct points_t *const points,
+                       const enum pairs_t pairs, const double theta)
+{
+    struct tree_t tree;
+    double result = 0.0;
+    int t = 0;
+
+    if (points->n < 2) {
+        return 0.0;
+    }
+
+    /* make sure the kernels are selected before any of the workers may race to do so */
+    (void) kernel_name();
+
+    if (create(pool, points, &tree) == FAIL) {
+        return NAN;
+    }
+
+    tree.theta2 = theta * theta;
+    tree.pairs = pairs;
+    pool_run(pool, tree.tiles, traverseTile, &tree);
+
+    for (t = 0; t < tree.tiles; t++) {
+        result += tree.partial[t];
+    }
+
+    destroy(&tree);
+
+    return 0.5 * result;
+}
+
+/**
+ * The sum of the euclidean distances between any two points, approximated with the octree.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @param const double the opening angle (smaller than 1)
+ * @return the sum of the distances
+ */
+double tree_distance(struct pool_t *const pool, const struct points_t *const points,
+                     const double theta)
+{
+    return evaluate(pool, points, PAIRS_DISTANCE, theta);
+}
+
+/**
+ * The logarithmic Riesz energy of the configuration, approximated with the octree.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @param const double the opening angle (smaller than 1)
+ * @return the energy of the configuration
+ */
+double tree_energy(struct pool_t *const pool, const struct points_t *const points,
+                   const double theta)
+{
+    return evaluate(pool, points, PAIRS_ENERGY, theta);
+}
+
+/**
+ * Find the largest opening angle that meets an accuracy target. The contributions of
+ * TREE_SAMPLES points spread over the configuration are compared against the exact ones, and
+ * the opening angle is reduced until their relative error is within the target.
+ *
+ * @param struct pool_t *const the thread pool (may be NULL)
+ * @param const struct points_t *const the point store
+ * @param const enum objective_t the objective
+ * @param const double the opening angle to start from (TREE_THETA, if not positive)
+ * @param const double the target of the relative error
+ * @return the opening angle
+ */
+double tree_tune(struct pool_t *const pool, const struct points_t *const points,
+                 const enum objective_t objective, const double theta, const double target)
+{
+    struct tree_t tree;
+    struct vector_t point;
+    int position[TREE_SAMPLES];
+    double exact[TREE_SAMPLES];
+    double angle = (theta > 0.0) ? theta : TREE_THETA;
+    double error, scale;
+    int samples = (points->n < TREE_SAMPLES) ? points->n : TREE_SAMPLES;
+    int i = 0;
+    int k = 0;
+
+    if (points->n < 2 || create(pool, points, &tree) == FAIL) {
+        return angle;
+    }
+
+    tree.pairs = (objective == OBJECTIVE_ENERGY) ? PAIRS_ENERGY : PAIRS_DISTANCE;
+
+    for (k = 0; k < samples; k++) {
+        position[k] = (int) ((long) points->n * k / samples);
+        i = tree.order[position[k]];
+        point = points_get(points, i);
+        exact[k] = (tree.pairs == PAIRS_ENERGY)
+            ? kernel_energyTo(points, i, &point) : kernel_distanceTo(points, i, &point);
+    }
+
+    for (;;) {
+        tree.theta2 = angle * angle;
+        error = 0.0;
+        scale = 0.0;
+
+        for (k = 0; k < samples; k++) {
+            error += fabs(contribution(&tree, position[k]) - exact[k]);
+            scale += fabs(exact[k]);
+        }
+
+        if (error <= target * scale || angle <= TREE_THETA_MIN) {
+            break;
+        }
+
+        angle = (0.8 * angle > TREE_THETA_MIN) ? 0.8 * angle : TREE_THETA_MIN;
+    }
+
+    destroy(&tree);
+
+    return angle;
+}
@@ -5,6 +5,7 @@
  */
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 
 #include "vector.h"
 
@@ -47,11 +48,7 @@ void vector_copy(struct vector_t *const oldVector, const struct vector_t *const
  */
 void vector_arrayCopy(struct vector_t *const oldVector, const struct vector_t *const newVector, const int arraySize)
 {
-    int i = 0;
-
-    for (i = 0; i < arraySize; i++) {
-        vector_copy((oldVector + i), (newVector + i));
-    }
+    memcpy(oldVector, newVector, arraySize * sizeof(struct vector_t));
 }
 
 /**
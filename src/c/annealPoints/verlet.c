@@ -0,0 +1,389 @@
+/**
+ * This module approximates the logarithmic Riesz energy with cutoff neighbour lists. Every point
+ * keeps a list of the points that were within the reach r_c + skin of it when the list was
+ * built. As long as no point moved more than half the skin away from its build position, all
+ * pairs closer than r_c are found in these lists, so a move is scored with a few dozen pair
+ * terms independent of N. A point's list is rebuilt from the grid of build positions once the
+ * point moved further.
+ *
+ * The pairs beyond the cutoff are replaced by their mean-field value. For points spread
+ * uniformly over the unit sphere, the chord length d of a pair has the density d/2 on [0, 2], so
+ * the expected energy of a pair beyond r_c is
+ * \f$ \int_{r_c}^2 -\log{d^2} \, d/2 \, \mathrm{d}d
+ *     = 1 - 2 \log{2} + r_c^2 / 2 \log{r_c} - r_c^2 / 4 \f$.
+ * This term does not depend on the configuration and cancels in the energy differences.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdlib.h>
+
+#include "grid.h"
+#include "logging.h"
+#include "points.h"
+#include "verlet.h"
+
+
+/**
+ * The state of the neighbour lists.
+ */
+struct verlet_t {
+    const struct points_t *points; /** the points */
+    struct grid_t grid; /** the grid of the build positions with cells of the reach */
+    double cutoff; /** the cutoff radius */
+    double cutoff2; /** the squared cutoff radius */
+    double reach2; /** the squared reach of the lists, (cutoff + skin)^2 */
+    double halfSkin2; /** the squared half skin */
+    double *bx; /** the x-coordinates of the build positions */
+    double *by; /** the y-coordinates of the build positions */
+    double *bz; /** the z-coordinates of the build positions */
+    int capacity; /** the capacity of every neighbour list */
+    int *count; /** the length of every neighbour list */
+    int *list; /** the neighbour lists (capacity entries per point) */
+    long rebuilds; /** number of list rebuilds */
+};
+
+
+/**
+ * Append a pair to the lists of both points.
+ *
+ * @return int SUCCESS or FAIL, if a list is full
+ */
+static int pair(struct verlet_t *const verlet, const int i, const int j)
+{
+    if (verlet->count[i] == verlet->capacity || verlet->count[j] == verlet->capacity) {
+        return FAIL;
+    }
+
+    verlet->list[i * verlet->capacity + verlet->count[i]++] = j;
+    verlet->list[j * verlet->capacity + verlet->count[j]++] = i;
+
+    return SUCCESS;
+}
+
+/**
+ * @return the squared distance between the build positions of two points
+ */
+static double buildDistance2(const struct verlet_t *const verlet, const int i, const int j)
+{
+    double dx = verlet->bx[i] - verlet->bx[j];
+    double dy = verlet->by[i] - verlet->by[j];
+    double dz = verlet->bz[i] - verlet->bz[j];
+
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * Link a point with all points whose build positions are within the reach of its own.
+ *
+ * @param const int 1 to link only with points of higher index, 0 to link with all points
+ * @return int SUCCESS or FAIL, if a list is full
+ */
+static int scan(struct verlet_t *const verlet, const int index, const int higher)
+{
+    int list[GRID_NEIGHBOURS];
+    int count, k, j;
+
+    count = grid_neighbours(&verlet->grid, &verlet->grid.cell[3 * index], list);
+
+    for (k = 0; k < count; k++) {
+        for (j = verlet->grid.head[list[k]]; j >= 0; j = verlet->grid.next[j]) {
+            if ((higher ? j > index : j != index)
+                && buildDistance2(verlet, index, j) < verlet->reach2
+                && pair(verlet, index, j) == FAIL) {
+                return FAIL;
+            }
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Rebuild all lists from the current positions. The capacity of the lists is doubled until all
+ * neighbours fit.
+ *
+ * @return int SUCCESS or FAIL, if the memory could not be allocated
+ */
+static int build(struct verlet_t *const verlet)
+{
+    const struct points_t *points = verlet->points;
+    int *list;
+    int i = 0;
+
+    for (;;) {
+        for (i = 0; i < verlet->grid.buckets; i++) {
+            verlet->grid.head[i] = -1;
+        }
+
+        for (i = 0; i < points->n; i++) {
+            verlet->bx[i] = points->x[i];
+            verlet->by[i] = points->y[i];
+            verlet->bz[i] = points->z[i];
+            verlet->count[i] = 0;
+            grid_insert(&verlet->grid, i, points->x[i], points->y[i], points->z[i]);
+        }
+
+        for (i = 0; i < points->n && scan(verlet, i, 1) == SUCCESS; i++) {
+        }
+
+        if (i == points->n) {
+            verlet->rebuilds++;
+            return SUCCESS;
+        }
+
+        /* a list overflowed, so start over with longer lists */
+        list = (int *) realloc(verlet->list, 2 * (size_t) verlet->capacity * points->n * sizeof(int));
+
+        if (list == NULL) {
+            return FAIL;
+        }
+
+        verlet->list = list;
+        verlet->capacity *= 2;
+    }
+}
+
+/**
+ * Rebuild the list of a single point around its current position.
+ */
+static void relist(struct verlet_t *const verlet, const int index)
+{
+    const struct points_t *points = verlet->points;
+    int *neighbours;
+    int j, k, l;
+
+    /* unlink the point from its old neighbours */
+    for (k = 0; k < verlet->count[index]; k++) {
+        j = verlet->list[index * verlet->capacity + k];
+        neighbours = &verlet->list[j * verlet->capacity];
+
+        for (l = 0; l < verlet->count[j] && neighbours[l] != index; l++) {
+        }
+
+        neighbours[l] = neighbours[--verlet->count[j]];
+    }
+
+    verlet->count[index] = 0;
+    verlet->bx[index] = points->x[index];
+    verlet->by[index] = points->y[index];
+    verlet->bz[index] = points->z[index];
+    grid_remove(&verlet->grid, index);
+    grid_insert(&verlet->grid, index, points->x[index], points->y[index], points->z[index]);
+
+    if (scan(verlet, index, 0) == FAIL) {
+        build(verlet);
+    } else {
+        verlet->rebuilds++;
+    }
+}
+
+/**
+ * Create the neighbour lists over the given points. The lists keep a reference to the point
+ * store, and verlet_move has to be called whenever a point of the store is changed.
+ *
+ * @param const struct points_t *const the point store
+ * @param const double the cutoff radius (chord length)
+ * @return struct verlet_t* the neighbour lists or NULL, if the memory could not be allocated
+ */
+struct verlet_t *verlet_create(const struct points_t *const points, const double cutoff)
+{
+    struct verlet_t *verlet;
+    double skin = VERLET_SKIN * cutoff;
+    double reach = cutoff + skin;
+    int n = points->n;
+
+    verlet = (struct verlet_t *) calloc(1, sizeof(struct verlet_t));
+
+    if (verlet == NULL) {
+        return NULL;
+    }
+
+    verlet->points = points;
+    verlet->cutoff = cutoff;
+    verlet->cutoff2 = cutoff * cutoff;
+    verlet->reach2 = reach * reach;
+    verlet->halfSkin2 = 0.25 * skin * skin;
+
+    /* a cap of chord radius r covers r^2 / 4 of the sphere */
+    verlet->capacity = 2 * (int) (n * reach * reach / 4.0) + 16;
+
+    verlet->bx = (double *) malloc(n * sizeof(double));
+    verlet->by = (double *) malloc(n * sizeof(double));
+    verlet->bz = (double *) malloc(n * sizeof(double));
+    verlet->count = (int *) malloc(n * sizeof(int));
+    verlet->list = (int *) malloc((size_t) verlet->capacity * n * sizeof(int));
+
+    if (grid_alloc(&verlet->grid, n, (reach > 2.0) ? 2.0 : reach) == FAIL
+        || verlet->bx == NULL || verlet->by == NULL || verlet->bz == NULL
+        || verlet->count == NULL || verlet->list == NULL || build(verlet) == FAIL) {
+        verlet_destroy(verlet);
+        return NULL;
+    }
+
+    return verlet;
+}
+
+/**
+ * Free the neighbour lists.
+ *
+ * @param struct verlet_t* the neighbour lists
+ */
+void verlet_destroy(struct verlet_t *verlet)
+{
+    if (verlet == NULL) {
+        return;
+    }
+
+    grid_free(&verlet->grid);
+    free(verlet->bx);
+    free(verlet->by);
+    free(verlet->bz);
+    free(verlet->count);
+    free(verlet->list);
+    free(verlet);
+}
+
+/**
+ * Update the lists after the point at the given index has been moved in the point store. The
+ * list of the point is rebuilt, if it moved more than half the skin since the last build.
+ *
+ * @param struct verlet_t *const the neighbour lists
+ * @param const int the index of the moved point
+ */
+void verlet_move(struct verlet_t *const verlet, const int index)
+{
+    const struct points_t *points = verlet->points;
+    double dx = points->x[index] - verlet->bx[index];
+    double dy = points->y[index] - verlet->by[index];
+    double dz = points->z[index] - verlet->bz[index];
+
+    if (dx * dx + dy * dy + dz * dz > verlet->halfSkin2) {
+        relist(verlet, index);
+    }
+}
+
+/**
+ * The approximate energy of the configuration: the exact energy of all pairs closer than the
+ * cutoff plus the mean-field energy of the remaining pairs.
+ *
+ * @param const struct verlet_t *const the neighbour lists
+ * @return the approximate energy
+ */
+double verlet_energy(const struct verlet_t *const verlet)
+{
+    const struct points_t *points = verlet->points;
+    double energy = 0.0;
+    double dx, dy, dz, d2;
+    int i, j, k;
+
+    for (i = 0; i < points->n; i++) {
+        for (k = 0; k < verlet->count[i]; k++) {
+            j = verlet->list[i * verlet->capacity + k];
+
+            if (j > i) {
+                dx = points->x[i] - points->x[j];
+                dy = points->y[i] - points->y[j];
+                dz = points->z[i] - points->z[j];
+                d2 = dx * dx + dy * dy + dz * dz;
+
+                if (d2 < verlet->cutoff2) {
+                    energy -= log(d2);
+                }
+            }
+        }
+    }
+
+    return energy + verlet_farField(points->n, verlet->cutoff);
+}
+
+/**
+ * The short-range energy contribution of a single point at the given position, i.e., the sum of
+ * the pair energies with all other points closer than the cutoff. Positions within half the skin
+ * of the point's build position are scored through its list, others through the grid.
+ *
+ * @param const struct verlet_t *const the neighbour lists
+ * @param const int the index of the point
+ * @param const struct vector_t *const the position of the point
+ * @return the short-range energy of the point
+ */
+double verlet_energyTo(const struct verlet_t *const verlet, const int index,
+                       const struct vector_t *const point)
+{
+    const struct points_t *points = verlet->points;
+    int list[GRID_NEIGHBOURS];
+    int cell[3];
+    double energy = 0.0;
+    double dx, dy, dz, d2;
+    int count, j, k;
+
+    dx = point->x - verlet->bx[index];
+    dy = point->y - verlet->by[index];
+    dz = point->z - verlet->bz[index];
+
+    if (dx * dx + dy * dy + dz * dz <= verlet->halfSkin2) {
+        for (k = 0; k < verlet->count[index]; k++) {
+            j = verlet->list[index * verlet->capacity + k];
+            dx = point->x - points->x[j];
+            dy = point->y - points->y[j];
+            dz = point->z - points->z[j];
+            d2 = dx * dx + dy * dy + dz * dz;
+
+            if (d2 < verlet->cutoff2) {
+                energy -= log(d2);
+            }
+        }
+
+        return energy;
+    }
+
+    /* the position is too far from the list's origin, so search the cells around it */
+    grid_cell(&verlet->grid, point->x, point->y, point->z, cell);
+    count = grid_neighbours(&verlet->grid, cell, list);
+
+    for (k = 0; k < count; k++) {
+        for (j = verlet->grid.head[list[k]]; j >= 0; j = verlet->grid.next[j]) {
+            if (j != index) {
+                dx = point->x - points->x[j];
+                dy = point->y - points->y[j];
+                dz = point->z - points->z[j];
+                d2 = dx * dx + dy * dy + dz * dz;
+
+                if (d2 < verlet->cutoff2) {
+                    energy -= log(d2);
+                }
+            }
+        }
+    }
+
+    return energy;
+}
+
+/**
+ * The mean-field energy of all pairs beyond the cutoff for points spread uniformly over the
+ * sphere.
+ *
+ * @param const int the number of points
+ * @param const double the cutoff radius (chord length)
+ * @return the energy of the pairs beyond the cutoff (0 outside of (0, 2))
+ */
+double verlet_farField(const int n, const double cutoff)
+{
+    double pairs = 0.5 * (double) n * (double) (n - 1);
+    double r2 = cutoff * cutoff;
+
+    if (cutoff <= 0.0 || cutoff >= 2.0) {
+        return 0.0;
+    }
+
+    return pairs * (1.0 - 2.0 * M_LN2 + 0.5 * r2 * log(cutoff) - 0.25 * r2);
+}
+
+/**
+ * @param const struct verlet_t *const the neighbour lists
+ * @return the number of list rebuilds
+ */
+long verlet_rebuilds(const struct verlet_t *const verlet)
+{
+    return verlet->rebuilds;
+}
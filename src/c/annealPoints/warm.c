@@ -0,0 +1,305 @@
+/**
+ * This module starts a run from a given configuration instead of a random one. The
+ * configuration is either the best configuration of a previous run (best.log), or the best
+ * configuration of a checkpoint, which is mapped into memory without parsing. A configuration of
+ * another number of points is fitted to the run: surplus points are dropped one of the closest
+ * pair at a time, and missing points are added one at a time into the largest hole found among
+ * random candidates.
+ *
+ * @author Dominik Dahlem
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "logging.h"
+#include "rng.h"
+#include "sphere.h"
+#include "vector.h"
+#include "warm.h"
+
+
+/**
+ * The nearest neighbour of a point. The nearest point has the largest dot product on the unit
+ * sphere.
+ *
+ * @param const struct vector_t *const the points
+ * @param const int number of points
+ * @param const int the point
+ * @param int *const the nearest neighbour (-1, if there is none)
+ * @return double the dot product with the nearest neighbour
+ */
+static double nearest(const struct vector_t *const points, const int n, const int i,
+                      int *const neighbour)
+{
+    double closest = -2.0;
+    double dot = 0.0;
+    int j = 0;
+
+    *neighbour = -1;
+
+    for (j = 0; j < n; j++) {
+        if (j != i) {
+            dot = vector_dotProduct(&points[i], &points[j]);
+
+            if (dot > closest) {
+                closest = dot;
+                *neighbour = j;
+            }
+        }
+    }
+
+    return closest;
+}
+
+/**
+ * Drop points of a configuration until n are left. Every step drops a point of the closest pair,
+ * whose place is taken by the last point. Only the points whose nearest neighbour was dropped
+ * look for a new one.
+ *
+ * @param struct vector_t *const the n points left
+ * @param const int number of points left
+ * @param const struct vector_t *const the configuration
+ * @param const int number of points of the configuration
+ * @return int SUCCESS, or FAIL if the memory could not be allocated
+ */
+static int dropPoints(struct vector_t *const points, const int n,
+                      const struct vector_t *const from, const int count)
+{
+    struct vector_t *kept = (struct vector_t *) malloc(count * sizeof(struct vector_t));
+    int *neighbours = (int *) malloc(count * sizeof(int));
+    double *closest = (double *) malloc(count * sizeof(double));
+    int status = FAIL;
+    int i, j, m, last;
+
+    if (kept != NULL && neighbours != NULL && closest != NULL) {
+        vector_arrayCopy(&kept[0], &from[0], count);
+
+        for (i = 0; i < count; i++) {
+            closest[i] = nearest(kept, count, i, &neighbours[i]);
+        }
+
+        for (m = count; m > n; m--) {
+            for (i = 0, j = 1; j < m; j++) {
+                i = (closest[j] > closest[i]) ? j : i;
+            }
+
+            /* the points next to the dropped one look for a new neighbour below */
+            for (j = 0; j < m; j++) {
+                neighbours[j] = (neighbours[j] == i) ? -1 : neighbours[j];
+            }
+
+            last = m - 1;
+            kept[i] = kept[last];
+            neighbours[i] = neighbours[last];
+            closest[i] = closest[last];
+
+            for (j = 0; j < last; j++) {
+                if (neighbours[j] == last) {
+                    neighbours[j] = i;
+                } else if (neighbours[j] == -1) {
+                    closest[j] = nearest(kept, last, j, &neighbours[j]);
+                }
+            }
+        }
+
+        vector_arrayCopy(&points[0], &kept[0], n);
+        status = SUCCESS;
+    }
+
+    free(kept);
+    free(neighbours);
+    free(closest);
+
+    return status;
+}
+
+/**
+ * Add points to a configuration until it has n. Every point is the one of WARM_CANDIDATES random
+ * points that is farthest from its nearest neighbour.
+ *
+ * @param struct vector_t *const room for n points, holding the configuration
+ * @param const int number of points of the configuration
+ * @param const int number of points
+ * @param struct rng_t *const the random number generator
+ */
+static void addPoints(struct vector_t *const points, const int count, const int n,
+                      struct rng_t *const rng)
+{
+    struct vector_t candidate;
+    double closest, dot, farthest;
+    int c, j, m;
+
+    for (m = count; m < n; m++) {
+        farthest = 2.0;
+
+        for (c = 0; c < WARM_CANDIDATES; c++) {
+            candidate = sphere_getPoint(rng);
+            closest = -2.0;
+
+            for (j = 0; j < m; j++) {
+                dot = vector_dotProduct(&candidate, &points[j]);
+                closest = (dot > closest) ? dot : closest;
+            }
+
+            if (closest < farthest) {
+                farthest = closest;
+                points[m] = candidate;
+            }
+        }
+    }
+}
+
+/**
+ * Read a configuration in the format of best.log: a header x,y,z followed by one point per line.
+ * The points are projected onto the unit sphere, since they are written with a few digits only.
+ *
+ * @param FILE *const the file positioned at its beginning
+ * @param const char *const the name of the file
+ * @param struct warm_t *const the configuration
+ * @return int SUCCESS or FAIL, if the file is not a configuration
+ */
+static int readPoints(FILE *const file, const char *const name, struct warm_t *const warm)
+{
+    struct vector_t point;
+    struct vector_t *grown;
+    char *line = NULL;
+    size_t size = 0;
+    int capacity = 0;
+    int number = 1;
+    int status = SUCCESS;
+
+    if (getline(&line, &size, file) == -1 || strncmp(line, "x,y,z", 5) != 0) {
+        fprintf(stderr, "%s is neither a configuration nor a checkpoint\n", name);
+        free(line);
+        return FAIL;
+    }
+
+    while (status == SUCCESS && getline(&line, &size, file) != -1) {
+        number++;
+
+        if (sscanf(line, "%lf,%lf,%lf", &point.x, &point.y, &point.z) != 3
+            || vector_dotProduct(&point, &point) == 0.0) {
+            fprintf(stderr, "Line %d of %s is not a point\n", number, name);
+            status = FAIL;
+            break;
+        }
+
+        if (warm->n == capacity) {
+            capacity = 2 * capacity + 64;
+            grown = (struct vector_t *) realloc(warm->points,
+                                                capacity * sizeof(struct vector_t));
+
+            if (grown == NULL) {
+                fprintf(stderr, "Could not allocate %d points\n", capacity);
+                status = FAIL;
+                break;
+            }
+
+            warm->points = grown;
+        }
+
+        vector_normalise(&point);
+        warm->points[warm->n++] = point;
+    }
+
+    free(line);
+
+    return status;
+}
+
+/**
+ * Load a configuration to start from. A checkpoint is recognised by its magic bytes, and its
+ * best configuration is mapped into memory. Any other file is read as a best.log.
+ *
+ * @param const char *const the file
+ * @param struct warm_t *const the configuration, to be released with warm_release
+ * @return int SUCCESS or FAIL, if the file could not be read or holds no points
+ */
+int warm_load(const char *const file, struct warm_t *const warm)
+{
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    FILE *stream = fopen(file, "r");
+    int status = FAIL;
+
+    memset(warm, 0, sizeof(struct warm_t));
+
+    if (stream == NULL) {
+        fprintf(stderr, "Could not open the configuration %s\n", file);
+        return FAIL;
+    }
+
+    if (fread(magic, 1, sizeof(magic), stream) == sizeof(magic)
+        && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0) {
+        fclose(stream);
+        status = checkpoint_map(file, &warm->checkpoint);
+
+        if (status == SUCCESS) {
+            warm->points = warm->checkpoint.best_points;
+            warm->n = warm->checkpoint.args.n;
+        }
+    } else {
+        rewind(stream);
+        status = readPoints(stream, file, warm);
+        fclose(stream);
+    }
+
+    if (status == SUCCESS && warm->n == 0) {
+        fprintf(stderr, "The configuration %s holds no points\n", file);
+        status = FAIL;
+    }
+
+    if (status != SUCCESS) {
+        warm_release(warm);
+    }
+
+    return status;
+}
+
+/**
+ * Release a configuration.
+ *
+ * @param struct warm_t *const the configuration
+ */
+void warm_release(struct warm_t *const warm)
+{
+    if (warm->checkpoint.map != NULL) {
+        checkpoint_release(&warm->checkpoint);
+    } else {
+        free(warm->points);
+    }
+
+    warm->points = NULL;
+    warm->n = 0;
+}
+
+/**
+ * Set up the initial configuration of a run from the given configuration, dropping or adding
+ * points as needed.
+ *
+ * @param struct vector_t *const the n points of the run
+ * @param const int number of points of the run
+ * @param const struct warm_t *const the configuration to start from
+ * @param struct rng_t *const the random number generator, which places the added points
+ * @return int SUCCESS, or FAIL if the memory could not be allocated
+ */
+int warm_fit(struct vector_t *const points, const int n, const struct warm_t *const warm,
+             struct rng_t *const rng)
+{
+    if (warm->n > n) {
+        fprintf(stderr, "Dropping %d of the %d points of the initial configuration\n",
+                warm->n - n, warm->n);
+        return dropPoints(&points[0], n, &warm->points[0], warm->n);
+    }
+
+    vector_arrayCopy(&points[0], &warm->points[0], warm->n);
+
+    if (warm->n < n) {
+        fprintf(stderr, "Adding %d points to the %d points of the initial configuration\n",
+                n - warm->n, warm->n);
+        addPoints(&points[0], warm->n, n, rng);
+    }
+
+    return SUCCESS;
+}
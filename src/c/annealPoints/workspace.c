@@ -0,0 +1,157 @@
+/**
+ * This module provides the arena the annealers take their configurations from. Large
+ * configurations do not fit on the stack (the best configuration of 170k points alone takes
+ * 4 MB), so they live in blocks allocated on the heap. A buffer is carved off the current block
+ * by bumping an offset. All buffers are released at once by resetting the workspace, which
+ * keeps the blocks for the next run.
+ *
+ * @author Dominik Dahlem
+ */
+#include <stdlib.h>
+
+#include "workspace.h"
+
+
+/**
+ * A block of the arena.
+ */
+struct block_t {
+    struct block_t *next; /** the next block */
+    char *data; /** the aligned memory of the block */
+    size_t size; /** size of the block in bytes */
+    size_t used; /** bytes handed out */
+};
+
+/**
+ * The state of a workspace.
+ */
+struct workspace_t {
+    struct block_t *first; /** the first block */
+    struct block_t *current; /** the block buffers are carved off */
+    size_t inUse; /** bytes handed out since the last reset */
+    size_t peak; /** the largest number of bytes handed out at a time */
+    size_t reserved; /** bytes of all blocks */
+};
+
+
+/**
+ * Create an empty workspace.
+ *
+ * @return struct workspace_t* the workspace or NULL, if the memory could not be allocated
+ */
+struct workspace_t *workspace_create()
+{
+    return (struct workspace_t *) calloc(1, sizeof(struct workspace_t));
+}
+
+/**
+ * Destroy a workspace and all of its buffers.
+ *
+ * @param struct workspace_t* the workspace (may be NULL)
+ */
+void workspace_destroy(struct workspace_t *workspace)
+{
+    struct block_t *block, *next;
+
+    if (workspace == NULL) {
+        return;
+    }
+
+    for (block = workspace->first; block != NULL; block = next) {
+        next = block->next;
+        free(block->data);
+        free(block);
+    }
+
+    free(workspace);
+}
+
+/**
+ * Allocate a buffer from the workspace. The buffer is aligned to WORKSPACE_ALIGNMENT bytes and
+ * lives until the workspace is reset or destroyed.
+ *
+ * @param struct workspace_t *const the workspace
+ * @param const size_t size of the buffer in bytes
+ * @return void* the buffer or NULL, if the memory could not be allocated
+ */
+void *workspace_alloc(struct workspace_t *const workspace, const size_t bytes)
+{
+    size_t size = (bytes + WORKSPACE_ALIGNMENT - 1) / WORKSPACE_ALIGNMENT * WORKSPACE_ALIGNMENT;
+    struct block_t *block = workspace->current;
+    struct block_t *last = NULL;
+    void *data = NULL;
+
+    /* the blocks after the current one are free since the last reset */
+    while (block != NULL && block->used + size > block->size) {
+        last = block;
+        block = block->next;
+    }
+
+    if (block == NULL) {
+        block = (struct block_t *) calloc(1, sizeof(struct block_t));
+
+        if (block == NULL) {
+            return NULL;
+        }
+
+        block->size = (size > WORKSPACE_BLOCK) ? size : WORKSPACE_BLOCK;
+
+        if (posix_memalign(&data, WORKSPACE_ALIGNMENT, block->size) != 0) {
+            free(block);
+            return NULL;
+        }
+
+        block->data = (char *) data;
+        workspace->reserved += block->size;
+
+        /* the search stopped after the last block */
+        if (last == NULL) {
+            workspace->first = block;
+        } else {
+            last->next = block;
+        }
+    }
+
+    workspace->current = block;
+    data = block->data + block->used;
+    block->used += size;
+    workspace->inUse += size;
+    workspace->peak = (workspace->inUse > workspace->peak) ? workspace->inUse : workspace->peak;
+
+    return data;
+}
+
+/**
+ * Release all buffers of the workspace at once. The blocks are kept for the next run.
+ *
+ * @param struct workspace_t *const the workspace
+ */
+void workspace_reset(struct workspace_t *const workspace)
+{
+    struct block_t *block;
+
+    for (block = workspace->first; block != NULL; block = block->next) {
+        block->used = 0;
+    }
+
+    workspace->current = workspace->first;
+    workspace->inUse = 0;
+}
+
+/**
+ * @param const struct workspace_t *const the workspace
+ * @return size_t the largest number of bytes handed out at a time
+ */
+size_t workspace_peak(const struct workspace_t *const workspace)
+{
+    return workspace->peak;
+}
+
+/**
+ * @param const struct workspace_t *const the workspace
+ * @return size_t bytes allocated from the system
+ */
+size_t workspace_reserved(const struct workspace_t *const workspace)
+{
+    return workspace->reserved;
+}
@@ -0,0 +1,549 @@
+/**
+ * Micro-benchmarks of the functions on the hot paths of the simulated annealing. Every case is
+ * timed over a sweep of the number of points, after a few warm-up runs, and the distribution of
+ * the repetitions is reported as nanoseconds per call, in CSV or JSON, so a change can be compared
+ * against a baseline.
+ *
+ * The cheap functions are called in batches of BENCH_BATCH per repetition. The all-pairs functions
+ * are called once per repetition and only up to the limit set with -q, since the scalar versions
+ * take tens of seconds per call for 10^5 points. A case stops repeating once it has used up its
+ * time budget and has at least BENCH_MIN_SAMPLES repetitions.
+ *
+ * @author Dominik Dahlem
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "eval.h"
+#include "kernel.h"
+#include "logging.h"
+#include "points.h"
+#include "pool.h"
+#include "rng.h"
+#include "sphere.h"
+#include "vector.h"
+
+
+/**
+ * @name Benchmark settings
+ */
+//@{
+/**
+ * Smallest number of points of the sweep.
+ */
+#define BENCH_MIN_N 100
+
+/**
+ * Largest number of points of the sweep.
+ */
+#define BENCH_MAX_N 100000
+
+/**
+ * Largest number of points for the all-pairs functions.
+ */
+#define BENCH_QUADRATIC 10000
+
+/**
+ * Number of timed repetitions of a case.
+ */
+#define BENCH_REPETITIONS 11
+
+/**
+ * Number of untimed repetitions before the timed ones.
+ */
+#define BENCH_WARMUP 2
+
+/**
+ * Smallest number of timed repetitions, regardless of the time budget.
+ */
+#define BENCH_MIN_SAMPLES 3
+
+/**
+ * Seconds a case may take before it stops repeating.
+ */
+#define BENCH_BUDGET 1.0
+
+/**
+ * Number of calls of a cheap function per repetition.
+ */
+#define BENCH_BATCH 1024
+
+/**
+ * The variance of the random walk of the proposals.
+ */
+#define BENCH_VARIANCE 0.01
+
+/**
+ * The temperature of the proposals.
+ */
+#define BENCH_TEMPERATURE 1.0
+
+/**
+ * Number of positions scored per call of the batch cases.
+ */
+#define BENCH_TRIES 8
+//@}
+
+
+/**
+ * The data a case operates on.
+ */
+struct fixture_t {
+    struct vector_t *points; /** the configuration */
+    struct points_t store; /** the structure-of-arrays copy of the configuration */
+    struct pool_t *pool; /** the thread pool of the parallel evaluation */
+    struct rng_t rng; /** the random number generator */
+    int n; /** number of points */
+    double current; /** the running objective of the proposal steps */
+    double sink; /** keeps the results alive */
+};
+
+/**
+ * A benchmark case runs one repetition on the fixture.
+ */
+typedef void (*case_t)(struct fixture_t *const fixture);
+
+/**
+ * The description of a benchmark case.
+ */
+struct case_desc_t {
+    const char *name; /** the name of the case */
+    case_t run; /** runs one repetition */
+    int calls; /** number of calls per repetition */
+    int quadratic; /** 1, if the case visits all pairs */
+};
+
+/**
+ * The settings of the benchmark.
+ */
+struct settings_t {
+    int min_n; /** smallest number of points */
+    int max_n; /** largest number of points */
+    int quadratic; /** largest number of points for the all-pairs functions */
+    int repetitions; /** number of timed repetitions */
+    int warmup; /** number of untimed repetitions */
+    int threads; /** number of threads of the parallel evaluation */
+    int json; /** 1 for JSON output, 0 for CSV */
+    double budget; /** seconds per case */
+    long seed; /** seed of the random number generator */
+};
+
+
+/**
+ * @return the current time of the monotonic clock in seconds
+ */
+static double now()
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double) time.tv_sec + 1e-9 * (double) time.tv_nsec;
+}
+
+/**
+ * A batch of uniformly random points.
+ */
+static void getPoint(struct fixture_t *const fixture)
+{
+    struct vector_t point;
+    int i;
+
+    for (i = 0; i < BENCH_BATCH; i++) {
+        point = sphere_getPoint(&fixture->rng);
+        fixture->sink += point.x;
+    }
+}
+
+/**
+ * A batch of random walks of random points.
+ */
+static void walk(struct fixture_t *const fixture)
+{
+    struct vector_t point;
+    int i;
+
+    for (i = 0; i < BENCH_BATCH; i++) {
+        point = sphere_walk(&fixture->points[rng_index(&fixture->rng, fixture->n)],
+                            BENCH_VARIANCE, &fixture->rng);
+        fixture->sink += point.x;
+    }
+}
+
+/**
+ * The sum of the distances of all pairs.
+ */
+static void distance(struct fixture_t *const fixture)
+{
+    fixture->sink += sphere_distance(fixture->points, fixture->n);
+}
+
+/**
+ * The energy of all pairs.
+ */
+static void rieszEnergy(struct fixture_t *const fixture)
+{
+    fixture->sink += sphere_rieszEnergy(fixture->points, fixture->n);
+}
+
+/**
+ * The closest pair, searching all pairs.
+ */
+static void selectClosest(struct fixture_t *const fixture)
+{
+    int index_min[2];
+
+    sphere_selectClosest(fixture->points, fixture->n, index_min);
+    fixture->sink += index_min[0];
+}
+
+/**
+ * The sum of the distances with the tiled, parallel evaluation of the annealers.
+ */
+static void evalDistance(struct fixture_t *const fixture)
+{
+    fixture->sink += eval_distance(fixture->pool, &fixture->store);
+}
+
+/**
+ * The energy with the tiled, parallel evaluation of the annealers.
+ */
+static void evalEnergy(struct fixture_t *const fixture)
+{
+    fixture->sink += eval_energy(fixture->pool, &fixture->store);
+}
+
+/**
+ * A batch of the proposals of sa_distance: a random walk of a random point, the change of the
+ * distance sum, and the Metropolis decision.
+ */
+static void stepDistance(struct fixture_t *const fixture)
+{
+    struct vector_t v_new;
+    double delta;
+    int index;
+    int i;
+
+    for (i = 0; i < BENCH_BATCH; i++) {
+        index = rng_index(&fixture->rng, fixture->n);
+        v_new = sphere_walk(&fixture->points[index], BENCH_VARIANCE, &fixture->rng);
+        delta = kernel_distanceTo(&fixture->store, index, &v_new)
+            - kernel_distanceTo(&fixture->store, index, &fixture->points[index]);
+
+        if (delta > 0.0 || rng_uniform(&fixture->rng) < exp(-fabs(delta) / BENCH_TEMPERATURE)) {
+            vector_copy(&fixture->points[index], &v_new);
+            points_set(&fixture->store, index, &v_new);
+            fixture->current += delta;
+        }
+    }
+}
+
+/**
+ * A batch of the proposals of sa_energy.
+ */
+static void stepEnergy(struct fixture_t *const fixture)
+{
+    struct vector_t v_new;
+    double delta;
+    int index;
+    int i;
+
+    for (i = 0; i < BENCH_BATCH; i++) {
+        index = rng_index(&fixture->rng, fixture->n);
+        v_new = sphere_walk(&fixture->points[index], BENCH_VARIANCE, &fixture->rng);
+        delta = kernel_energyTo(&fixture->store, index, &v_new)
+            - kernel_energyTo(&fixture->store, index, &fixture->points[index]);
+
+        if (delta < 0.0 || rng_uniform(&fixture->rng) < exp(-fabs(delta) / BENCH_TEMPERATURE)) {
+            vector_copy(&fixture->points[index], &v_new);
+            points_set(&fixture->store, index, &v_new);
+            fixture->current += delta;
+        }
+    }
+}
+
+/**
+ * BENCH_TRIES positions of a point scored one after the other, reading the store once per
+ * position.
+ */
+static void energyTo(struct fixture_t *const fixture)
+{
+    struct vector_t positions[BENCH_TRIES];
+    int index;
+    int i;
+    int c;
+
+    for (i = 0; i < BENCH_BATCH / BENCH_TRIES; i++) {
+        index = rng_index(&fixture->rng, fixture->n);
+
+        for (c = 0; c < BENCH_TRIES; c++) {
+            positions[c] = sphere_walk(&fixture->points[index], BENCH_VARIANCE, &fixture->rng);
+            fixture->sink += kernel_energyTo(&fixture->store, index, &positions[c]);
+        }
+    }
+}
+
+/**
+ * BENCH_TRIES positions of a point scored in one batch, as by the multiple-try proposals.
+ */
+static void energyBatchTo(struct fixture_t *const fixture)
+{
+    struct vector_t positions[BENCH_TRIES];
+    double result[BENCH_TRIES];
+    int index;
+    int i;
+    int c;
+
+    for (i = 0; i < BENCH_BATCH / BENCH_TRIES; i++) {
+        index = rng_index(&fixture->rng, fixture->n);
+
+        for (c = 0; c < BENCH_TRIES; c++) {
+            positions[c] = sphere_walk(&fixture->points[index], BENCH_VARIANCE, &fixture->rng);
+        }
+
+        kernel_energyBatchTo(&fixture->store, index, positions, BENCH_TRIES, result);
+        fixture->sink += result[0];
+    }
+}
+
+/**
+ * The benchmark cases.
+ */
+static const struct case_desc_t cases[] = {
+    {"sphere_getPoint", getPoint, BENCH_BATCH, 0},
+    {"sphere_walk", walk, BENCH_BATCH, 0},
+    {"sphere_distance", distance, 1, 1},
+    {"sphere_rieszEnergy", rieszEnergy, 1, 1},
+    {"sphere_selectClosest", selectClosest, 1, 1},
+    {"eval_distance", evalDistance, 1, 1},
+    {"eval_energy", evalEnergy, 1, 1},
+    {"step_distance", stepDistance, BENCH_BATCH, 0},
+    {"step_energy", stepEnergy, BENCH_BATCH, 0},
+    {"kernel_energyTo", energyTo, BENCH_BATCH / BENCH_TRIES, 0},
+    {"kernel_energyBatchTo", energyBatchTo, BENCH_BATCH / BENCH_TRIES, 0}
+};
+
+/**
+ * Compare two doubles for qsort.
+ */
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * The percentile of sorted samples, interpolated linearly between the closest ranks.
+ *
+ * @param const double *const the sorted samples
+ * @param const int number of samples
+ * @param const double the percentile in [0, 100]
+ * @return the percentile
+ */
+static double percentile(const double *const samples, const int count, const double p)
+{
+    double rank = p / 100.0 * (double) (count - 1);
+    int lower = (int) floor(rank);
+    int upper = (lower + 1 < count) ? lower + 1 : lower;
+
+    return samples[lower] + (rank - (double) lower) * (samples[upper] - samples[lower]);
+}
+
+/**
+ * Time a case for a number of points, and print its statistics.
+ *
+ * @param const struct case_desc_t *const the case
+ * @param struct fixture_t *const the fixture
+ * @param const struct settings_t *const the settings
+ * @param double *const room for the samples
+ * @param const int 1, if this is the first result printed
+ */
+static void measure(const struct case_desc_t *const desc, struct fixture_t *const fixture,
+                    const struct settings_t *const settings, double *const samples,
+                    const int first)
+{
+    double start = now();
+    double begin, mean = 0.0;
+    int count = 0;
+    int i;
+
+    for (i = 0; i < settings->warmup && now() - start < settings->budget; i++) {
+        desc->run(fixture);
+    }
+
+    start = now();
+
+    while (count < settings->repetitions
+           && (count < BENCH_MIN_SAMPLES || now() - start < settings->budget)) {
+        begin = now();
+        desc->run(fixture);
+        samples[count++] = 1e9 * (now() - begin) / (double) desc->calls;
+    }
+
+    for (i = 0; i < count; i++) {
+        mean += samples[i] / (double) count;
+    }
+
+    qsort(samples, (size_t) count, sizeof(double), compare);
+
+    if (settings->json) {
+        printf("%s    {\"case\": \"%s\", \"n\": %d, \"calls\": %d, \"samples\": %d, "
+               "\"min_ns\": %.3f, \"p10_ns\": %.3f, \"median_ns\": %.3f, \"p90_ns\": %.3f, "
+               "\"mean_ns\": %.3f}",
+               first ? "" : ",\n", desc->name, fixture->n, desc->calls, count, samples[0],
+               percentile(samples, count, 10.0), percentile(samples, count, 50.0),
+               percentile(samples, count, 90.0), mean);
+    } else {
+        printf("%s,%d,%d,%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", desc->name, fixture->n,
+               settings->threads, kernel_name(), desc->calls, count, samples[0],
+               percentile(samples, count, 10.0), percentile(samples, count, 50.0),
+               percentile(samples, count, 90.0), mean);
+    }
+
+    fflush(stdout);
+    fprintf(stderr, "%-22s n=%-7d median %.1f ns\n", desc->name, fixture->n,
+            percentile(samples, count, 50.0));
+}
+
+/**
+ * Display the usage of the benchmark.
+ */
+static void usage()
+{
+    printf("bench - Time the hot-path functions of the simulated annealing.\n");
+    printf(" -b : Seconds per case before it stops repeating (%.1f).\n", BENCH_BUDGET);
+    printf(" -j : Write JSON instead of CSV.\n");
+    printf(" -m : Smallest number of points (%d).\n", BENCH_MIN_N);
+    printf(" -n : Largest number of points (%d). The number of points grows by a factor\n"
+           "      of 10 from the smallest to the largest.\n", BENCH_MAX_N);
+    printf(" -p : Number of threads of the parallel evaluation (1).\n");
+    printf(" -q : Largest number of points for the all-pairs functions (%d).\n",
+           BENCH_QUADRATIC);
+    printf(" -r : Number of timed repetitions (%d).\n", BENCH_REPETITIONS);
+    printf(" -s : Seed of the random number generator.\n");
+    printf(" -w : Number of warm-up repetitions (%d).\n", BENCH_WARMUP);
+    printf(" -h : This help message.\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    struct settings_t settings;
+    struct fixture_t fixture;
+    double *samples;
+    int first = 1;
+    int opt, c, n;
+
+    settings.min_n = BENCH_MIN_N;
+    settings.max_n = BENCH_MAX_N;
+    settings.quadratic = BENCH_QUADRATIC;
+    settings.repetitions = BENCH_REPETITIONS;
+    settings.warmup = BENCH_WARMUP;
+    settings.threads = 1;
+    settings.json = 0;
+    settings.budget = BENCH_BUDGET;
+    settings.seed = 12345678;
+
+    while ((opt = getopt(argc, argv, "jh?b:m:n:p:q:r:s:w:")) != -1) {
+        switch (opt) {
+            case 'b':
+                settings.budget = atof(optarg);
+                break;
+            case 'j':
+                settings.json = 1;
+                break;
+            case 'm':
+                settings.min_n = atoi(optarg);
+                break;
+            case 'n':
+                settings.max_n = atoi(optarg);
+                break;
+            case 'p':
+                settings.threads = atoi(optarg);
+                break;
+            case 'q':
+                settings.quadratic = atoi(optarg);
+                break;
+            case 'r':
+                settings.repetitions = atoi(optarg);
+                break;
+            case 's':
+                settings.seed = atol(optarg);
+                break;
+            case 'w':
+                settings.warmup = atoi(optarg);
+                break;
+            default:
+                usage();
+        }
+    }
+
+    if (settings.min_n < 2 || settings.max_n < settings.min_n || settings.repetitions < 1
+        || settings.warmup < 0 || settings.threads < 1) {
+        usage();
+    }
+
+    samples = (double *) malloc((size_t) settings.repetitions * sizeof(double));
+    if (samples == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    /* select the kernel before anything is timed */
+    (void) kernel_name();
+    fixture.pool = pool_create(settings.threads);
+
+    if (settings.json) {
+        printf("{\n  \"kernel\": \"%s\",\n  \"threads\": %d,\n  \"results\": [\n", kernel_name(),
+               settings.threads);
+    } else {
+        printf("case,n,threads,kernel,calls,samples,min_ns,p10_ns,median_ns,p90_ns,mean_ns\n");
+    }
+
+    for (n = settings.min_n; n <= settings.max_n; n *= 10) {
+        fixture.n = n;
+        fixture.points = (struct vector_t *) malloc((size_t) n * sizeof(struct vector_t));
+
+        if (fixture.points == NULL || points_alloc(&fixture.store, n) == FAIL) {
+            fprintf(stderr, "Could not allocate %d points\n", n);
+            exit(EXIT_FAILURE);
+        }
+
+        for (c = 0; c < (int) (sizeof(cases) / sizeof(cases[0])); c++) {
+            if (cases[c].quadratic && n > settings.quadratic) {
+                continue;
+            }
+
+            /* every case starts from the same configuration */
+            rng_seed(&fixture.rng, settings.seed);
+            sphere_initialiseUniformPoints(fixture.points, n, &fixture.rng);
+            points_fromVectors(&fixture.store, fixture.points);
+            fixture.current = 0.0;
+            fixture.sink = 0.0;
+
+            measure(&cases[c], &fixture, &settings, samples, first);
+            first = 0;
+        }
+
+        points_free(&fixture.store);
+        free(fixture.points);
+
+        if (n > settings.max_n / 10) {
+            break;
+        }
+    }
+
+    if (settings.json) {
+        printf("\n  ]\n}\n");
+    }
+
+    pool_destroy(fixture.pool);
+    free(samples);
+
+    return 0;
+}
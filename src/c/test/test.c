@@ -4,15 +4,52 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "cells.h"
+#include "eval.h"
+#include "kernel.h"
+#include "logging.h"
+#include "points.h"
+#include "polish.h"
+#include "pool.h"
+#include "ring.h"
+#include "rng.h"
+#include "sasphere.h"
+#include "tree.h"
 #include "vector.h"
+#include "verlet.h"
 #include "sphere.h"
+#include "warm.h"
 
 
 #define POINTS 1000
 #define SAMPLES 10
 
 
+/**
+ * A run of the library on a thread of a pool.
+ */
+struct job_t {
+    struct sasphere_t *sasphere; /** the context of the run */
+    struct vector_t *points; /** the best configuration */
+    int status; /** the status of the run */
+};
+
+/**
+ * Carry out a run.
+ *
+ * @param void* the runs
+ * @param int the run
+ */
+static void runJob(void *arg, int task)
+{
+    struct job_t *job = (struct job_t *) arg + task;
+
+    job->status = sasphere_run(job->sasphere, NULL, job->points);
+}
+
+
 int main(int argc, char** argv)
 {
     struct vector_t points[POINTS];
@@ -20,11 +57,29 @@ int main(int argc, char** argv)
     int i = 0;
     double mean = 0.0;
     double std = 0.0;
+    struct points_t store;
+    int index_min[2];
+    int index_kernel[2];
+    struct pool_t *pool;
+    struct rng_t rng;
+    struct cells_t *cells;
+    struct verlet_t *verlet;
+    struct ring_t *ring;
+    long record;
+    struct vector_t moved;
+    struct vector_t polished[POINTS];
+    struct vector_t gradient[POINTS];
+    struct vector_t analytic, shifted;
+    double numeric, before, after;
+    int mismatches = 0;
+    struct globalArgs_t args;
+    struct job_t jobs[2];
+    struct warm_t warm;
 
-    srand48(12345678);
+    rng_seed(&rng, 12345678);
 
     for (i = 0; i < SAMPLES; i++) {
-        sphere_initialiseUniformPoints(&points[0], (int) POINTS);
+        sphere_initialiseUniformPoints(&points[0], (int) POINTS, &rng);
         samples[i] = sphere_distance(&points[0], (int) POINTS);
     }
 
@@ -49,5 +104,167 @@ int main(int argc, char** argv)
 
     printf("Mean %f +/- %f\n", mean, std);
 
+    /* compare the pair kernels against the scalar reference implementation */
+    points_alloc(&store, (int) POINTS);
+    points_fromVectors(&store, &points[0]);
+    sphere_selectClosest(&points[0], (int) POINTS, index_min);
+    kernel_closest(&store, index_kernel);
+
+    printf("Kernel %s\n", kernel_name());
+    printf("Distance rel. error %e\n",
+           fabs(kernel_distance(&store) - sphere_distance(&points[0], (int) POINTS))
+           / sphere_distance(&points[0], (int) POINTS));
+    printf("Energy rel. error %e\n",
+           fabs(kernel_energy(&store) - sphere_rieszEnergy(&points[0], (int) POINTS))
+           / fabs(sphere_rieszEnergy(&points[0], (int) POINTS)));
+    printf("Closest pair %d,%d (reference %d,%d)\n",
+           index_kernel[0], index_kernel[1], index_min[0], index_min[1]);
+    printf("Distance row rel. error %e\n",
+           fabs(kernel_distanceTo(&store, POINTS / 3, &points[POINTS / 3])
+                - sphere_distance2(&points[0], (int) POINTS, POINTS / 3))
+           / sphere_distance2(&points[0], (int) POINTS, POINTS / 3));
+    printf("Energy row rel. error %e\n",
+           fabs(kernel_energyTo(&store, POINTS / 3, &points[POINTS / 3])
+                - sphere_rieszEnergy2(&points[0], (int) POINTS, POINTS / 3))
+           / fabs(sphere_rieszEnergy2(&points[0], (int) POINTS, POINTS / 3)));
+
+    /* a point on top of another one has an infinite energy, in every kernel */
+    printf("Coincident energy %f\n", kernel_energyTo(&store, 0, &points[POINTS / 2]));
+
+    /* the parallel evaluation has to be bit-identical for any number of threads */
+    pool = pool_create(4);
+    printf("Parallel distance %s\n",
+           (eval_distance(NULL, &store) == eval_distance(pool, &store)) ? "identical" : "differs");
+    printf("Parallel energy %s\n",
+           (eval_energy(NULL, &store) == eval_energy(pool, &store)) ? "identical" : "differs");
+    eval_closest(pool, &store, index_kernel);
+    printf("Parallel closest pair %d,%d\n", index_kernel[0], index_kernel[1]);
+
+    /* the tree evaluation has to be close to the exact one and independent of the threads */
+    printf("Tree distance relative error %e, %s\n",
+           fabs(tree_distance(pool, &store, 0.5) - eval_distance(NULL, &store))
+           / eval_distance(NULL, &store),
+           (tree_distance(NULL, &store, 0.5) == tree_distance(pool, &store, 0.5))
+           ? "identical" : "differs");
+    printf("Tree energy relative error %e, %s\n",
+           fabs(tree_energy(pool, &store, 0.5) - eval_energy(NULL, &store))
+           / fabs(eval_energy(NULL, &store)),
+           (tree_energy(NULL, &store, 0.5) == tree_energy(pool, &store, 0.5))
+           ? "identical" : "differs");
+
+    /* the cell index has to track the closest pair while points move */
+    cells = cells_create(&store);
+    for (i = 0; i < 1000; i++) {
+        index_min[0] = rng_index(&rng, (int) POINTS);
+        moved = sphere_walk(&points[index_min[0]], 0.001, &rng);
+        points[index_min[0]] = moved;
+        points_set(&store, index_min[0], &moved);
+        cells_move(cells, index_min[0]);
+
+        cells_closest(cells, index_min);
+        eval_closest(NULL, &store, index_kernel);
+        if (index_min[0] != index_kernel[0] || index_min[1] != index_kernel[1]) {
+            mismatches++;
+        }
+    }
+    printf("Cell index mismatches %d\n", mismatches);
+    cells_destroy(cells);
+
+    /* the cutoff energy has to stay close to the exact energy while points move */
+    verlet = verlet_create(&store, 4.0 * sqrt(4.0 * M_PI / POINTS));
+    for (i = 0; i < 1000; i++) {
+        index_min[0] = rng_index(&rng, (int) POINTS);
+        moved = sphere_walk(&points[index_min[0]], 0.01, &rng);
+        points[index_min[0]] = moved;
+        points_set(&store, index_min[0], &moved);
+        verlet_move(verlet, index_min[0]);
+    }
+    printf("Cutoff energy relative error %e (%ld list rebuilds)\n",
+           fabs(verlet_energy(verlet) - eval_energy(NULL, &store)) / fabs(eval_energy(NULL, &store)),
+           verlet_rebuilds(verlet));
+    verlet_destroy(verlet);
+
+    /* the analytic gradient has to match the central difference of the pair energies */
+    points_fromVectors(&store, &points[0]);
+    moved = points_get(&store, 0);
+    analytic = kernel_energyGradientTo(&store, 0, &moved);
+    shifted = moved;
+    shifted.x += 1e-6;
+    numeric = kernel_energyTo(&store, 0, &shifted);
+    shifted.x -= 2e-6;
+    numeric = (numeric - kernel_energyTo(&store, 0, &shifted)) / 2e-6;
+    printf("Energy gradient relative error %e\n", fabs(analytic.x - numeric) / fabs(numeric));
+    eval_energyGradient(NULL, &store, &gradient[0]);
+    eval_energyGradient(pool, &store, &polished[0]);
+    for (i = 0; i < POINTS && vector_dotProduct(&gradient[i], &gradient[i])
+             == vector_dotProduct(&polished[i], &polished[i]); i++) {
+    }
+    printf("Parallel energy gradient %s\n", (i == POINTS) ? "identical" : "differs");
+
+    /* a batch of positions has to score like the positions one after the other */
+    for (i = 0; i < SAMPLES; i++) {
+        polished[i] = sphere_walk(&points[500], 0.01, &rng);
+    }
+    kernel_energyBatchTo(&store, 500, &polished[0], SAMPLES, &samples[0]);
+    numeric = 0.0;
+    for (i = 0; i < SAMPLES; i++) {
+        before = fabs(samples[i] - kernel_energyTo(&store, 500, &polished[i]))
+            / fabs(kernel_energyTo(&store, 500, &polished[i]));
+        numeric = (before > numeric) ? before : numeric;
+    }
+    printf("Batched energy relative error %e\n", numeric);
+
+    /* the polish must not make the configuration worse */
+    vector_arrayCopy(&polished[0], &points[0], (int) POINTS);
+    i = polish_run(pool, &polished[0], (int) POINTS, OBJECTIVE_ENERGY, 20, &before, &after);
+    printf("Polished energy from %f to %f in %d iterations\n", before, after, i);
+    pool_destroy(pool);
+
+    points_free(&store);
+
+    /* the ring has to reject records once it is full and return them in order */
+    ring = ring_create(1000, sizeof(long));
+    for (record = 0; ring_push(ring, &record) == SUCCESS; record++) {
+    }
+    printf("Ring capacity %ld, ", record);
+    for (i = 0; ring_pop(ring, &record) == SUCCESS && record == i; i++) {
+    }
+    printf("%d records popped in order\n", i);
+    ring_destroy(ring);
+
+    /* independent contexts have to anneal to the same configuration, even at the same time */
+    sasphere_defaults(&args);
+    args.n = 40;
+    args.iter = 20;
+    args.damping = 0.9;
+    args.objective = OBJECTIVE_ENERGY;
+    for (i = 0; i < 2; i++) {
+        jobs[i].sasphere = sasphere_create(&args, NULL);
+        jobs[i].points = &polished[i * args.n];
+    }
+    pool = pool_create(2);
+    pool_run(pool, 2, runJob, &jobs[0]);
+    pool_destroy(pool);
+    printf("Concurrent runs %s\n", (jobs[0].status == SUCCESS && jobs[1].status == SUCCESS
+            && memcmp(jobs[0].points, jobs[1].points, args.n * sizeof(struct vector_t)) == 0)
+           ? "identical" : "differ");
+    for (i = 0; i < 2; i++) {
+        sasphere_destroy(jobs[i].sasphere);
+    }
+
+    /* dropping points must not bring the closest pair closer, adding them keeps the others */
+    memset(&warm, 0, sizeof(warm));
+    warm.points = &points[0];
+    warm.n = 100;
+    sphere_selectClosest(&points[0], warm.n, index_min);
+    before = euclideanDistance(&points[index_min[0]], &points[index_min[1]]);
+    warm_fit(&polished[0], 80, &warm, &rng);
+    sphere_selectClosest(&polished[0], 80, index_min);
+    after = euclideanDistance(&polished[index_min[0]], &polished[index_min[1]]);
+    warm_fit(&polished[0], 120, &warm, &rng);
+    printf("Warm start closest pair from %f to %f, points %s\n", before, after,
+           (memcmp(&polished[0], &points[0], warm.n * sizeof(struct vector_t)) == 0)
+           ? "kept" : "changed");
+
     return 0;
 }
@@ -0,0 +1,154 @@
+/**
+ * Converts a binary trace of the simulation (sim.trace) into CSV. A trace of samples is written
+ * in the layout of the former sim.log, a trace of temperature levels with one line per level.
+ *
+ * @author Dominik Dahlem
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+
+/**
+ * Read a column of a block.
+ *
+ * @return int 1, if the column was read completely
+ */
+static int column(void *values, const size_t size, const uint32_t count, FILE *file)
+{
+    return fread(values, size, count, file) == count;
+}
+
+/**
+ * Convert the blocks of samples.
+ *
+ * @return int 0 on success, 1 if the trace is truncated
+ */
+static int samples(FILE *in, FILE *out)
+{
+    static int64_t iteration[TRACE_BLOCK];
+    static double objective[TRACE_BLOCK], delta[TRACE_BLOCK], temperature[TRACE_BLOCK],
+        variance[TRACE_BLOCK];
+    static uint8_t accepted[TRACE_BLOCK];
+    uint32_t count, k;
+
+    fprintf(out, "Iteration,Distance,DistanceDelta,Temperature,Variance,Accepted\n");
+
+    while (fread(&count, sizeof(uint32_t), 1, in) == 1) {
+        if (count > TRACE_BLOCK
+            || !column(iteration, sizeof(int64_t), count, in)
+            || !column(objective, sizeof(double), count, in)
+            || !column(delta, sizeof(double), count, in)
+            || !column(temperature, sizeof(double), count, in)
+            || !column(variance, sizeof(double), count, in)
+            || !column(accepted, sizeof(uint8_t), count, in)) {
+            return 1;
+        }
+
+        for (k = 0; k < count; k++) {
+            fprintf(out, "%ld,%f,%f,%f,%f,%d\n", (long) iteration[k], objective[k], delta[k],
+                    temperature[k], variance[k], (int) accepted[k]);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Convert the blocks of temperature levels.
+ *
+ * @return int 0 on success, 1 if the trace is truncated
+ */
+static int levels(FILE *in, FILE *out)
+{
+    static int64_t level[TRACE_BLOCK], iteration[TRACE_BLOCK];
+    static double temperature[TRACE_BLOCK], variance[TRACE_BLOCK], mean[TRACE_BLOCK],
+        min[TRACE_BLOCK], max[TRACE_BLOCK], std[TRACE_BLOCK], acceptance[TRACE_BLOCK],
+        seconds[TRACE_BLOCK];
+    uint32_t count, k;
+
+    fprintf(out, "Level,Iteration,Temperature,Variance,Mean,Min,Max,StdDev,Acceptance,Seconds\n");
+
+    while (fread(&count, sizeof(uint32_t), 1, in) == 1) {
+        if (count > TRACE_BLOCK
+            || !column(level, sizeof(int64_t), count, in)
+            || !column(iteration, sizeof(int64_t), count, in)
+            || !column(temperature, sizeof(double), count, in)
+            || !column(variance, sizeof(double), count, in)
+            || !column(mean, sizeof(double), count, in)
+            || !column(min, sizeof(double), count, in)
+            || !column(max, sizeof(double), count, in)
+            || !column(std, sizeof(double), count, in)
+            || !column(acceptance, sizeof(double), count, in)
+            || !column(seconds, sizeof(double), count, in)) {
+            return 1;
+        }
+
+        for (k = 0; k < count; k++) {
+            fprintf(out, "%ld,%ld,%f,%f,%f,%f,%f,%f,%f,%f\n", (long) level[k],
+                    (long) iteration[k], temperature[k], variance[k], mean[k], min[k], max[k],
+                    std[k], acceptance[k], seconds[k]);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * The main function.
+ *
+ * @param int number of arguments
+ * @param char** the trace file and, optionally, the CSV file (standard output otherwise)
+ * @return the return code of the application.
+ */
+int main(int argc, char **argv)
+{
+    struct trace_header_t header;
+    FILE *in, *out;
+    int status;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: traceconv <sim.trace> [<sim.log>]\n");
+        return EXIT_FAILURE;
+    }
+
+    in = fopen(argv[1], "rb");
+
+    if (in == NULL) {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (fread(&header, sizeof(struct trace_header_t), 1, in) != 1
+        || strncmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != TRACE_VERSION) {
+        fprintf(stderr, "%s is not a trace of version %d\n", argv[1], TRACE_VERSION);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    out = (argc > 2) ? fopen(argv[2], "w") : stdout;
+
+    if (out == NULL) {
+        fprintf(stderr, "Could not open %s\n", argv[2]);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    status = (header.kind == TRACE_SAMPLES) ? samples(in, out) : levels(in, out);
+
+    if (status != 0) {
+        fprintf(stderr, "%s is truncated\n", argv[1]);
+    }
+
+    fclose(in);
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return (status == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
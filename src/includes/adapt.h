@@ -0,0 +1,39 @@
+#ifndef ADAPT_H
+#define ADAPT_H
+
+/**
+ * Smallest step size of the random walk.
+ */
+#define ADAPT_MIN 1e-6
+
+/**
+ * Largest step size of the random walk.
+ */
+#define ADAPT_MAX 1.0
+
+/**
+ * Gain of the controller. The step size is multiplied by exp(ADAPT_GAIN * (ratio - target)) at
+ * the end of every temperature level.
+ */
+#define ADAPT_GAIN 1.0
+
+/**
+ * The step sizes of the random walk, tuned toward a target acceptance ratio. There is either one
+ * step size for all points or one for every point.
+ */
+struct adapt_t;
+
+struct adapt_t *adapt_create(const double target, const int count);
+
+void adapt_destroy(struct adapt_t *adapt);
+
+int adapt_count(const struct adapt_t *const adapt);
+
+double *adapt_scales(struct adapt_t *const adapt);
+
+double adapt_scale(const struct adapt_t *const adapt, const int index, const double initial);
+
+void adapt_update(struct adapt_t *const adapt, const int index, const double scale,
+                  const int accepted, const int proposals);
+
+#endif /* ADAPT_H */
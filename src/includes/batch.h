@@ -0,0 +1,26 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "global.h"
+
+/**
+ * Name of the index of the jobs in the directory of a batch.
+ */
+#define BATCH_INDEX "batch.log"
+
+/**
+ * Name of the best configurations of the jobs in the directory of a batch.
+ */
+#define BATCH_BEST "best.log"
+
+/**
+ * A job of a batch.
+ */
+struct batch_job_t {
+    struct globalArgs_t args; /** the parameters of the job */
+    char *from; /** the configuration the job starts from (NULL for a random one) */
+};
+
+int batch_run(const struct batch_job_t *const jobs, const int count, const int workers);
+
+#endif /* BATCH_H */
@@ -0,0 +1,25 @@
+#ifndef BEST_H
+#define BEST_H
+
+#include "vector.h"
+#include "workspace.h"
+
+/**
+ * Lazy tracking of the best configuration. The best configuration is only written when it is
+ * needed, from the points moved since it was last written and an undo journal of the points
+ * moved since the best was found.
+ */
+struct best_t;
+
+struct best_t *best_create(struct workspace_t *const workspace, struct vector_t *const best_points,
+                           const struct vector_t *const points, const int n);
+
+void best_moved(struct best_t *const best, const int index);
+
+void best_improved(struct best_t *const best);
+
+void best_materialise(struct best_t *const best);
+
+void best_replaced(struct best_t *const best, const struct vector_t *const points);
+
+#endif /* BEST_H */
@@ -0,0 +1,30 @@
+#ifndef CELLS_H
+#define CELLS_H
+
+#include "points.h"
+
+/**
+ * Cell size in multiples of \f$ \sqrt{4 \pi / N} \f$, the side of the area per point on the
+ * unit sphere. The nearest neighbours of well spread points and the globally closest pair lie
+ * well within one cell, and a cell holds a handful of points.
+ */
+#define CELLS_SPACING 2.0
+
+/**
+ * A spatial index over the points on the sphere. The points are binned into a hashed grid of
+ * cubic cells, and for every point the nearest neighbour within one cell size is maintained
+ * together with a heap over the nearest-neighbour distances.
+ */
+struct cells_t;
+
+struct cells_t *cells_create(const struct points_t *const points);
+
+void cells_destroy(struct cells_t *cells);
+
+void cells_move(struct cells_t *const cells, const int index);
+
+double cells_closest(const struct cells_t *const cells, int *index_min);
+
+double cells_nearest(const struct cells_t *const cells, const int index, int *neighbour);
+
+#endif /* CELLS_H */
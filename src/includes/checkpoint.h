@@ -0,0 +1,58 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "global.h"
+#include "rng.h"
+#include "schedule.h"
+#include "vector.h"
+
+/**
+ * Magic bytes at the beginning of a checkpoint file.
+ */
+#define CHECKPOINT_MAGIC "SACHKPT"
+
+/**
+ * Version of the checkpoint format.
+ */
+#define CHECKPOINT_VERSION 7
+
+/**
+ * Name of the checkpoint file in the log directory.
+ */
+#define CHECKPOINT_FILE "checkpoint.bin"
+
+/**
+ * The state of a simulated annealing run at the end of a temperature level. Everything that
+ * determines the rest of the run is in here, so a run resumed from a checkpoint continues
+ * bit-exactly.
+ */
+struct checkpoint_t {
+    struct globalArgs_t args; /** the parameters of the simulation */
+    struct rng_t rng; /** the random number generator */
+    struct schedule_t schedule; /** the state of the cooling schedule */
+    double temperature; /** the temperature of the next level */
+    double current; /** the running objective of the current configuration */
+    double best; /** the objective of the best configuration */
+    long iteration; /** number of proposals so far */
+    struct vector_t *points; /** the current configuration (n points) */
+    struct vector_t *best_points; /** the best configuration (n points) */
+    double *scales; /** the tuned step sizes of the random walk (NULL for none) */
+    int scale_count; /** number of tuned step sizes */
+    void *map; /** the mapping of a loaded checkpoint */
+    size_t size; /** the size of the mapping */
+};
+
+int checkpoint_due(struct timespec *const last, const double interval);
+
+int checkpoint_save(const char *const dir, const struct checkpoint_t *const checkpoint);
+
+int checkpoint_map(const char *const file, struct checkpoint_t *const checkpoint);
+
+int checkpoint_load(const char *const dir, struct checkpoint_t *const checkpoint);
+
+void checkpoint_release(struct checkpoint_t *const checkpoint);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,27 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "points.h"
+#include "pool.h"
+#include "vector.h"
+
+/**
+ * Number of tiles the i<j triangle of the pair sums is split into. The number does not depend
+ * on the number of threads, and the partial sums of the tiles are reduced in tile order, so the
+ * results are bit-identical for any number of threads.
+ */
+#define EVAL_TILES 256
+
+double eval_distance(struct pool_t *const pool, const struct points_t *const points);
+
+double eval_energy(struct pool_t *const pool, const struct points_t *const points);
+
+double eval_closest(struct pool_t *const pool, const struct points_t *const points, int *index_min);
+
+void eval_distanceGradient(struct pool_t *const pool, const struct points_t *const points,
+                           struct vector_t *const gradient);
+
+void eval_energyGradient(struct pool_t *const pool, const struct points_t *const points,
+                         struct vector_t *const gradient);
+
+#endif /* EVAL_H */
@@ -2,7 +2,26 @@
 #define GLOBAL_H
 
 /**
- * A structure to capture the global arguments passed into application on the
+ * The objectives the points can be annealed for.
+ */
+enum objective_t {
+    OBJECTIVE_DISTANCE, /** maximise the sum of the distances */
+    OBJECTIVE_CLOSENESS, /** maximise the sum of the distances moving the closest pair apart */
+    OBJECTIVE_ENERGY /** minimise the logarithmic Riesz energy */
+};
+
+/**
+ * The cooling schedules of the simulated annealing.
+ */
+enum schedule_kind_t {
+    SCHEDULE_GEOMETRIC, /** multiply the temperature by the damping factor */
+    SCHEDULE_LOGARITHMIC, /** T0 / (1 + a log(1 + k)), reaching the minimum in as many levels as the geometric one */
+    SCHEDULE_ADAPTIVE, /** cool slowly where the objective fluctuates strongly (Lam/Huang) */
+    SCHEDULE_REHEAT /** geometric, but reheat when the best objective stagnates */
+};
+
+/**
+ * A structure to capture the parameters of a run, which the application takes from the
  * command-line.
  */
 struct globalArgs_t {
@@ -11,7 +30,26 @@ struct globalArgs_t {
     int iter; /** iteration count for the inner loop */
     int n; /** number of transmitters */
     double temp; /** initial temperature */
+    double initialAcceptance; /** initial acceptance ratio the initial temperature is estimated for (0 to use temp) */
     double damping; /** damping factor */
-} globalArgs;
+    int threads; /** number of threads evaluating the whole configuration */
+    int replicas; /** number of replicas for parallel tempering (1 for simulated annealing) */
+    enum objective_t objective; /** the objective to anneal for */
+    double cutoff; /** cutoff radius of the approximate energy in multiples of the mean spacing (0 for the exact energy) */
+    int reportError; /** flag to report the error of the approximate energy */
+    double theta; /** opening angle of the tree evaluation (0 for the exact evaluation) */
+    double accuracy; /** accuracy target the opening angle is tuned for (0 to keep the angle) */
+    int sampling; /** trace every sampling-th proposal (0 to trace aggregates per temperature) */
+    int block; /** flag to block instead of dropping trace records */
+    double checkpoint; /** seconds between two checkpoints (0 for no checkpoints) */
+    double acceptance; /** target acceptance ratio of the adaptive step size (0 for the fixed schedule) */
+    int perPoint; /** flag to adapt the step size of every point separately */
+    enum schedule_kind_t schedule; /** the cooling schedule */
+    int patience; /** stop after that many levels without improvement of the best objective (0 to run until the minimum temperature) */
+    double plateau; /** relative improvement of the best objective below which a level counts as without improvement */
+    int tries; /** number of candidates of a multiple-try Metropolis proposal (1 for a single random walk) */
+    int speculative; /** number of distinct points proposed and scored in parallel per round (1 for sequential proposals) */
+    int polish; /** maximum number of iterations of the gradient descent polishing the best configuration (0 for none) */
+};
 
 #endif /* GLOBAL_H */
@@ -0,0 +1,39 @@
+#ifndef GRID_H
+#define GRID_H
+
+/**
+ * Number of cells around and including a cell.
+ */
+#define GRID_NEIGHBOURS 27
+
+/**
+ * A hashed grid of cubic cells over [-1, 1]^3. Only the cells intersecting the sphere hold
+ * points, so every cell maps onto one of a power-of-two number of buckets, each of which is a
+ * doubly linked list of points. All points within one cell size of a position lie in the
+ * buckets of the 27 cells around the cell of the position.
+ */
+struct grid_t {
+    double size; /** the side of a cell */
+    int n; /** number of points */
+    int buckets; /** number of buckets of the hash table (a power of two) */
+    int *head; /** the first point of every bucket, or -1 */
+    int *next; /** the next point in the bucket of every point, or -1 */
+    int *prev; /** the previous point in the bucket of every point, or -1 */
+    int *cell; /** the cell coordinates of every point (three per point) */
+};
+
+int grid_alloc(struct grid_t *const grid, const int n, const double size);
+
+void grid_free(struct grid_t *const grid);
+
+void grid_cell(const struct grid_t *const grid, const double x, const double y, const double z,
+               int *cell);
+
+void grid_insert(struct grid_t *const grid, const int index, const double x, const double y,
+                 const double z);
+
+void grid_remove(struct grid_t *const grid, const int index);
+
+int grid_neighbours(const struct grid_t *const grid, const int *cell, int *list);
+
+#endif /* GRID_H */
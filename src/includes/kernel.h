@@ -0,0 +1,57 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "points.h"
+#include "vector.h"
+
+
+/**
+ * Environment variable to force a particular kernel implementation (scalar, avx2, or avx512).
+ */
+#define KERNEL_ENV "SA_KERNEL"
+
+/**
+ * Number of stored points scored against all positions of a batch before moving on. A tile of
+ * the three coordinate arrays takes 48 KiB and stays in the L2 cache.
+ */
+#define KERNEL_BATCH_TILE 2048
+
+
+const char *kernel_name();
+
+double kernel_distanceRow(const struct points_t *const points, const int from, const int to,
+                          const struct vector_t *const point);
+
+double kernel_energyRow(const struct points_t *const points, const int from, const int to,
+                        const struct vector_t *const point);
+
+double kernel_closestRow(const struct points_t *const points, const int from, const int to,
+                         const struct vector_t *const point, int *index);
+
+double kernel_distanceTo(const struct points_t *const points, const int index,
+                         const struct vector_t *const point);
+
+double kernel_energyTo(const struct points_t *const points, const int index,
+                       const struct vector_t *const point);
+
+void kernel_distanceBatchTo(const struct points_t *const points, const int index,
+                            const struct vector_t *const candidates, const int count,
+                            double *result);
+
+void kernel_energyBatchTo(const struct points_t *const points, const int index,
+                          const struct vector_t *const candidates, const int count,
+                          double *result);
+
+struct vector_t kernel_distanceGradientTo(const struct points_t *const points, const int index,
+                                          const struct vector_t *const point);
+
+struct vector_t kernel_energyGradientTo(const struct points_t *const points, const int index,
+                                        const struct vector_t *const point);
+
+double kernel_distance(const struct points_t *const points);
+
+double kernel_energy(const struct points_t *const points);
+
+double kernel_closest(const struct points_t *const points, int *index_min);
+
+#endif /* KERNEL_H */
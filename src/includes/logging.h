@@ -4,19 +4,54 @@
 #define SUCCESS 1
 #define FAIL -1
 
-void logging_close();
+/**
+ * Number of records the ring between the annealing thread and the writer thread holds.
+ */
+#define LOGGING_RING 65536
 
-int logging_open();
+/**
+ * Size of the stdio buffers of the log files.
+ */
+#define LOGGING_BUFFER (1 << 20)
 
-void logging_logBest(double x, double y, double z);
+/**
+ * Nanoseconds the writer thread sleeps while the ring is empty.
+ */
+#define LOGGING_IDLE 1000000
 
-void logging_logInitial(double x, double y, double z);
+/**
+ * The directory the time-stamped log directories are created in.
+ */
+#define LOGGING_BASE "./log/"
 
-void logging_logSim(long iteration, double bestDistance, double deltaDistance,
-                    double temperature, double variance, int accpeted);
+/**
+ * Number of log directories that can be created per second.
+ */
+#define LOGGING_SUFFIXES 1000
 
-void logging_logParam(long seed, int iteration, int transmitters, double initialTemperature,
-                      double damping, int uniform);
+/**
+ * The log files of a run, written by a thread of their own.
+ */
+struct logging_t;
+
+char *logging_createDirectory();
+
+struct logging_t *logging_open(const int sampling, const int block);
+
+void logging_close(struct logging_t *log);
+
+const char *logging_directory(const struct logging_t *const log);
+
+void logging_logBest(struct logging_t *const log, double x, double y, double z);
+
+void logging_logInitial(struct logging_t *const log, double x, double y, double z);
+
+void logging_logSim(struct logging_t *const log, long iteration, double bestDistance,
+                    double deltaDistance, double temperature, double variance, int accepted);
+
+void logging_logParam(struct logging_t *const log, long seed, int iteration, int transmitters,
+                      double initialTemperature, double damping, int uniform,
+                      double initialAcceptance);
 
 
 #endif /* LOGGING_H */
@@ -0,0 +1,32 @@
+#ifndef MTM_H
+#define MTM_H
+
+#include "rng.h"
+#include "vector.h"
+
+/**
+ * Largest number of candidates of a multiple-try proposal.
+ */
+#define MTM_MAX_TRIES 64
+
+/**
+ * Scores a batch of positions of a point. The first argument is the one given to mtm_create,
+ * followed by the index of the point, the positions, their number, and the array receiving the
+ * objective contribution of every position.
+ */
+typedef void (*mtm_score_t)(void *, int, const struct vector_t *, int, double *);
+
+/**
+ * The state of multiple-try Metropolis proposals.
+ */
+struct mtm_t;
+
+struct mtm_t *mtm_create(const int tries, const int sense, mtm_score_t score, void *arg);
+
+void mtm_destroy(struct mtm_t *mtm);
+
+int mtm_propose(struct mtm_t *const mtm, const int index, const struct vector_t *const current,
+                const double variance, const double temperature, struct rng_t *const rng,
+                struct vector_t *const chosen, double *delta);
+
+#endif /* MTM_H */
@@ -0,0 +1,35 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "global.h"
+#include "perf.h"
+#include "vector.h"
+
+/**
+ * Called with the parameters of a run, including an estimated initial temperature, and the
+ * initial configuration before the annealing starts.
+ */
+typedef void (*output_start_t)(void *arg, const struct globalArgs_t *args,
+                               const struct vector_t *initial);
+
+/**
+ * Called for every proposal of the simulated annealing and every exchange round of the parallel
+ * tempering with the iteration, the objective, its change, the temperature, the variance of the
+ * random walk, and whether the proposal was accepted.
+ */
+typedef void (*output_progress_t)(void *arg, long iteration, double objective, double delta,
+                                  double temperature, double variance, int accepted);
+
+/**
+ * Where a run reports to. The callbacks are called from the thread running the annealing, and
+ * each of them may be NULL.
+ */
+struct output_t {
+    output_start_t start; /** reports the start of the run */
+    output_progress_t progress; /** reports the proposals */
+    const char *checkpoints; /** the directory the checkpoints are written to (NULL for none) */
+    void *arg; /** passed to the callbacks */
+    struct perf_t *perf; /** counts the run, if built with PERF=1 (NULL for no counting) */
+};
+
+#endif /* OUTPUT_H */
@@ -0,0 +1,83 @@
+#ifndef PERF_H
+#define PERF_H
+
+/**
+ * The phases of the annealing loops that are timed.
+ */
+enum perf_phase_t {
+    PERF_PROPOSE, /** generating a proposal (sphere_walk, sphere_moveApart) */
+    PERF_EVALUATE, /** scoring a proposal */
+    PERF_COMMIT, /** applying an accepted proposal to the point store and the indices */
+    PERF_BEST, /** copying the best configuration */
+    PERF_LOGGING, /** handing the proposal to the logging */
+    PERF_RESYNC, /** evaluating the whole configuration */
+    PERF_CHECKPOINT, /** writing checkpoints */
+    PERF_PHASES
+};
+
+/**
+ * The events of the annealing loops that are counted.
+ */
+enum perf_counter_t {
+    PERF_PROPOSALS, /** proposals */
+    PERF_ACCEPTED, /** accepted proposals */
+    PERF_LEVELS, /** temperature levels */
+    PERF_COUNTERS
+};
+
+/**
+ * The counters and cycle timers of a run.
+ */
+struct perf_t;
+
+#ifdef SA_PERF
+
+#include <stdint.h>
+#include <x86intrin.h>
+
+struct perf_t *perf_create();
+
+void perf_destroy(struct perf_t *perf);
+
+void perf_attach(struct perf_t *const perf);
+
+void perf_detach();
+
+void perf_add(const enum perf_phase_t phase, const uint64_t cycles);
+
+void perf_count(const enum perf_counter_t counter, const long events);
+
+void perf_report(const struct perf_t *const perf, const char *const dir);
+
+/**
+ * Start timing a phase. The time stamp counter is read without serialisation, which is accurate
+ * enough for phases of a few hundred cycles and more.
+ */
+#define PERF_BEGIN(phase) uint64_t perf_##phase = __rdtsc()
+
+/**
+ * Stop timing a phase started in the same scope.
+ */
+#define PERF_END(phase) perf_add(phase, __rdtsc() - perf_##phase)
+
+#define PERF_COUNT(counter, events) perf_count(counter, events)
+#define PERF_CREATE() perf_create()
+#define PERF_DESTROY(perf) perf_destroy(perf)
+#define PERF_ATTACH(perf) perf_attach(perf)
+#define PERF_DETACH() perf_detach()
+#define PERF_REPORT(perf, dir) perf_report(perf, dir)
+
+#else
+
+#define PERF_BEGIN(phase)
+#define PERF_END(phase)
+#define PERF_COUNT(counter, events)
+#define PERF_CREATE() NULL
+#define PERF_DESTROY(perf)
+#define PERF_ATTACH(perf)
+#define PERF_DETACH()
+#define PERF_REPORT(perf, dir)
+
+#endif /* SA_PERF */
+
+#endif /* PERF_H */
@@ -0,0 +1,42 @@
+#ifndef POINTS_H
+#define POINTS_H
+
+#include "vector.h"
+
+/**
+ * Alignment in bytes of the coordinate arrays. 64 bytes cover a cache line and the widest
+ * vector registers used by the pair kernels.
+ */
+#define POINTS_ALIGNMENT 64
+
+/**
+ * Number of doubles the coordinate arrays are padded to, so that the vectorised kernels can
+ * operate on whole registers.
+ */
+#define POINTS_PADDING 8
+
+/**
+ * A structure-of-arrays store for points on the sphere. The x, y, and z coordinates are kept in
+ * separate aligned arrays, so that the pair kernels can stream them through vector registers.
+ */
+struct points_t {
+    double *x; /** x-coordinates */
+    double *y; /** y-coordinates */
+    double *z; /** z-coordinates */
+    int n; /** number of points */
+    int capacity; /** allocated number of points (a multiple of POINTS_PADDING) */
+};
+
+int points_alloc(struct points_t *const points, const int n);
+
+void points_free(struct points_t *const points);
+
+void points_set(struct points_t *const points, const int index, const struct vector_t *const vector);
+
+struct vector_t points_get(const struct points_t *const points, const int index);
+
+void points_fromVectors(struct points_t *const points, const struct vector_t *const vectors);
+
+void points_toVectors(const struct points_t *const points, struct vector_t *const vectors);
+
+#endif /* POINTS_H */
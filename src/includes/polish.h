@@ -0,0 +1,38 @@
+#ifndef POLISH_H
+#define POLISH_H
+
+#include "global.h"
+#include "pool.h"
+#include "vector.h"
+
+/**
+ * Number of correction pairs kept by the L-BFGS descent.
+ */
+#define POLISH_MEMORY 8
+
+/**
+ * Largest displacement of a point along the steepest descent when the descent starts or is
+ * restarted.
+ */
+#define POLISH_STEP 1e-3
+
+/**
+ * Sufficient decrease parameter of the Armijo line search.
+ */
+#define POLISH_ARMIJO 1e-4
+
+/**
+ * Maximum number of halvings of the step of the line search.
+ */
+#define POLISH_BACKTRACKS 40
+
+/**
+ * The descent stops once the largest Riemannian gradient of a point falls below this value.
+ */
+#define POLISH_TOLERANCE 1e-10
+
+int polish_run(struct pool_t *const pool, struct vector_t *const points, const int n,
+               const enum objective_t objective, const int iterations,
+               double *before, double *after);
+
+#endif /* POLISH_H */
@@ -0,0 +1,23 @@
+#ifndef POOL_H
+#define POOL_H
+
+/**
+ * A task executed by the thread pool. The first argument is the shared argument passed to
+ * pool_run, the second one the number of the task.
+ */
+typedef void (*pool_task_t)(void *arg, int task);
+
+/**
+ * A fixed-size pool of worker threads executing parallel loops over numbered tasks.
+ */
+struct pool_t;
+
+struct pool_t *pool_create(const int threads);
+
+void pool_destroy(struct pool_t *pool);
+
+int pool_size(const struct pool_t *const pool);
+
+void pool_run(struct pool_t *const pool, const int tasks, pool_task_t task, void *arg);
+
+#endif /* POOL_H */
@@ -0,0 +1,14 @@
+#ifndef PT_H
+#define PT_H
+
+#include "global.h"
+#include "output.h"
+#include "rng.h"
+#include "vector.h"
+#include "workspace.h"
+
+int pt_run(struct vector_t *points, const struct globalArgs_t *const globalArgs,
+           struct rng_t *const rng, struct workspace_t *const workspace,
+           const struct output_t *const output);
+
+#endif /* PT_H */
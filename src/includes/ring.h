@@ -0,0 +1,20 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+
+/**
+ * A bounded single-producer/single-consumer queue of fixed-size records. One thread may push and
+ * another one may pop concurrently without locks.
+ */
+struct ring_t;
+
+struct ring_t *ring_create(const int capacity, const size_t size);
+
+void ring_destroy(struct ring_t *ring);
+
+int ring_push(struct ring_t *const ring, const void *const record);
+
+int ring_pop(struct ring_t *const ring, void *const record);
+
+#endif /* RING_H */
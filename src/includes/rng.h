@@ -0,0 +1,41 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * Number of normal variates generated in one batch.
+ */
+#define RNG_NORMALS 64
+
+/**
+ * The state of a reentrant random number generator. The generator is xoshiro256** by Blackman
+ * and Vigna. Every chain owns one, so that chains can draw random numbers concurrently and
+ * reproducibly. Independent streams are obtained with rng_stream, which jumps 2^128 steps ahead
+ * per stream.
+ */
+struct rng_t {
+    uint64_t s[4]; /** the 256-bit state of the generator */
+    double normals[RNG_NORMALS]; /** buffered normal variates */
+    int normal; /** the next unused buffered normal variate */
+};
+
+void rng_seed(struct rng_t *const rng, const long seed);
+
+void rng_jump(struct rng_t *const rng);
+
+void rng_longJump(struct rng_t *const rng);
+
+void rng_stream(struct rng_t *const rng, const struct rng_t *const base, const int stream);
+
+uint64_t rng_next(struct rng_t *const rng);
+
+double rng_uniform(struct rng_t *const rng);
+
+int rng_index(struct rng_t *const rng, const int number);
+
+double rng_normal(struct rng_t *const rng);
+
+void rng_normals(struct rng_t *const rng, double *const normals, const int count);
+
+#endif /* RNG_H */
@@ -1,10 +1,16 @@
 #ifndef SA_H
 #define SA_H
 
+#include "checkpoint.h"
 #include "global.h"
+#include "output.h"
+#include "points.h"
+#include "pool.h"
 #include "sphere.h"
 #include "vector.h"
+#include "workspace.h"
 #include "logging.h"
+#include "rng.h"
 
 
 /**
@@ -31,6 +37,97 @@
  */
 #define T_DAMPING 0.99
 
+/**
+ * Number of iterations after which the incrementally updated objective is recomputed over the
+ * whole configuration to bound the accumulated floating-point error.
+ */
+#define T_RESYNC 10000
+
+/**
+ * Default number of threads.
+ */
+#define T_THREADS 1
+
+/**
+ * Default number of replicas. One replica runs plain simulated annealing.
+ */
+#define T_REPLICAS 1
+
+/**
+ * Default cutoff radius of the approximate energy. Zero selects the exact energy.
+ */
+#define T_CUTOFF 0.0
+
+/**
+ * Default opening angle of the tree evaluation. Zero selects the exact evaluation.
+ */
+#define T_THETA 0.0
+
+/**
+ * Default accuracy target of the tree evaluation. Zero keeps the given opening angle.
+ */
+#define T_ACCURACY 0.0
+
+/**
+ * Default sampling rate of the trace. Every proposal is traced.
+ */
+#define T_SAMPLING 1
+
+/**
+ * Default interval between two checkpoints in seconds.
+ */
+#define T_CHECKPOINT 600.0
+
+/**
+ * Default initial acceptance ratio the initial temperature is estimated for. The initial
+ * temperature is T_INITIAL.
+ */
+#define T_INITIAL_ACCEPTANCE 0.0
+
+/**
+ * Number of sampled moves of the estimate of the initial temperature.
+ */
+#define T_SAMPLES 500
+
+/**
+ * Step by which the closeness annealer moves the closest pair apart, in multiples of their
+ * distance.
+ */
+#define T_APART 0.01
+
+/**
+ * Default target acceptance ratio of the adaptive step size. The step size follows the fixed
+ * schedule.
+ */
+#define T_ACCEPTANCE 0.0
+
+/**
+ * Default number of levels without improvement before the annealing stops. The annealing runs
+ * until the minimum temperature.
+ */
+#define T_PATIENCE 0
+
+/**
+ * Default relative improvement below which a level counts as without improvement.
+ */
+#define T_PLATEAU 0.0
+
+/**
+ * Default number of candidates of a proposal. Every proposal is a single random walk.
+ */
+#define T_TRIES 1
+
+/**
+ * Default number of points proposed per speculative round. The proposals are sequential.
+ */
+#define T_SPECULATIVE 1
+
+/**
+ * Default maximum number of iterations of the gradient descent polishing the best configuration.
+ * The best configuration of the annealing is reported as is.
+ */
+#define T_POLISH 0
+
 /**
  * Boltzmann constant
  */
@@ -39,8 +136,26 @@
 
 
 
-void sa_energy(struct vector_t *transmitters, const struct globalArgs_t const* globalArgs);
-void sa_distance(struct vector_t *transmitters, const struct globalArgs_t const* globalArgs);
-void sa_closeness(struct vector_t *transmitters, const struct globalArgs_t const* globalArgs);
+void anneal(double *temperature, double damping);
+
+double sa_initialTemperature(const struct vector_t *const points,
+                             const struct globalArgs_t *const globalArgs,
+                             const struct rng_t *const rng);
+
+double sa_openingAngle(struct pool_t *const pool, const struct points_t *const store,
+                       const struct globalArgs_t *const globalArgs);
+
+void sa_polish(struct pool_t *const pool, struct vector_t *const best_points,
+               const struct globalArgs_t *const globalArgs);
+
+int sa_energy(struct vector_t *transmitters, const struct globalArgs_t const* globalArgs,
+              struct rng_t *const rng, const struct checkpoint_t *const resume,
+              struct workspace_t *const workspace, const struct output_t *const output);
+int sa_distance(struct vector_t *transmitters, const struct globalArgs_t const* globalArgs,
+                struct rng_t *const rng, const struct checkpoint_t *const resume,
+                struct workspace_t *const workspace, const struct output_t *const output);
+int sa_closeness(struct vector_t *transmitters, const struct globalArgs_t const* globalArgs,
+                 struct rng_t *const rng, const struct checkpoint_t *const resume,
+                 struct workspace_t *const workspace, const struct output_t *const output);
 
 #endif /* SA_H */
@@ -0,0 +1,47 @@
+#ifndef SASPHERE_H
+#define SASPHERE_H
+
+#include "checkpoint.h"
+#include "global.h"
+#include "output.h"
+#include "rng.h"
+#include "vector.h"
+#include "warm.h"
+#include "workspace.h"
+
+/**
+ * Default number of points to be distributed.
+ */
+#define SASPHERE_POINTS 50
+
+/**
+ * Default random seed.
+ */
+#define SASPHERE_SEED 751339078
+
+/**
+ * The context of the runs of the libsasphere library. It holds the parameters, the random number
+ * generator, the workspace, and the output of the runs. Contexts do not share any state, so
+ * independent runs may be carried out by different threads of one process, one context each.
+ * The runs of one context draw from its random number generator one after the other, and reuse
+ * its workspace.
+ */
+struct sasphere_t;
+
+void sasphere_defaults(struct globalArgs_t *const args);
+
+struct sasphere_t *sasphere_create(const struct globalArgs_t *const args,
+                                   const struct output_t *const output);
+
+void sasphere_destroy(struct sasphere_t *sasphere);
+
+void sasphere_seed(struct sasphere_t *const sasphere, const struct rng_t *const rng);
+
+void sasphere_warm(struct sasphere_t *const sasphere, const struct warm_t *const warm);
+
+const struct workspace_t *sasphere_workspace(const struct sasphere_t *const sasphere);
+
+int sasphere_run(struct sasphere_t *const sasphere, const struct checkpoint_t *const resume,
+                 struct vector_t *const points);
+
+#endif /* SASPHERE_H */
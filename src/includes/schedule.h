@@ -0,0 +1,52 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "global.h"
+
+/**
+ * Bounds of the exponent of the damping factor of the adaptive schedule. A level cools at most
+ * twice and at least half as fast as with the geometric schedule.
+ */
+#define SCHEDULE_EXPONENT_MIN 0.5
+#define SCHEDULE_EXPONENT_MAX 2.0
+
+/**
+ * Number of levels without improvement after which the reheating schedule reheats.
+ */
+#define SCHEDULE_STAGNATION 50
+
+/**
+ * Maximum number of reheats.
+ */
+#define SCHEDULE_REHEATS 3
+
+/**
+ * Factor of the temperature of the last improvement the reheating schedule reheats to.
+ */
+#define SCHEDULE_REHEAT_FACTOR 4.0
+
+/**
+ * The state of a cooling schedule. It is plain data, so that it can be checkpointed.
+ */
+struct schedule_t {
+    long level; /** number of completed levels */
+    long stagnant; /** number of levels since the best objective improved */
+    int reheats; /** number of reheats so far */
+    int sense; /** 1, if the objective is maximised, -1 if it is minimised */
+    double best; /** the best objective at the last improvement */
+    double improved; /** the temperature of the last improvement */
+
+    /* the running statistics of the objective of the current level */
+    long n; /** number of proposals */
+    double mean; /** the mean of the objective */
+    double m2; /** the sum of the squared deviations from the mean */
+};
+
+void schedule_init(struct schedule_t *const schedule, const int sense, const double best);
+
+void schedule_observe(struct schedule_t *const schedule, const double objective);
+
+double schedule_next(struct schedule_t *const schedule, const struct globalArgs_t *const globalArgs,
+                     const double temperature, const double best);
+
+#endif /* SCHEDULE_H */
@@ -0,0 +1,30 @@
+#ifndef SPEC_H
+#define SPEC_H
+
+#include "global.h"
+#include "points.h"
+#include "pool.h"
+#include "rng.h"
+#include "vector.h"
+
+/**
+ * Speculative proposals of distinct points, scored in parallel against the configuration at the
+ * start of a round and committed one after the other.
+ */
+struct spec_t;
+
+struct spec_t *spec_create(const int size, const int n, const enum objective_t objective);
+
+void spec_destroy(struct spec_t *spec);
+
+int spec_size(const struct spec_t *const spec);
+
+void spec_round(struct spec_t *const spec, struct pool_t *const pool,
+                const struct points_t *const store, const struct vector_t *const points,
+                const double variance, struct rng_t *const rng, const int count);
+
+double spec_next(struct spec_t *const spec, int *index, struct vector_t *const proposal);
+
+void spec_commit(struct spec_t *const spec);
+
+#endif /* SPEC_H */
@@ -1,6 +1,7 @@
 #ifndef SPHERE_H
 #define SPHERE_H
 
+#include "rng.h"
 #include "vector.h"
 
 /**
@@ -10,14 +11,16 @@
 
 
 
-void sphere_initialiseUniformPoints(struct vector_t *const transmitters, const int numberTrans);
-void sphere_initialiseCluster(struct vector_t *const transmitters, const int numberTrans);
+void sphere_initialiseUniformPoints(struct vector_t *const transmitters, const int numberTrans, struct rng_t *const rng);
+void sphere_initialiseCluster(struct vector_t *const transmitters, const int numberTrans, struct rng_t *const rng);
 double sphere_rieszEnergy(const struct vector_t *const transmitters, const int numberTrans);
+double sphere_rieszEnergy2(const struct vector_t *const transmitters, const int numberTrans, const int index);
 double sphere_distance(const struct vector_t *const transmitters, const int numberTrans);
 double sphere_distance2(const struct vector_t *const transmitters, const int numberTrans, const int index);
-struct vector_t sphere_getPoint();
+double euclideanDistance(const struct vector_t *const pointA, const struct vector_t *const pointB);
+struct vector_t sphere_getPoint(struct rng_t *const rng);
 void sphere_selectClosest(struct vector_t *const transmitters, const int numberTrans, int* index_mim);
-struct vector_t sphere_walk(const struct vector_t *const transmitter, const double variance);
+struct vector_t sphere_walk(const struct vector_t *const transmitter, const double variance, struct rng_t *const rng);
 void sphere_moveApart(struct vector_t *const transmitterA, struct vector_t *const transmitterB, const double variance);
 
 
@@ -0,0 +1,106 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Magic bytes at the beginning of a trace file.
+ */
+#define TRACE_MAGIC "SATRACE"
+
+/**
+ * Version of the trace format.
+ */
+#define TRACE_VERSION 1
+
+/**
+ * Number of records buffered in a block before it is written.
+ */
+#define TRACE_BLOCK 4096
+
+/**
+ * The kind of records in a trace file.
+ */
+enum trace_kind_t {
+    TRACE_SAMPLES, /** every k-th proposal */
+    TRACE_LEVELS /** one aggregate per temperature level */
+};
+
+/**
+ * The header of a trace file. It is followed by blocks, each of which starts with the number of
+ * records as uint32_t and holds the columns of its records one after the other.
+ *
+ * A block of samples has the columns iteration (int64_t), objective, delta, temperature, and
+ * variance (double), and accepted (uint8_t).
+ *
+ * A block of levels has the columns level and iteration (int64_t), temperature, variance, mean,
+ * min, max, and standard deviation of the objective, acceptance ratio, and elapsed seconds
+ * (double).
+ */
+struct trace_header_t {
+    char magic[8]; /** TRACE_MAGIC */
+    uint32_t version; /** TRACE_VERSION */
+    uint32_t kind; /** the kind of the records */
+    uint32_t sampling; /** the sampling rate of the samples */
+    uint32_t reserved; /** zero */
+};
+
+/**
+ * The aggregate of a temperature level, a record of a trace of levels.
+ */
+struct trace_level_t {
+    int64_t level; /** the number of the level */
+    int64_t iteration; /** the last iteration of the level */
+    double temperature; /** the temperature */
+    double variance; /** the variance of the random walk */
+    double mean; /** the mean of the objective */
+    double min; /** the minimum of the objective */
+    double max; /** the maximum of the objective */
+    double std; /** the standard deviation of the objective */
+    double acceptance; /** the acceptance ratio */
+    double seconds; /** the seconds the level took */
+};
+
+/**
+ * The running aggregate of the current temperature level. It is kept by the annealing thread,
+ * so that only the completed levels are handed to the writer and the seconds of a level are the
+ * ones the annealing took.
+ */
+struct trace_aggregate_t {
+    long levels; /** number of completed levels */
+    long n; /** number of proposals of the level */
+    long last; /** the last iteration of the level */
+    double t; /** the temperature of the level */
+    double v; /** the variance of the random walk of the level */
+    double m; /** the mean of the objective */
+    double m2; /** the sum of the squared deviations from the mean */
+    double lo; /** the minimum of the objective */
+    double hi; /** the maximum of the objective */
+    long a; /** number of accepted proposals */
+    struct timespec start; /** the start of the level */
+};
+
+/**
+ * A trace of the simulation.
+ */
+struct trace_t;
+
+struct trace_t *trace_open(const char *const file, const int sampling);
+
+void trace_close(struct trace_t *trace);
+
+void trace_sample(struct trace_t *const trace, const long iteration, const double objective,
+                  const double delta, const double temperature, const double variance,
+                  const int accepted);
+
+void trace_level(struct trace_t *const trace, const struct trace_level_t *const level);
+
+int trace_aggregate(struct trace_aggregate_t *const aggregate, const long iteration,
+                    const double objective, const double temperature, const double variance,
+                    const int accepted, struct trace_level_t *const level);
+
+int trace_finish(struct trace_aggregate_t *const aggregate, struct trace_level_t *const level);
+
+#endif /* TRACE_H */
@@ -0,0 +1,49 @@
+#ifndef TREE_H
+#define TREE_H
+
+#include "global.h"
+#include "points.h"
+#include "pool.h"
+
+/**
+ * Maximum number of points in a leaf of the octree.
+ */
+#define TREE_LEAF 16
+
+/**
+ * Number of subtrees the octree is split into for the parallel construction.
+ */
+#define TREE_TASKS 64
+
+/**
+ * Number of tiles the points are split into for the parallel traversal. As in eval.c, the
+ * partial sums are reduced in tile order, so the results do not depend on the number of threads.
+ */
+#define TREE_TILES 256
+
+/**
+ * Number of points whose contributions are compared against the exact ones when the opening
+ * angle is tuned for an accuracy target.
+ */
+#define TREE_SAMPLES 64
+
+/**
+ * Opening angle the tuning starts from, if none is given.
+ */
+#define TREE_THETA 0.5
+
+/**
+ * Smallest opening angle the tuning goes down to.
+ */
+#define TREE_THETA_MIN 0.05
+
+double tree_distance(struct pool_t *const pool, const struct points_t *const points,
+                     const double theta);
+
+double tree_energy(struct pool_t *const pool, const struct points_t *const points,
+                   const double theta);
+
+double tree_tune(struct pool_t *const pool, const struct points_t *const points,
+                 const enum objective_t objective, const double theta, const double target);
+
+#endif /* TREE_H */
@@ -0,0 +1,35 @@
+#ifndef VERLET_H
+#define VERLET_H
+
+#include "points.h"
+#include "vector.h"
+
+/**
+ * The skin of the neighbour lists as a fraction of the cutoff radius. A point's list is only
+ * rebuilt once the point moved more than half the skin away from where the list was built.
+ */
+#define VERLET_SKIN 0.5
+
+/**
+ * Cutoff neighbour lists for an approximation of the logarithmic Riesz energy. Pairs closer
+ * than the cutoff radius are summed exactly, while the remaining pairs are replaced by their
+ * mean-field value for points spread uniformly over the sphere.
+ */
+struct verlet_t;
+
+struct verlet_t *verlet_create(const struct points_t *const points, const double cutoff);
+
+void verlet_destroy(struct verlet_t *verlet);
+
+void verlet_move(struct verlet_t *const verlet, const int index);
+
+double verlet_energy(const struct verlet_t *const verlet);
+
+double verlet_energyTo(const struct verlet_t *const verlet, const int index,
+                       const struct vector_t *const point);
+
+double verlet_farField(const int n, const double cutoff);
+
+long verlet_rebuilds(const struct verlet_t *const verlet);
+
+#endif /* VERLET_H */
@@ -0,0 +1,37 @@
+#ifndef WARM_H
+#define WARM_H
+
+#include "checkpoint.h"
+#include "rng.h"
+#include "vector.h"
+
+/**
+ * Initial temperature of a run starting from a given configuration, unless a temperature is
+ * given. The random walk is short at that temperature, so the run refines the configuration
+ * instead of melting it.
+ */
+#define WARM_TEMPERATURE 1.0
+
+/**
+ * Number of random candidates a point added to a configuration is picked from.
+ */
+#define WARM_CANDIDATES 64
+
+/**
+ * A configuration a run starts from, read from the best configuration of a previous run or
+ * mapped from a checkpoint.
+ */
+struct warm_t {
+    struct vector_t *points; /** the points of the configuration */
+    int n; /** number of points */
+    struct checkpoint_t checkpoint; /** the checkpoint the points are mapped from */
+};
+
+int warm_load(const char *const file, struct warm_t *const warm);
+
+void warm_release(struct warm_t *const warm);
+
+int warm_fit(struct vector_t *const points, const int n, const struct warm_t *const warm,
+             struct rng_t *const rng);
+
+#endif /* WARM_H */
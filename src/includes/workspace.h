@@ -0,0 +1,35 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <stddef.h>
+
+/**
+ * Alignment in bytes of the buffers of a workspace, matching the point store.
+ */
+#define WORKSPACE_ALIGNMENT 64
+
+/**
+ * Smallest size in bytes of a block of a workspace.
+ */
+#define WORKSPACE_BLOCK (1 << 20)
+
+/**
+ * An arena of aligned buffers for the configurations of a run. The buffers are allocated once
+ * before the annealing and released all at once, so that the workspace can be reused by the
+ * next run without returning its memory to the system.
+ */
+struct workspace_t;
+
+struct workspace_t *workspace_create();
+
+void workspace_destroy(struct workspace_t *workspace);
+
+void *workspace_alloc(struct workspace_t *const workspace, const size_t bytes);
+
+void workspace_reset(struct workspace_t *const workspace);
+
+size_t workspace_peak(const struct workspace_t *const workspace);
+
+size_t workspace_reserved(const struct workspace_t *const workspace);
+
+#endif /* WORKSPACE_H */